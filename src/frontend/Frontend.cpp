@@ -10,6 +10,8 @@
 #include <string>
 
 #include "frontend/Frontend.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
 
 #include "argparse/argparse.hpp"
 #include "spdlog/spdlog.h"
@@ -31,6 +33,19 @@ hdoc::frontend::Frontend::Frontend(int argc, char** argv, hdoc::types::Config* c
   argparse::ArgumentParser program("hdoc", cfg->hdocVersion);
   program.add_argument("--verbose").help("Whether to use verbose output").default_value(false).implicit_value(true);
   program.add_argument("--oss").help("Show open source notices").default_value(false).implicit_value(true);
+  program.add_argument("--trace")
+      .help("Write a Chrome trace of where time is spent to the given file")
+      .default_value(std::string(""));
+  program.add_argument("--metrics")
+      .help("Write a JSON report of the time and memory used by each phase to the given file")
+      .default_value(std::string(""));
+  program.add_argument("--cost-report")
+      .help("Write the slowest TUs and the most expensive headers to the given file")
+      .default_value(std::string(""));
+  program.add_argument("--cost-report-size")
+      .help("Number of TUs and headers to include in the cost report")
+      .default_value(10U)
+      .scan<'u', uint32_t>();
 
   // Parse command line arguments
   try {
@@ -54,6 +69,20 @@ hdoc::frontend::Frontend::Frontend(int argc, char** argv, hdoc::types::Config* c
     spdlog::set_level(spdlog::level::warn);
   }
 
+  // Start tracing and collecting metrics as early as possible so that the rest of the Frontend is included
+  cfg->tracePath = program.get<std::string>("--trace");
+  if (!cfg->tracePath.empty()) {
+    hdoc::utils::TraceRecorder::global().enable();
+  }
+  cfg->metricsPath = program.get<std::string>("--metrics");
+  if (!cfg->metricsPath.empty()) {
+    hdoc::utils::Metrics::global().enable();
+    hdoc::utils::Metrics::global().startPhase("config");
+  }
+  cfg->costReportPath = program.get<std::string>("--cost-report");
+  cfg->costReportSize = program.get<uint32_t>("--cost-report-size");
+  hdoc::utils::TraceScope trace("Parse config");
+
   // Check that the current directory contains a .hdoc.toml file
   cfg->rootDir = std::filesystem::current_path();
   if (!std::filesystem::is_regular_file(cfg->rootDir / ".hdoc.toml")) {
@@ -132,6 +161,8 @@ hdoc::frontend::Frontend::Frontend(int argc, char** argv, hdoc::types::Config* c
   // Determine the compiler's builtin include paths and add them to the list
   cfg->useSystemIncludes = toml["includes"]["use_system_includes"].value_or(true);
   if (cfg->useSystemIncludes == true) {
+    hdoc::utils::TraceScope traceSystemIncludes("Detect system includes");
+
     llvm::SmallString<64> tempFile;
     if (const auto ec = llvm::sys::fs::createTemporaryFile("hdoc-system-includes-compiler-output", "", tempFile)) {
       spdlog::error("Unable to create temporary directory to store system includes: {}.", ec.message());
@@ -204,21 +235,92 @@ hdoc::frontend::Frontend::Frontend(int argc, char** argv, hdoc::types::Config* c
   }
 
   // Get substrings of paths that should be ignored
+  // They're compiled into a single matcher once, which is then shared by every thread
   if (const auto& ignores = toml["ignore"]["paths"].as_array()) {
+    std::vector<std::string> ignorePaths;
     for (const auto& i : *ignores) {
       std::string s = i.value_or(std::string(""));
       if (s == "") {
         spdlog::warn("An ignore directive from .hdoc.toml was malformed, ignoring it.");
         continue;
       }
-      cfg->ignorePaths.emplace_back(s);
+      ignorePaths.emplace_back(s);
     }
+    cfg->ignorePaths = hdoc::utils::PathMatcher(std::move(ignorePaths));
   }
 
   if (const toml::value<bool>* ignorePrivateMembers = toml["ignore"]["ignore_private_members"].as_boolean()) {
     cfg->ignorePrivateMembers = ignorePrivateMembers->get();
   }
 
+  // Relative cache directories are relative to the root directory, like every other path in .hdoc.toml
+  cfg->cacheDir = std::filesystem::path(toml["indexing"]["cache_dir"].value_or(""));
+  if (!cfg->cacheDir.empty()) {
+    cfg->cacheDir = cfg->rootDir / cfg->cacheDir;
+  }
+
+  if (const toml::value<bool>* sharedPCH = toml["indexing"]["shared_pch"].as_boolean()) {
+    cfg->sharedPCH = sharedPCH->get();
+  }
+
+  if (const toml::value<bool>* skipFunctionBodies = toml["indexing"]["skip_function_bodies"].as_boolean()) {
+    cfg->skipFunctionBodies = skipFunctionBodies->get();
+  }
+
+  if (const toml::value<bool>* headersOnly = toml["indexing"]["headers_only"].as_boolean()) {
+    cfg->headersOnly = headersOnly->get();
+  }
+
+  if (toml["indexing"]["headers_per_tu"].type() != toml::node_type::none) {
+    const toml::value<int64_t>* headersPerTU = toml["indexing"]["headers_per_tu"].as_integer();
+    if (headersPerTU == nullptr || headersPerTU->get() < 1) {
+      spdlog::error("Number of headers per TU in .hdoc.toml must be an integer greater than or equal to 1.");
+      return;
+    }
+    cfg->headersPerTU = headersPerTU->get();
+  }
+
+  if (const toml::value<bool>* minimalTUs = toml["indexing"]["minimal_tus"].as_boolean()) {
+    cfg->minimalTUs = minimalTUs->get();
+  }
+
+  if (const toml::value<bool>* checkSymbolIDs = toml["indexing"]["check_symbol_ids"].as_boolean()) {
+    cfg->checkSymbolIDs = checkSymbolIDs->get();
+  }
+
+  if (toml["indexing"]["memory_budget"].type() != toml::node_type::none) {
+    const toml::value<int64_t>* memoryBudget = toml["indexing"]["memory_budget"].as_integer();
+    if (memoryBudget == nullptr || memoryBudget->get() < 0) {
+      spdlog::error("Memory budget in .hdoc.toml must be an integer number of megabytes greater than or equal to 0.");
+      return;
+    }
+    cfg->memoryBudget = static_cast<uint64_t>(memoryBudget->get()) * 1'000'000;
+  }
+
+  if (toml["indexing"]["spill_threshold"].type() != toml::node_type::none) {
+    const toml::value<int64_t>* spillThreshold = toml["indexing"]["spill_threshold"].as_integer();
+    if (spillThreshold == nullptr || spillThreshold->get() < 0) {
+      spdlog::error("Spill threshold in .hdoc.toml must be an integer number of megabytes greater than or equal to 0.");
+      return;
+    }
+    cfg->spillThreshold = static_cast<uint64_t>(spillThreshold->get()) * 1'000'000;
+  }
+
+  cfg->spillDir = std::filesystem::path(toml["indexing"]["spill_dir"].value_or(""));
+  if (!cfg->spillDir.empty()) {
+    cfg->spillDir = cfg->rootDir / cfg->spillDir;
+  }
+
+  const std::string engine = toml["indexing"]["engine"].value_or("matchers");
+  if (engine == "matchers") {
+    cfg->engine = hdoc::types::IndexingEngine::Matchers;
+  } else if (engine == "visitor") {
+    cfg->engine = hdoc::types::IndexingEngine::Visitor;
+  } else {
+    spdlog::error("Indexing engine in .hdoc.toml must be either \"matchers\" or \"visitor\", not \"{}\".", engine);
+    return;
+  }
+
   if (const toml::value<bool>* debugDumpJSONPayload = toml["debug"]["dump_json_payload"].as_boolean()) {
     cfg->debugDumpJSONPayload = debugDumpJSONPayload->get();
   }
@@ -266,10 +368,47 @@ hdoc::frontend::Frontend::Frontend(int argc, char** argv, hdoc::types::Config* c
   spdlog::info("Project version: {}", cfg->projectVersion);
   spdlog::info("Indexing using {} threads",
                cfg->numThreads == 0 ? std::string("all") : std::to_string(cfg->numThreads));
+  if (!cfg->cacheDir.empty()) {
+    spdlog::info("Caching index in {}", cfg->cacheDir.string());
+  }
+  if (cfg->sharedPCH) {
+    spdlog::info("Using shared precompiled headers");
+  }
+  if (cfg->skipFunctionBodies) {
+    spdlog::info("Skipping function bodies");
+  }
+  if (cfg->minimalTUs) {
+    spdlog::info("Only indexing the TUs needed to cover every project header");
+  }
+  if (cfg->checkSymbolIDs) {
+    spdlog::info("Checking SymbolIDs for collisions");
+  }
+  if (cfg->headersOnly) {
+    spdlog::info("Indexing headers instead of source files, with up to {} headers per TU", cfg->headersPerTU);
+  }
+  if (cfg->memoryBudget > 0) {
+    spdlog::info("Only starting TUs while the memory used stays under {} MB", cfg->memoryBudget / 1'000'000);
+  }
+  if (cfg->spillThreshold > 0) {
+    spdlog::info("Spilling indexed symbols to {} once more than {} MB of memory is used",
+                 cfg->spillDir.empty() ? "the temporary directory" : cfg->spillDir.string(),
+                 cfg->spillThreshold / 1'000'000);
+  }
+  spdlog::info("Indexing using the {} engine",
+               cfg->engine == hdoc::types::IndexingEngine::Visitor ? "RecursiveASTVisitor" : "ASTMatchers");
   if (cfg->debugLimitNumIndexedFiles > 0) {
     spdlog::info("Only indexing {} files ", std::to_string(cfg->debugLimitNumIndexedFiles));
   }
   if (cfg->debugDumpJSONPayload) {
     spdlog::info("Dumping JSON payload to ./hdoc-payload.json");
   }
+  if (!cfg->tracePath.empty()) {
+    spdlog::info("Writing a trace of the run to {}", cfg->tracePath.string());
+  }
+  if (!cfg->metricsPath.empty()) {
+    spdlog::info("Writing metrics of the run to {}", cfg->metricsPath.string());
+  }
+  if (!cfg->costReportPath.empty()) {
+    spdlog::info("Writing the {} slowest TUs and headers to {}", cfg->costReportSize, cfg->costReportPath.string());
+  }
 }
@@ -1,14 +1,18 @@
 // Copyright 2019-2023 hdoc
 // SPDX-License-Identifier: AGPL-3.0-only
 
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
 
 #include "frontend/Frontend.hpp"
 #include "indexer/Indexer.hpp"
-#include "serde/SerdeUtils.hpp"
 #include "serde/Serialization.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
 
 int main(int argc, char** argv) {
   // Print stack trace on failure
@@ -28,26 +32,45 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  auto&                  metrics = hdoc::utils::Metrics::global();
   llvm::ThreadPool       pool(llvm::hardware_concurrency(cfg.numThreads));
   hdoc::indexer::Indexer indexer(&cfg, pool);
+  metrics.startPhase("index");
   indexer.run();
-  indexer.pruneMethods();
-  indexer.pruneTypeRefs();
-  indexer.resolveNamespaces();
-  indexer.updateRecordNames();
+  metrics.startPhase("post-process");
+  indexer.postProcess();
   indexer.printStats();
-  const hdoc::types::Index* index = indexer.dump();
+  metrics.startPhase("freeze");
+  const hdoc::types::FrozenIndex index = indexer.freeze();
 
-  const std::string data = hdoc::serde::serializeToJSON(*index, cfg);
-  hdoc::serde::uploadDocs(data);
-
-  // Ensure that cfg was properly initialized
-  if (cfg.debugDumpJSONPayload) {
-    bool res = dumpJSONPayload(data);
-    if (res == false) {
+  // The payload is streamed to a file instead of being built in memory, which is kept if it's being dumped
+  metrics.startPhase("json");
+  llvm::SmallString<128> payloadPath("hdoc-payload.json");
+  if (!cfg.debugDumpJSONPayload) {
+    if (const auto ec = llvm::sys::fs::createTemporaryFile("hdoc-payload", "json", payloadPath)) {
+      spdlog::error("Unable to create a temporary file for the JSON payload ({}). Aborting.", ec.message());
       return EXIT_FAILURE;
     }
   }
+  if (!hdoc::serde::serializeToJSON(index, cfg, payloadPath.str().str())) {
+    return EXIT_FAILURE;
+  }
+  metrics.startPhase("upload");
+  hdoc::serde::uploadDocs(payloadPath.str().str());
+  metrics.endPhase();
+
+  if (cfg.debugDumpJSONPayload) {
+    spdlog::info("hdoc-payload.json successfully written to current working directory.");
+  } else {
+    llvm::sys::fs::remove(payloadPath);
+  }
+
+  if (!cfg.tracePath.empty() && !hdoc::utils::TraceRecorder::global().write(cfg.tracePath)) {
+    spdlog::error("Failed to write trace to {}", cfg.tracePath.string());
+  }
+  if (!cfg.metricsPath.empty() && !metrics.write(cfg.metricsPath)) {
+    spdlog::error("Failed to write metrics to {}", cfg.metricsPath.string());
+  }
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,232 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/IndexAction.hpp"
+#include "indexer/IndexVisitor.hpp"
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(const Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+namespace {
+/// @brief Runs the IndexVisitor over the translation unit
+class IndexVisitorConsumer : public clang::ASTConsumer {
+public:
+  IndexVisitorConsumer(hdoc::indexer::IndexVisitor visitor) : visitor(std::move(visitor)) {}
+
+  void HandleTranslationUnit(clang::ASTContext& astContext) override {
+    this->visitor.TraverseAST(astContext);
+  }
+
+private:
+  hdoc::indexer::IndexVisitor visitor;
+};
+
+/// @brief Restricts the AST traversal of the matchers to the decls in files owned by the TU.
+/// Decls in files that were claimed by other TUs would be skipped by the matchers anyway, so not traversing them
+/// at all saves the cost of running the matchers over them.
+class ClaimedFilesConsumer : public clang::ASTConsumer {
+public:
+  ClaimedFilesConsumer(std::unique_ptr<clang::ASTConsumer> consumer, hdoc::indexer::TUContext* ctx)
+      : consumer(std::move(consumer)), ctx(ctx) {}
+
+  void HandleTranslationUnit(clang::ASTContext& astContext) override {
+    std::vector<clang::Decl*> scope;
+    const bool                ownsEverything = this->collectOwnedDecls(astContext.getTranslationUnitDecl(), scope);
+    // Leave the default scope in place if nothing is skipped, it's cheaper to traverse
+    if (!ownsEverything) {
+      astContext.setTraversalScope(scope);
+    }
+    this->consumer->HandleTranslationUnit(astContext);
+  }
+
+private:
+  /// Adds the owned decls in dc to scope. Namespaces and linkage specs can contain #includes, so unowned ones are
+  /// searched for owned decls. Returns true if every decl in dc is owned.
+  bool collectOwnedDecls(clang::DeclContext* dc, std::vector<clang::Decl*>& scope) {
+    bool ownsEverything = true;
+    for (clang::Decl* d : dc->decls()) {
+      if (this->ctx->owns(d)) {
+        scope.emplace_back(d);
+        continue;
+      }
+      ownsEverything = false;
+      if (llvm::isa<clang::NamespaceDecl, clang::LinkageSpecDecl>(d)) {
+        this->collectOwnedDecls(llvm::cast<clang::DeclContext>(d), scope);
+      }
+    }
+    return ownsEverything;
+  }
+
+  std::unique_ptr<clang::ASTConsumer> consumer;
+  hdoc::indexer::TUContext*           ctx;
+};
+
+/// @brief Measures how long it took to parse the TU and how long the wrapped consumer takes to index it.
+/// The AST is complete when HandleTranslationUnit is called, so everything before it is parsing.
+class TimedConsumer : public clang::ASTConsumer {
+public:
+  TimedConsumer(std::unique_ptr<clang::ASTConsumer> consumer,
+                const Clock::time_point             start,
+                hdoc::indexer::TUCost*              cost)
+      : consumer(std::move(consumer)), start(start), cost(cost) {}
+
+  void HandleTranslationUnit(clang::ASTContext& astContext) override {
+    const auto matchStart = Clock::now();
+    this->cost->parseTime += std::chrono::duration<double, std::milli>(matchStart - this->start).count();
+    this->consumer->HandleTranslationUnit(astContext);
+    this->cost->matchTime += msSince(matchStart);
+  }
+
+private:
+  std::unique_ptr<clang::ASTConsumer> consumer;
+  Clock::time_point                   start;
+  hdoc::indexer::TUCost*              cost;
+};
+
+/// @brief Adds the time spent between entering and leaving each header to headers.
+/// The time of a header includes the headers it includes, like the "Source" events of clang's -ftime-trace.
+class HeaderTimer : public clang::PPCallbacks {
+public:
+  HeaderTimer(const clang::SourceManager& sourceManager, llvm::StringMap<double>& headers)
+      : sourceManager(sourceManager), headers(headers) {}
+
+  void FileChanged(clang::SourceLocation loc,
+                   FileChangeReason      reason,
+                   clang::SrcMgr::CharacteristicKind,
+                   clang::FileID) override {
+    if (reason == EnterFile) {
+      // Buffers that aren't files, like <built-in>, are kept on the stack so that it stays balanced
+      this->stack.emplace_back(this->sourceManager.getFileEntryForID(this->sourceManager.getFileID(loc)), Clock::now());
+    } else if (reason == ExitFile && !this->stack.empty()) {
+      const auto [file, start] = this->stack.back();
+      this->stack.pop_back();
+      if (file != nullptr) {
+        this->headers[file->getName()] += msSince(start);
+      }
+    }
+  }
+
+private:
+  const clang::SourceManager&                                         sourceManager;
+  llvm::StringMap<double>&                                            headers;
+  std::vector<std::pair<const clang::FileEntry*, Clock::time_point>> stack; ///< Files that are being parsed
+};
+} // namespace
+
+hdoc::indexer::IndexAction::IndexAction(hdoc::types::Index*         index,
+                                        const hdoc::types::Config*  cfg,
+                                        hdoc::indexer::FileClaims*  claims,
+                                        hdoc::types::IndexClaims*   symbolClaims,
+                                        std::vector<std::string>*   dependencies,
+                                        hdoc::types::SymbolIDTable* symbolIDs,
+                                        hdoc::indexer::TUCost*      cost,
+                                        const bool                  timeHeaders,
+                                        const uint32_t              claimant)
+    : index(index), cfg(cfg), ctx(cfg, claims, symbolClaims, symbolIDs, claimant), functionFinder(index, cfg, &ctx),
+      recordFinder(index, cfg, &ctx), enumFinder(index, cfg, &ctx), namespaceFinder(index, cfg, &ctx), claims(claims),
+      dependencies(dependencies), cost(cost), timeHeaders(timeHeaders) {
+  if (cfg->engine == hdoc::types::IndexingEngine::Matchers) {
+    this->finder.addMatcher(this->functionFinder.getMatcher(), &this->functionFinder);
+    this->finder.addMatcher(this->recordFinder.getMatcher(), &this->recordFinder);
+    this->finder.addMatcher(this->enumFinder.getMatcher(), &this->enumFinder);
+    this->finder.addMatcher(this->namespaceFinder.getMatcher(), &this->namespaceFinder);
+  }
+}
+
+bool hdoc::indexer::IndexAction::BeginInvocation(clang::CompilerInstance& CI) {
+  // hdoc only documents declarations, so the bodies of functions don't need to be parsed, which also avoids
+  // instantiating every template that is used inside of them. Clang always parses the bodies of constexpr
+  // functions and functions with deduced return types since they are needed to understand the rest of the TU,
+  // and default arguments and variable initializers are part of the declaration, so they are still available.
+  if (this->cfg->skipFunctionBodies) {
+    CI.getFrontendOpts().SkipFunctionBodies = true;
+  }
+  return clang::ASTFrontendAction::BeginInvocation(CI);
+}
+
+bool hdoc::indexer::IndexAction::BeginSourceFileAction(clang::CompilerInstance& CI) {
+  this->start             = Clock::now();
+  this->numMatchesAtStart = {this->index->functions.numMatches,
+                             this->index->records.numMatches,
+                             this->index->enums.numMatches,
+                             this->index->namespaces.numMatches};
+  if (this->cost != nullptr && this->timeHeaders) {
+    CI.getPreprocessor().addPPCallbacks(std::make_unique<HeaderTimer>(CI.getSourceManager(), this->cost->headers));
+  }
+  return clang::ASTFrontendAction::BeginSourceFileAction(CI);
+}
+
+std::unique_ptr<clang::ASTConsumer> hdoc::indexer::IndexAction::CreateASTConsumer(clang::CompilerInstance&,
+                                                                                   llvm::StringRef) {
+  std::unique_ptr<clang::ASTConsumer> consumer;
+  if (this->cfg->engine == hdoc::types::IndexingEngine::Visitor) {
+    consumer = std::make_unique<IndexVisitorConsumer>(hdoc::indexer::IndexVisitor(
+        this->functionFinder, this->recordFinder, this->enumFinder, this->namespaceFinder, this->cfg));
+  } else {
+    consumer = this->finder.newASTConsumer();
+  }
+
+  if (this->claims != nullptr) {
+    consumer = std::make_unique<ClaimedFilesConsumer>(std::move(consumer), &this->ctx);
+  }
+  if (this->cost != nullptr) {
+    consumer = std::make_unique<TimedConsumer>(std::move(consumer), this->start, this->cost);
+  }
+  return consumer;
+}
+
+void hdoc::indexer::collectDependencies(const clang::SourceManager& sourceManager,
+                                        std::vector<std::string>&   dependencies) {
+  // Every file that was entered while parsing a TU has a content cache in the SourceManager
+  for (auto it = sourceManager.fileinfo_begin(); it != sourceManager.fileinfo_end(); ++it) {
+    const clang::FileEntry* fileEntry = it->first;
+    if (fileEntry == nullptr) {
+      continue;
+    }
+
+    llvm::SmallString<256> path(fileEntry->tryGetRealPathName());
+    if (path.empty()) {
+      path = fileEntry->getName();
+      sourceManager.getFileManager().makeAbsolutePath(path);
+    }
+    dependencies.emplace_back(path.str());
+  }
+}
+
+void hdoc::indexer::IndexAction::EndSourceFileAction() {
+  this->index->numIDLookups += this->ctx.numIDLookups;
+  this->index->numIDCacheHits += this->ctx.numIDCacheHits;
+  if (this->dependencies != nullptr) {
+    collectDependencies(this->getCompilerInstance().getSourceManager(), *this->dependencies);
+  }
+  if (this->cost != nullptr) {
+    this->cost->numFunctions += this->index->functions.numMatches - this->numMatchesAtStart[0];
+    this->cost->numRecords += this->index->records.numMatches - this->numMatchesAtStart[1];
+    this->cost->numEnums += this->index->enums.numMatches - this->numMatchesAtStart[2];
+    this->cost->numNamespaces += this->index->namespaces.numMatches - this->numMatchesAtStart[3];
+
+    // Source files are shared between TUs by the file system cache, so only the memory that belongs to this TU is
+    // counted. The AST is still alive at this point, so this is close to the TU's peak.
+    const clang::CompilerInstance& CI     = this->getCompilerInstance();
+    uint64_t                       memory = CI.getSourceManager().getDataStructureSizes();
+    if (CI.hasPreprocessor()) {
+      memory += CI.getPreprocessor().getTotalMemory();
+    }
+    if (CI.hasASTContext()) {
+      memory += CI.getASTContext().getASTAllocatedMemory() + CI.getASTContext().getSideTableAllocatedMemory();
+    }
+    this->cost->memory = std::max(this->cost->memory, memory);
+  }
+}
@@ -0,0 +1,111 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "indexer/Matchers.hpp"
+#include "indexer/TUContext.hpp"
+#include "support/CostReport.hpp"
+#include "types/Config.hpp"
+#include "types/Index.hpp"
+
+namespace hdoc::indexer {
+/// @brief Append the absolute path of every file that was read by the SourceManager to dependencies
+void collectDependencies(const clang::SourceManager& sourceManager, std::vector<std::string>& dependencies);
+
+/// @brief Frontend action that indexes a single translation unit into an Index.
+/// Each action owns its own set of matchers, so state that is specific to a translation unit never leaks
+/// between TUs that are indexed concurrently.
+class IndexAction : public clang::ASTFrontendAction {
+public:
+  /// If claims is not null, only decls in files that are claimed by this translation unit are indexed.
+  /// If symbolClaims is not null, only symbols that are claimed by this translation unit are indexed.
+  /// If dependencies is not null, it is filled with the absolute path of every file that was
+  /// read while parsing the translation unit, including the main file.
+  /// If symbolIDs is not null, the SymbolID of every indexed symbol is checked for collisions.
+  /// If cost is not null, it is filled with the time spent parsing and matching the translation unit and the memory
+  /// that clang used for it, and also with the time spent parsing each header if timeHeaders is true.
+  /// If claimant is not 0, files are claimed under it rather than under a new claimant, so that a TU that's parsed
+  /// again still owns the files that it claimed the first time.
+  IndexAction(hdoc::types::Index*         index,
+              const hdoc::types::Config*  cfg,
+              hdoc::indexer::FileClaims*  claims       = nullptr,
+              hdoc::types::IndexClaims*   symbolClaims = nullptr,
+              std::vector<std::string>*   dependencies = nullptr,
+              hdoc::types::SymbolIDTable* symbolIDs    = nullptr,
+              hdoc::indexer::TUCost*      cost         = nullptr,
+              const bool                  timeHeaders  = false,
+              const uint32_t              claimant     = 0);
+
+protected:
+  bool                                BeginInvocation(clang::CompilerInstance& CI) override;
+  bool                                BeginSourceFileAction(clang::CompilerInstance& CI) override;
+  std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance& CI, llvm::StringRef inFile) override;
+  void                                EndSourceFileAction() override;
+
+private:
+  hdoc::types::Index*                       index;
+  const hdoc::types::Config*                cfg;
+  hdoc::indexer::TUContext                  ctx;
+  hdoc::indexer::matchers::FunctionMatcher  functionFinder;
+  hdoc::indexer::matchers::RecordMatcher    recordFinder;
+  hdoc::indexer::matchers::EnumMatcher      enumFinder;
+  hdoc::indexer::matchers::NamespaceMatcher namespaceFinder;
+  clang::ast_matchers::MatchFinder          finder;
+  hdoc::indexer::FileClaims*                claims;
+  std::vector<std::string>*                 dependencies;
+  hdoc::indexer::TUCost*                    cost;
+  bool                                      timeHeaders;
+  std::chrono::steady_clock::time_point     start;             ///< When the TU started being parsed
+  std::array<uint32_t, 4>                   numMatchesAtStart; ///< numMatches of each Database when the TU started
+};
+
+/// @brief Creates an IndexAction for every translation unit that is run by a ClangTool.
+class IndexActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+  IndexActionFactory(hdoc::types::Index*         index,
+                     const hdoc::types::Config*  cfg,
+                     hdoc::indexer::FileClaims*  claims       = nullptr,
+                     hdoc::types::IndexClaims*   symbolClaims = nullptr,
+                     std::vector<std::string>*   dependencies = nullptr,
+                     hdoc::types::SymbolIDTable* symbolIDs    = nullptr,
+                     hdoc::indexer::TUCost*      cost         = nullptr,
+                     const bool                  timeHeaders  = false,
+                     const uint32_t              claimant     = 0)
+      : index(index), cfg(cfg), claims(claims), symbolClaims(symbolClaims), dependencies(dependencies),
+        symbolIDs(symbolIDs), cost(cost), timeHeaders(timeHeaders), claimant(claimant) {}
+
+  std::unique_ptr<clang::FrontendAction> create() override {
+    return std::make_unique<IndexAction>(this->index,
+                                         this->cfg,
+                                         this->claims,
+                                         this->symbolClaims,
+                                         this->dependencies,
+                                         this->symbolIDs,
+                                         this->cost,
+                                         this->timeHeaders,
+                                         this->claimant);
+  }
+
+private:
+  hdoc::types::Index*         index;
+  const hdoc::types::Config*  cfg;
+  hdoc::indexer::FileClaims*  claims;
+  hdoc::types::IndexClaims*   symbolClaims;
+  std::vector<std::string>*   dependencies;
+  hdoc::types::SymbolIDTable* symbolIDs;
+  hdoc::indexer::TUCost*      cost;
+  bool                        timeHeaders;
+  uint32_t                    claimant;
+};
+} // namespace hdoc::indexer
@@ -0,0 +1,183 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/IndexCache.hpp"
+#include "serde/BinarySerde.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+constexpr llvm::StringLiteral shardMagic         = "HDOCSHRD";
+constexpr uint64_t            shardFormatVersion = 1;
+
+template <typename T>
+static void writeDatabase(hdoc::serde::BinaryWriter& writer, const hdoc::types::Database<T>& db) {
+  writer.writeUInt(db.entries.size());
+  for (const auto& [k, v] : db.entries) {
+    writer.write(v);
+  }
+}
+
+template <typename T> static void readDatabase(hdoc::serde::BinaryReader& reader, hdoc::types::Database<T>& db) {
+  const uint64_t count = reader.readUInt();
+  for (uint64_t i = 0; i < count && reader.ok(); i++) {
+    T s;
+    reader.read(s);
+    db.entries.emplace(s.ID, std::move(s));
+  }
+}
+
+hdoc::indexer::IndexCache::IndexCache(const hdoc::types::Config* cfg) {
+  if (cfg->cacheDir.empty()) {
+    return;
+  }
+
+  this->dir = cfg->cacheDir / "shards";
+  std::error_code ec;
+  std::filesystem::create_directories(this->dir, ec);
+  if (ec) {
+    spdlog::warn("Unable to create index cache directory {} ({}). Proceeding without the index cache.",
+                 this->dir.string(),
+                 ec.message());
+    return;
+  }
+
+  // Shards are only valid for the version of hdoc and the configuration that created them
+  std::string salt = cfg->hdocVersion + '\0' + cfg->rootDir.string() + '\0' + (cfg->ignorePrivateMembers ? "1" : "0") +
+                     (cfg->skipFunctionBodies ? "1" : "0") + hdoc::types::SymbolID::hashName;
+  for (const auto& path : cfg->ignorePaths.patterns()) {
+    salt += '\0' + path;
+  }
+  this->configHash = llvm::xxHash64(salt);
+  this->isEnabled  = true;
+}
+
+uint64_t hdoc::indexer::IndexCache::fingerprint(const std::vector<clang::tooling::CompileCommand>& cmds,
+                                                const std::vector<std::string>& extraArgs) const {
+  std::string key = std::to_string(this->configHash);
+  for (const auto& cmd : cmds) {
+    key += '\0' + cmd.Directory + '\0' + cmd.Filename;
+    for (const auto& arg : cmd.CommandLine) {
+      key += '\0' + arg;
+    }
+  }
+  for (const auto& arg : extraArgs) {
+    key += '\0' + arg;
+  }
+  return llvm::xxHash64(key);
+}
+
+std::filesystem::path hdoc::indexer::IndexCache::shardPath(const std::string& file) const {
+  return this->dir / (llvm::utohexstr(llvm::xxHash64(file)) + ".shard");
+}
+
+bool hdoc::indexer::IndexCache::getContentHash(const std::string& path, uint64_t& hash) {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (const auto it = this->contentHashes.find(path); it != this->contentHashes.end()) {
+      hash = it->second;
+      return true;
+    }
+  }
+
+  // Hash outside of the lock so that threads don't wait on each other's file reads
+  auto buf = llvm::MemoryBuffer::getFile(path);
+  if (!buf) {
+    return false;
+  }
+  hash = llvm::xxHash64(buf.get()->getBuffer());
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->contentHashes.emplace(path, hash);
+  return true;
+}
+
+bool hdoc::indexer::IndexCache::load(const std::string& file, const uint64_t fingerprint, hdoc::types::Index& shard) {
+  auto buf = llvm::MemoryBuffer::getFile(this->shardPath(file).string());
+  if (!buf || !buf.get()->getBuffer().startswith(shardMagic)) {
+    this->numMisses++;
+    return false;
+  }
+
+  hdoc::serde::BinaryReader reader(buf.get()->getBuffer().drop_front(shardMagic.size()));
+  if (reader.readUInt() != shardFormatVersion || reader.readString() != file || reader.readUInt() != fingerprint) {
+    this->numMisses++;
+    return false;
+  }
+
+  // The shard is stale if any of the files the TU depends on has changed since it was created
+  const uint64_t numDependencies = reader.readUInt();
+  for (uint64_t i = 0; i < numDependencies && reader.ok(); i++) {
+    const std::string path       = reader.readString();
+    const uint64_t    cachedHash = reader.readUInt();
+    uint64_t          hash       = 0;
+    if (!reader.ok() || !this->getContentHash(path, hash) || hash != cachedHash) {
+      this->numMisses++;
+      return false;
+    }
+  }
+
+  readDatabase(reader, shard.functions);
+  readDatabase(reader, shard.records);
+  readDatabase(reader, shard.enums);
+  readDatabase(reader, shard.namespaces);
+  if (!reader.ok()) {
+    spdlog::warn("Index cache shard for {} is corrupt, it will be regenerated.", file);
+    shard.functions.entries.clear();
+    shard.records.entries.clear();
+    shard.enums.entries.clear();
+    shard.namespaces.entries.clear();
+    this->numMisses++;
+    return false;
+  }
+
+  this->numHits++;
+  return true;
+}
+
+void hdoc::indexer::IndexCache::store(const std::string&              file,
+                                      const uint64_t                  fingerprint,
+                                      const std::vector<std::string>& dependencies,
+                                      const hdoc::types::Index&       shard) {
+  std::string               buf = shardMagic.str();
+  hdoc::serde::BinaryWriter writer(buf);
+  writer.writeUInt(shardFormatVersion);
+  writer.writeString(file);
+  writer.writeUInt(fingerprint);
+
+  writer.writeUInt(dependencies.size());
+  for (const auto& path : dependencies) {
+    uint64_t hash = 0;
+    if (!this->getContentHash(path, hash)) {
+      spdlog::warn("Unable to read {}, not caching the index of {}.", path, file);
+      return;
+    }
+    writer.writeString(path);
+    writer.writeUInt(hash);
+  }
+
+  writeDatabase(writer, shard.functions);
+  writeDatabase(writer, shard.records);
+  writeDatabase(writer, shard.enums);
+  writeDatabase(writer, shard.namespaces);
+
+  // Write to a temporary file and move it into place so that an interrupted run never leaves a partial shard behind
+  int                    fd;
+  llvm::SmallString<256> tmpPath;
+  if (const auto ec = llvm::sys::fs::createUniqueFile((this->dir / "shard-%%%%%%%%.tmp").string(), fd, tmpPath)) {
+    spdlog::warn("Unable to create index cache shard for {} ({}).", file, ec.message());
+    return;
+  }
+  {
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    out << buf;
+  }
+  if (const auto ec = llvm::sys::fs::rename(tmpPath, this->shardPath(file).string())) {
+    spdlog::warn("Unable to save index cache shard for {} ({}).", file, ec.message());
+    llvm::sys::fs::remove(tmpPath);
+  }
+}
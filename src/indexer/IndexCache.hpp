@@ -0,0 +1,65 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "types/Config.hpp"
+#include "types/Index.hpp"
+
+namespace hdoc::indexer {
+/// @brief Persistent on-disk cache of the symbols that each translation unit contributed to the Index.
+///
+/// Each TU's symbols are stored in a "shard" alongside a fingerprint of its compile command and the content
+/// hash of every file it read while being parsed (the main file and every header it included).
+/// On later runs a shard is only reused if the fingerprint and every file's content hash still match,
+/// in which case the TU doesn't need to be parsed again.
+class IndexCache {
+public:
+  IndexCache(const hdoc::types::Config* cfg);
+
+  /// @brief Returns true if the cache is enabled in the configuration and usable
+  bool enabled() const {
+    return this->isEnabled;
+  }
+
+  /// @brief Compute a fingerprint of everything that affects how a TU is parsed and indexed
+  uint64_t fingerprint(const std::vector<clang::tooling::CompileCommand>& cmds,
+                       const std::vector<std::string>&                    extraArgs) const;
+
+  /// @brief Try to load the shard for `file` into `shard`
+  /// Returns true on a cache hit, and false if the shard is missing, corrupt, or out of date.
+  bool load(const std::string& file, const uint64_t fingerprint, hdoc::types::Index& shard);
+
+  /// @brief Save the symbols a TU contributed to the Index along with the files it depends on
+  void store(const std::string&              file,
+             const uint64_t                  fingerprint,
+             const std::vector<std::string>& dependencies,
+             const hdoc::types::Index&       shard);
+
+  std::atomic<uint32_t> numHits   = 0; ///< Number of TUs loaded from the cache
+  std::atomic<uint32_t> numMisses = 0; ///< Number of TUs that had to be parsed
+
+private:
+  /// @brief Get the content hash of a file, reading and hashing it at most once per run
+  /// Returns false if the file couldn't be read.
+  bool getContentHash(const std::string& path, uint64_t& hash);
+
+  /// @brief Path of the shard file for a given TU
+  std::filesystem::path shardPath(const std::string& file) const;
+
+  bool                                      isEnabled = false;
+  std::filesystem::path                     dir;           ///< Directory where shards are stored
+  uint64_t                                  configHash;    ///< Hash of the config values that affect indexing
+  std::unordered_map<std::string, uint64_t> contentHashes; ///< Content hashes of files seen during this run
+  std::mutex                                mutex;         ///< Guards contentHashes
+};
+} // namespace hdoc::indexer
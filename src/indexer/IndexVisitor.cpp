@@ -0,0 +1,100 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/IndexVisitor.hpp"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+
+/// @brief Mirrors the isTemplateInstantiation() matcher, which is used by isInstantiated()
+static bool isTemplateInstantiation(const clang::Decl* d) {
+  clang::TemplateSpecializationKind kind = clang::TSK_Undeclared;
+  if (const auto* record = llvm::dyn_cast<clang::CXXRecordDecl>(d)) {
+    kind = record->getTemplateSpecializationKind();
+  } else if (const auto* function = llvm::dyn_cast<clang::FunctionDecl>(d)) {
+    kind = function->getTemplateSpecializationKind();
+  }
+  return kind == clang::TSK_ImplicitInstantiation || kind == clang::TSK_ExplicitInstantiationDefinition ||
+         kind == clang::TSK_ExplicitInstantiationDeclaration;
+}
+
+bool hdoc::indexer::IndexVisitor::isInExcludedFile(const clang::Decl* d) {
+  const auto& sourceManager = d->getASTContext().getSourceManager();
+  const auto  expansionLoc  = sourceManager.getExpansionLoc(d->getBeginLoc());
+  if (expansionLoc.isInvalid()) {
+    return false;
+  }
+
+  const clang::FileID fileID = sourceManager.getFileID(expansionLoc);
+  if (const auto it = this->excludedFiles.find(fileID); it != this->excludedFiles.end()) {
+    return it->second;
+  }
+
+  // The matchers share a TUContext, so the ignore decision is reused by their process() functions
+  const bool excluded = sourceManager.isInSystemHeader(expansionLoc) ||
+                        (!this->cfg->ignorePaths.empty() &&
+                         this->functionFinder.ctx->getFileInfo(fileID, sourceManager).ignored);
+  this->excludedFiles.try_emplace(fileID, excluded);
+  return excluded;
+}
+
+bool hdoc::indexer::IndexVisitor::TraverseDecl(clang::Decl* d) {
+  if (d == nullptr) {
+    return RecursiveASTVisitor::TraverseDecl(d);
+  }
+
+  // Nothing inside of an anonymous namespace is indexed, and the namespace itself has no name
+  if (const auto* ns = llvm::dyn_cast<clang::NamespaceDecl>(d); ns != nullptr && ns->isAnonymousNamespace()) {
+    return true;
+  }
+
+  // Skip the subtrees of decls that are excluded because of the file they're in.
+  // Namespaces and linkage specs are still traversed because they can #include other, non-excluded, files.
+  if (!llvm::isa<clang::TranslationUnitDecl, clang::NamespaceDecl, clang::LinkageSpecDecl>(d) &&
+      this->isInExcludedFile(d)) {
+    return true;
+  }
+
+  const bool isInstantiation = isTemplateInstantiation(d);
+  this->instantiationDepth += isInstantiation;
+  const bool result = RecursiveASTVisitor::TraverseDecl(d);
+  this->instantiationDepth -= isInstantiation;
+  return result;
+}
+
+bool hdoc::indexer::IndexVisitor::VisitFunctionDecl(clang::FunctionDecl* d) {
+  if (this->instantiationDepth > 0 || d->isImplicit() || d->isInStdNamespace() ||
+      d->getTemplateSpecializationKind() != clang::TSK_Undeclared || this->isInExcludedFile(d)) {
+    return true;
+  }
+  this->functionFinder.process(d);
+  return true;
+}
+
+bool hdoc::indexer::IndexVisitor::VisitCXXRecordDecl(clang::CXXRecordDecl* d) {
+  if (!d->isThisDeclarationADefinition() || this->instantiationDepth > 0 || d->isImplicit() ||
+      d->isInStdNamespace() || d->getTemplateSpecializationKind() != clang::TSK_Undeclared ||
+      this->isInExcludedFile(d)) {
+    return true;
+  }
+  this->recordFinder.process(d);
+  return true;
+}
+
+bool hdoc::indexer::IndexVisitor::VisitEnumDecl(clang::EnumDecl* d) {
+  // Unlike records and functions, the enum matcher doesn't exclude enums inside of template instantiations
+  if (!d->isThisDeclarationADefinition() || d->isImplicit() || d->isInStdNamespace() || this->isInExcludedFile(d)) {
+    return true;
+  }
+  this->enumFinder.process(d);
+  return true;
+}
+
+bool hdoc::indexer::IndexVisitor::VisitNamespaceDecl(clang::NamespaceDecl* d) {
+  if (d->isImplicit() || d->isInStdNamespace() || this->isInExcludedFile(d)) {
+    return true;
+  }
+  this->namespaceFinder.process(d);
+  return true;
+}
@@ -0,0 +1,60 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+
+#include "indexer/Matchers.hpp"
+#include "types/Config.hpp"
+
+namespace hdoc::indexer {
+/// @brief Extracts symbols from a translation unit in a single RecursiveASTVisitor pass.
+///
+/// This is an alternative to running the four ASTMatchers, which each check predicates such as
+/// hasAncestor(namespaceDecl(isAnonymous())) and isInstantiated() by walking up the parent chain of every decl.
+/// Instead, the visitor carries that state down the traversal: anonymous namespaces are never entered,
+/// instantiations are tracked with a counter, and the system header and ignore path checks are cached per file.
+/// Subtrees of decls in system headers or ignored files are skipped entirely, with the exception of namespaces
+/// and linkage specifications which commonly #include other files.
+/// Each decl is then passed to the same process() function that the corresponding matcher uses.
+class IndexVisitor : public clang::RecursiveASTVisitor<IndexVisitor> {
+public:
+  IndexVisitor(hdoc::indexer::matchers::FunctionMatcher&  functionFinder,
+               hdoc::indexer::matchers::RecordMatcher&    recordFinder,
+               hdoc::indexer::matchers::EnumMatcher&      enumFinder,
+               hdoc::indexer::matchers::NamespaceMatcher& namespaceFinder,
+               const hdoc::types::Config*                 cfg)
+      : functionFinder(functionFinder), recordFinder(recordFinder), enumFinder(enumFinder),
+        namespaceFinder(namespaceFinder), cfg(cfg) {}
+
+  // The matchers see implicit code and template instantiations, so the visitor does too
+  bool shouldVisitImplicitCode() const {
+    return true;
+  }
+  bool shouldVisitTemplateInstantiations() const {
+    return true;
+  }
+
+  bool TraverseDecl(clang::Decl* d);
+  bool VisitFunctionDecl(clang::FunctionDecl* d);
+  bool VisitCXXRecordDecl(clang::CXXRecordDecl* d);
+  bool VisitEnumDecl(clang::EnumDecl* d);
+  bool VisitNamespaceDecl(clang::NamespaceDecl* d);
+
+private:
+  /// @brief Check if a decl is in a system header or in an ignored file, with the same logic as
+  /// isExpansionInSystemHeader() and shouldBeIgnored()
+  bool isInExcludedFile(const clang::Decl* d);
+
+  hdoc::indexer::matchers::FunctionMatcher&  functionFinder;
+  hdoc::indexer::matchers::RecordMatcher&    recordFinder;
+  hdoc::indexer::matchers::EnumMatcher&      enumFinder;
+  hdoc::indexer::matchers::NamespaceMatcher& namespaceFinder;
+  const hdoc::types::Config*                 cfg;
+  uint32_t                                   instantiationDepth = 0; ///< Number of enclosing template instantiations
+  llvm::DenseMap<clang::FileID, bool>        excludedFiles;          ///< Cached results of isInExcludedFile()
+};
+} // namespace hdoc::indexer
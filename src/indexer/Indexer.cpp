@@ -4,26 +4,26 @@
 #include <filesystem>
 
 #include "spdlog/spdlog.h"
-#include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
 
+#include "indexer/IndexCache.hpp"
 #include "indexer/Indexer.hpp"
-#include "indexer/Matchers.hpp"
+#include "indexer/PostProcess.hpp"
+#include "types/MemoryUsage.hpp"
+#include "support/HeaderCompilationDatabase.hpp"
+#include "support/Metrics.hpp"
 #include "support/ParallelExecutor.hpp"
-
-// Check if a symbol is a child of the given namespace
-static bool isChild(const hdoc::types::Symbol& ns, const hdoc::types::Symbol& s) {
-  return s.parentNamespaceID.raw() == ns.ID.raw();
-}
+#include "support/Trace.hpp"
 
 void hdoc::indexer::Indexer::run() {
   spdlog::info("Starting indexing...");
+  hdoc::utils::TraceScope trace("Index");
 
-  std::string err;
-  const auto  stx = clang::tooling::JSONCommandLineSyntax::AutoDetect;
-  const auto  cmpdb =
+  std::string                                          err;
+  const auto                                           stx = clang::tooling::JSONCommandLineSyntax::AutoDetect;
+  std::unique_ptr<clang::tooling::CompilationDatabase> cmpdb =
       clang::tooling::JSONCompilationDatabase::loadFromFile(this->cfg->compileCommandsJSON.string(), err, stx);
 
   if (cmpdb == nullptr) {
@@ -31,15 +31,10 @@ void hdoc::indexer::Indexer::run() {
     return;
   }
 
-  hdoc::indexer::matchers::FunctionMatcher  FunctionFinder(&this->index, this->cfg);
-  hdoc::indexer::matchers::RecordMatcher    RecordFinder(&this->index, this->cfg);
-  hdoc::indexer::matchers::EnumMatcher      EnumFinder(&this->index, this->cfg);
-  hdoc::indexer::matchers::NamespaceMatcher NamespaceFinder(&this->index, this->cfg);
-  clang::ast_matchers::MatchFinder          Finder;
-  Finder.addMatcher(FunctionFinder.getMatcher(), &FunctionFinder);
-  Finder.addMatcher(RecordFinder.getMatcher(), &RecordFinder);
-  Finder.addMatcher(EnumFinder.getMatcher(), &EnumFinder);
-  Finder.addMatcher(NamespaceFinder.getMatcher(), &NamespaceFinder);
+  // Index synthetic TUs that include the project's headers instead of the source files
+  if (this->cfg->headersOnly) {
+    cmpdb = std::make_unique<hdoc::indexer::HeaderCompilationDatabase>(std::move(cmpdb), this->cfg);
+  }
 
   // Add include search paths to clang invocation
   std::vector<std::string> includePaths = {};
@@ -53,131 +48,159 @@ void hdoc::indexer::Indexer::run() {
     includePaths.emplace_back("-isystem" + d);
   }
 
-  hdoc::indexer::ParallelExecutor tool(*cmpdb, includePaths, this->pool, this->cfg->debugLimitNumIndexedFiles);
-  tool.execute(clang::tooling::newFrontendActionFactory(&Finder));
-}
+  if (this->cfg->spillThreshold > 0) {
+    this->spilled = std::make_unique<hdoc::indexer::SpilledIndex>(this->cfg->spillThreshold, this->cfg->spillDir);
+  }
 
-void hdoc::indexer::Indexer::resolveNamespaces() {
-  spdlog::info("Indexer resolving namespaces.");
-  for (auto& [k, ns] : this->index.namespaces.entries) {
-    // Add all the direct children of this namespace to its children vector
-    for (const auto& [k, v] : this->index.records.entries) {
-      if (isChild(ns, v)) {
-        ns.records.emplace_back(v.ID);
-      }
-    }
-    for (const auto& [k, v] : this->index.enums.entries) {
-      if (isChild(ns, v)) {
-        ns.enums.emplace_back(v.ID);
-      }
-    }
-    for (const auto& [k, v] : this->index.namespaces.entries) {
-      if (isChild(ns, v)) {
-        ns.namespaces.emplace_back(v.ID);
-      }
-    }
+  hdoc::indexer::IndexCache       cache(this->cfg);
+  hdoc::indexer::ParallelExecutor tool(*cmpdb, includePaths, this->pool, this->cfg);
+  tool.execute(this->index,
+               cache,
+               this->claims,
+               this->cfg->checkSymbolIDs ? &this->symbolIDs : nullptr,
+               this->spilled && this->spilled->enabled() ? this->spilled.get() : nullptr);
+  if (cache.enabled()) {
+    spdlog::info("Index cache: {} TUs loaded from cache, {} TUs parsed.", cache.numHits, cache.numMisses);
   }
-  spdlog::info("Indexer namespace resolution complete.");
 }
 
-void hdoc::indexer::Indexer::updateRecordNames() {
-  spdlog::info("Indexer updating record names with inheritance information.");
-  for (auto& [k, c] : this->index.records.entries) {
-    if (c.baseRecords.size() > 0) {
-      uint64_t count = 0;
-      c.proto += " : ";
-      for (const auto& baseRecord : c.baseRecords) {
-        if (count > 0) {
-          c.proto += ", ";
-        }
-
-        // Print the access type that indicates which kind of inheritance was used
-        switch (baseRecord.access) {
-        case clang::AS_public:
-          c.proto += "public ";
-          break;
-        case clang::AS_private:
-          c.proto += "private ";
-          break;
-        case clang::AS_protected:
-          c.proto += "protected ";
-          break;
-        case clang::AS_none:
-        // intentional fallthrough
-        default:
-          break;
-        }
-
-        c.proto += baseRecord.name;
-        count++;
-      }
-    }
-  }
+void hdoc::indexer::Indexer::postProcess() {
+  spdlog::info("Indexer post-processing the index.");
+  hdoc::utils::TraceScope trace("Post-process");
+  // Spilled symbols are merged with the ones that are still in memory as they're post-processed
+  const bool spilled = this->spilled != nullptr && this->spilled->spilled();
+  const auto stats   = spilled ? this->spilled->postProcess(this->index, this->pool)
+                               : hdoc::indexer::postProcess(this->index, this->pool);
+  spdlog::info("Pruned {} functions from the database.", stats.numPrunedMethods);
+  spdlog::info("Post-processing took {:.1f} ms: {:.1f} ms traversing the index, {:.1f} ms linking namespaces, "
+               "{:.1f} ms pruning methods",
+               stats.totalTime,
+               stats.traversalTime,
+               stats.linkTime,
+               stats.eraseTime);
+  spdlog::info("Post-processing thread time: {:.1f} ms functions, {:.1f} ms records, {:.1f} ms enums, "
+               "{:.1f} ms namespaces",
+               stats.functionsTime,
+               stats.recordsTime,
+               stats.enumsTime,
+               stats.namespacesTime);
 }
 
 void hdoc::indexer::Indexer::printStats() const {
+  if (this->spilled != nullptr && this->spilled->spilled()) {
+    this->printSpilledStats();
+  } else {
+    this->printDatabaseStats();
+  }
+  spdlog::info("SymbolIDs:  {} built, {} lookups ({:.1f}% hit rate of the per-TU cache)",
+               this->index.numIDLookups - this->index.numIDCacheHits,
+               this->index.numIDLookups,
+               this->index.numIDLookups == 0 ? 0.0 : 100.0 * this->index.numIDCacheHits / this->index.numIDLookups);
+  if (this->cfg->checkSymbolIDs) {
+    spdlog::info("SymbolIDs:  {} collisions between {} symbols hashed with {}",
+                 this->symbolIDs.numCollisions,
+                 this->symbolIDs.size(),
+                 hdoc::types::SymbolID::hashName);
+  }
+  const auto& pool = hdoc::types::StringPool::global();
+  spdlog::info("Strings:    {} interned, {} unique ({} KiB), {} KiB saved by interning",
+               pool.numInterned,
+               pool.numUnique,
+               pool.bytesUnique / 1024,
+               pool.bytesSaved() / 1024);
+}
+
+void hdoc::indexer::Indexer::printDatabaseStats() const {
+  // Heap memory used by each database, including the strings and vectors of every symbol
+  const auto functionUsage  = hdoc::types::memoryUsage(this->index.functions);
+  const auto recordUsage    = hdoc::types::memoryUsage(this->index.records);
+  const auto enumUsage      = hdoc::types::memoryUsage(this->index.enums);
+  const auto namespaceUsage = hdoc::types::memoryUsage(this->index.namespaces);
+
+  auto& metrics = hdoc::utils::Metrics::global();
+  metrics.recordDatabase("functions", functionUsage);
+  metrics.recordDatabase("records", recordUsage);
+  metrics.recordDatabase("enums", enumUsage);
+  metrics.recordDatabase("namespaces", namespaceUsage);
+
   // Size of databases in KiB
-  const auto functionIndexSize  = this->index.functions.entries.size() * sizeof(hdoc::types::FunctionSymbol) / 1024;
-  const auto recordIndexSize    = this->index.records.entries.size() * sizeof(hdoc::types::RecordSymbol) / 1024;
-  const auto enumIndexSize      = this->index.enums.entries.size() * sizeof(hdoc::types::EnumMember) / 1024;
-  const auto namespaceIndexSize = this->index.namespaces.entries.size() * sizeof(hdoc::types::NamespaceSymbol) / 1024;
+  const auto functionIndexSize  = functionUsage.total() / 1024;
+  const auto recordIndexSize    = recordUsage.total() / 1024;
+  const auto enumIndexSize      = enumUsage.total() / 1024;
+  const auto namespaceIndexSize = namespaceUsage.total() / 1024;
 
-  spdlog::info("Functions:  {} matches, {} indexed, {} KiB total size",
+  spdlog::info("Functions:  {} matches, {} indexed, {} KiB total size, {} claimed, {} duplicates skipped",
                this->index.functions.numMatches,
                this->index.functions.entries.size(),
-               functionIndexSize);
-  spdlog::info("Records:    {} matches, {} indexed, {} KiB total size",
+               functionIndexSize,
+               this->claims.functions.numWon.load(),
+               this->claims.functions.numLost.load());
+  spdlog::info("Records:    {} matches, {} indexed, {} KiB total size, {} claimed, {} duplicates skipped",
                this->index.records.numMatches,
                this->index.records.entries.size(),
-               recordIndexSize);
-  spdlog::info("Enums:      {} matches, {} indexed, {} KiB total size",
+               recordIndexSize,
+               this->claims.records.numWon.load(),
+               this->claims.records.numLost.load());
+  spdlog::info("Enums:      {} matches, {} indexed, {} KiB total size, {} claimed, {} duplicates skipped",
                this->index.enums.numMatches,
                this->index.enums.entries.size(),
-               enumIndexSize);
-  spdlog::info("Namespaces: {} matches, {} indexed, {} KiB total size",
+               enumIndexSize,
+               this->claims.enums.numWon.load(),
+               this->claims.enums.numLost.load());
+  spdlog::info("Namespaces: {} matches, {} indexed, {} KiB total size, {} claimed, {} duplicates skipped",
                this->index.namespaces.numMatches,
                this->index.namespaces.entries.size(),
-               namespaceIndexSize);
+               namespaceIndexSize,
+               this->claims.namespaces.numWon.load(),
+               this->claims.namespaces.numLost.load());
 }
 
-void hdoc::indexer::Indexer::pruneMethods() {
-  // If a method's parent isn't in the index, it was filtered out and not indexed.
-  // ergo, it's children shouldn't be indexed either, so we remove them
-  std::vector<hdoc::types::SymbolID> toBePruned;
-  for (const auto& [k, v] : this->index.functions.entries) {
-    if (v.isRecordMember && !this->index.records.contains(v.parentNamespaceID)) {
-      toBePruned.emplace_back(k);
-    }
-  }
-  // Remove methods from index
-  for (const auto& deadSymbolID : toBePruned) {
-    this->index.functions.entries.erase(deadSymbolID);
-  }
-  spdlog::info("Pruned {} functions from the database.", toBePruned.size());
-}
-
-void hdoc::indexer::Indexer::pruneTypeRefs() {
-  for (auto& [k, v] : this->index.functions.entries) {
-    if (this->index.records.contains(v.returnType.id) == false) {
-      v.returnType.id = hdoc::types::SymbolID();
-    }
-
-    for (auto& param : v.params) {
-      if (this->index.records.contains(param.type.id) == false) {
-        param.type.id = hdoc::types::SymbolID();
-      }
-    }
-  }
-
-  for (auto& [k, v] : this->index.records.entries) {
-    for (auto& var : v.vars) {
-      if (this->index.records.contains(var.type.id) == false) {
-        var.type.id = hdoc::types::SymbolID();
-      }
-    }
-  }
+void hdoc::indexer::Indexer::printSpilledStats() const {
+  // Symbols were written to disk, so their size on disk is reported instead of how much memory they use
+  const hdoc::indexer::SpilledIndex& s = *this->spilled;
+
+  auto& metrics = hdoc::utils::Metrics::global();
+  metrics.recordSpilledDatabase("functions", s.functions.numBytes);
+  metrics.recordSpilledDatabase("records", s.records.numBytes);
+  metrics.recordSpilledDatabase("enums", s.enums.numBytes);
+  metrics.recordSpilledDatabase("namespaces", s.namespaces.numBytes);
+
+  spdlog::info("Functions:  {} matches, {} indexed, {} KiB on disk, {} claimed, {} duplicates skipped",
+               s.functions.db.numMatches,
+               s.functions.db.size(),
+               s.functions.numBytes / 1024,
+               this->claims.functions.numWon.load(),
+               this->claims.functions.numLost.load());
+  spdlog::info("Records:    {} matches, {} indexed, {} KiB on disk, {} claimed, {} duplicates skipped",
+               s.records.db.numMatches,
+               s.records.db.size(),
+               s.records.numBytes / 1024,
+               this->claims.records.numWon.load(),
+               this->claims.records.numLost.load());
+  spdlog::info("Enums:      {} matches, {} indexed, {} KiB on disk, {} claimed, {} duplicates skipped",
+               s.enums.db.numMatches,
+               s.enums.db.size(),
+               s.enums.numBytes / 1024,
+               this->claims.enums.numWon.load(),
+               this->claims.enums.numLost.load());
+  spdlog::info("Namespaces: {} matches, {} indexed, {} KiB on disk, {} claimed, {} duplicates skipped",
+               s.namespaces.db.numMatches,
+               s.namespaces.db.size(),
+               s.namespaces.numBytes / 1024,
+               this->claims.namespaces.numWon.load(),
+               this->claims.namespaces.numLost.load());
 }
 
 const hdoc::types::Index* hdoc::indexer::Indexer::dump() const {
   return &this->index;
 }
+
+hdoc::types::FrozenIndex hdoc::indexer::Indexer::freeze() {
+  hdoc::utils::TraceScope trace("Freeze index");
+  if (this->spilled != nullptr && this->spilled->spilled()) {
+    return this->spilled->freeze();
+  }
+  hdoc::types::FrozenIndex frozen(std::move(this->index));
+  this->index = hdoc::types::Index();
+  return frozen;
+}
@@ -3,10 +3,16 @@
 
 #pragma once
 
+#include <memory>
+
 #include "llvm/Support/ThreadPool.h"
 
+#include "indexer/SpilledIndex.hpp"
+#include "types/ClaimTable.hpp"
 #include "types/Config.hpp"
+#include "types/FrozenIndex.hpp"
 #include "types/Index.hpp"
+#include "types/SymbolIDTable.hpp"
 
 namespace hdoc::indexer {
 /// @brief Index all of the code in a project into hdoc's internal representation
@@ -16,22 +22,8 @@ public:
   /// @brief Run the indexer over project code
   void run();
 
-  /// @brief Update the declaration of the all records to indicate records they inherit
-  /// from and the type of inheritance. This must be done after all records are
-  /// parsed as the inherited records might not be in the database at parse-time.
-  void updateRecordNames();
-
-  /// @brief Update NamespaceSymbols with the IDs of their children
-  void resolveNamespaces();
-
-  /// @brief Remove orphaned methods from the Index
-  void pruneMethods();
-
-  /// @brief Remove TypeRefs that aren't in the Index
-  /// Some TypeRefs might have SymbolIDs that aren't in the Index, for example
-  /// if they're in a third-party library that isn't indexed.
-  /// We need to remove them prior to HTML serialization to ensure we don't have dead links.
-  void pruneTypeRefs();
+  /// @brief Prepare the Index for serialization once it's complete, see hdoc::indexer::postProcess()
+  void postProcess();
 
   /// @brief Print the number of matches, indexed entries, and size of the database for each type.
   void printStats() const;
@@ -39,10 +31,23 @@ public:
   /// @brief Dump the index for use in serde
   const hdoc::types::Index* dump() const;
 
+  /// @brief Move the index into a read-only FrozenIndex for use in serde, leaving the Indexer's index empty
+  hdoc::types::FrozenIndex freeze();
+
 private:
+  /// @brief Print the stats of the Index when it's held in memory
+  void printDatabaseStats() const;
+
+  /// @brief Print the stats of the Index when it was spilled to disk
+  void printSpilledStats() const;
+
   hdoc::types::Index         index;
+  hdoc::types::IndexClaims   claims;    ///< Which thread indexed each symbol
+  hdoc::types::SymbolIDTable symbolIDs; ///< USR of every SymbolID, only filled if cfg->checkSymbolIDs is set
   const hdoc::types::Config* cfg;
   llvm::ThreadPool&          pool;
+
+  std::unique_ptr<hdoc::indexer::SpilledIndex> spilled; ///< Symbols spilled to disk, if cfg->spillThreshold is set
 };
 
 } // namespace hdoc::indexer
@@ -15,54 +15,22 @@
 
 #include <filesystem>
 
-/// When hdoc is run by multiple threads, we use a VFS (virtual file system) to access
-/// files safely. The working directory of the parser is changed during indexing, and
-/// other threads have no visibility of this. Consequently, canonical paths
-/// generated in a non-VFS-aware way can be wrong.
-/// This function is similar to one defined in clang, and gets the canonical path in a
-/// VFS-aware way.
-static llvm::Optional<std::string> getCanonicalPath(const clang::Decl* d) {
-  const auto& sourceManager = d->getASTContext().getSourceManager();
-  const auto* fileEntry     = sourceManager.getFileEntryForID(sourceManager.getFileID(d->getLocation()));
-
-  if (!fileEntry) {
-    return llvm::None;
-  }
-
-  llvm::SmallString<128> path = fileEntry->getName();
-  if (!llvm::sys::path::is_absolute(path)) {
-    if (auto ec = sourceManager.getFileManager().getVirtualFileSystem().makeAbsolute(path)) {
-      spdlog::warn("Could not turn relative path '{}' to absolute: {}", path.c_str(), ec.message().c_str());
-      return llvm::None;
-    }
-  }
-
-  if (auto dir = sourceManager.getFileManager().getDirectory(llvm::sys::path::parent_path(path))) {
-    const llvm::StringRef  dirName = sourceManager.getFileManager().getCanonicalName(*dir);
-    llvm::SmallString<128> realPath;
-    llvm::sys::path::append(realPath, dirName, llvm::sys::path::filename(path));
-    return realPath.str().str();
-  }
-
-  return path.str().str();
-}
-
 template <typename T> static bool isParamAndHasName(const T* param) {
   return (param != nullptr) && param->hasParamName();
 }
 
 /// This is used across all types of symbols (Function, Record, Namespace, etc.) to get the
 /// vital information of the symbol
-void fillOutSymbol(hdoc::types::Symbol& s, const clang::NamedDecl* d, const std::filesystem::path& rootDir) {
+void fillOutSymbol(hdoc::types::Symbol& s, const clang::NamedDecl* d, hdoc::indexer::TUContext* ctx) {
   s.name = d->getNameAsString();
   s.line = d->getASTContext().getSourceManager().getSpellingLineNumber(d->getLocation());
 
-  const auto absPath = getCanonicalPath(d);
-  if (!absPath) {
+  const auto& fileInfo = ctx->getFileInfo(d);
+  if (fileInfo.canonicalPath.empty()) {
     spdlog::warn("Unable to get absolute path for {}", s.name);
     return;
   }
-  s.file = std::filesystem::relative(*absPath, rootDir).string();
+  s.file = fileInfo.relPath;
 }
 
 /// @brief If the type is a specialized template, convert it to the original non-specialized
@@ -78,52 +46,27 @@ const clang::ClassTemplateDecl* getNonSpecializedVersionOfDecl(const clang::TagD
   return NULL;
 }
 
-void findParentNamespace(hdoc::types::Symbol& s, const clang::NamedDecl* d) {
+void findParentNamespace(hdoc::types::Symbol& s, const clang::NamedDecl* d, hdoc::indexer::TUContext* ctx) {
   const auto* dc = llvm::dyn_cast<clang::DeclContext>(d)->getParent();
   if (const auto* n = llvm::dyn_cast<clang::NamespaceDecl>(dc)) {
-    s.parentNamespaceID = buildID(n);
+    s.parentNamespaceID = ctx->buildID(n);
   } else if (const auto* n = llvm::dyn_cast<clang::RecordDecl>(dc)) {
     // If the parent RecordDecl is a specialization, we need to "unspecialize" it
     // to get the original type. Otherwise clang will return a different SymbolID
     // and the parentNamespaceID will be a dangling reference.
     if (const auto* nonspec = getNonSpecializedVersionOfDecl((clang::TagDecl*)n)) {
-      s.parentNamespaceID = buildID(nonspec);
+      s.parentNamespaceID = ctx->buildID(nonspec);
     } else {
-      s.parentNamespaceID = buildID(n);
+      s.parentNamespaceID = ctx->buildID(n);
     }
   }
 }
 
-bool isInIgnoreList(const clang::Decl*              d,
-                    const std::vector<std::string>& ignorePaths,
-                    const std::filesystem::path&    rootDir) {
-  const auto rawPath = std::filesystem::path(d->getASTContext().getSourceManager().getFilename(d->getLocation()).str());
-
-  // If the decl has an empty path, it's probably compiler-generated so we ignore it
-  if (rawPath == "") {
-    return true;
-  }
-
-  const auto absPath = getCanonicalPath(d);
-  if (!absPath) {
-    spdlog::warn("Unable to get absolute path for a decl, ignoring it");
-    return true;
-  }
-
-  // Ignore paths outside of the rootDir
-  // ".." is used as a janky way to determine if the path is outside of rootDir since the canonicalized path
-  // should not have any ".."s in it
-  const std::string relPath = std::filesystem::relative(std::filesystem::path(*absPath), rootDir).string();
-  if (relPath.find("..") != std::string::npos) {
-    return true;
-  }
-
-  for (const auto& substr : ignorePaths) {
-    if (relPath.find(substr) != std::string::npos) {
-      return true;
-    }
-  }
-  return false;
+bool isInIgnoreList(const clang::Decl* d, hdoc::indexer::TUContext* ctx) {
+  // Decls without a file are probably compiler-generated, and decls outside of the rootDir aren't part of the
+  // project, so both are ignored
+  const auto& fileInfo = ctx->getFileInfo(d);
+  return !fileInfo.inRootDir || fileInfo.ignored;
 }
 
 /// Decls in anonymous namespaces should not be documented
@@ -221,7 +164,7 @@ std::string getFunctionSignature(hdoc::types::FunctionSymbol& f) {
 
   // Return type
   if (f.isCtorOrDtor == false) {
-    signature += f.hasTrailingReturn ? "auto " : f.returnType.name + " ";
+    signature += f.hasTrailingReturn ? "auto " : f.returnType.name.str() + " ";
   }
 
   // Get the location of the first character of the function name
@@ -260,7 +203,7 @@ std::string getFunctionSignature(hdoc::types::FunctionSymbol& f) {
   signature += f.isNoExcept ? " noexcept" : "";
 
   // Trailing return type goes last
-  signature += f.hasTrailingReturn ? " -> " + f.returnType.name : "";
+  signature += f.hasTrailingReturn ? " -> " + f.returnType.name.str() : "";
 
   return signature;
 }
@@ -281,16 +224,6 @@ std::string exprToString(const clang::Expr* expr, clang::PrintingPolicy printing
   return result;
 }
 
-hdoc::types::SymbolID buildID(const clang::NamedDecl* d) {
-  llvm::SmallString<128> USR;
-  if (clang::index::generateUSRForDecl(d, USR)) {
-    spdlog::error("Unable to generate USR for the given symbol with name {}", d->getNameAsString());
-    return hdoc::types::SymbolID();
-  } else {
-    return hdoc::types::SymbolID(USR);
-  }
-}
-
 std::string getCommandName(const unsigned& CommandID) {
   const clang::comments::CommandInfo* cmd = clang::comments::CommandTraits::getBuiltinCommandInfo(CommandID);
   return cmd ? cmd->Name : "";
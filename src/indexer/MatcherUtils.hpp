@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "indexer/TUContext.hpp"
 #include "types/Symbols.hpp"
 #include "clang/AST/Comment.h"
 #include "clang/AST/DeclTemplate.h"
@@ -10,19 +11,17 @@
 #include <string>
 
 /// @brief Update the name, line, and file of the decl
-void fillOutSymbol(hdoc::types::Symbol& s, const clang::NamedDecl* d, const std::filesystem::path& rootDir);
+void fillOutSymbol(hdoc::types::Symbol& s, const clang::NamedDecl* d, hdoc::indexer::TUContext* ctx);
 
 /// @brief If the type is a specialized template, convert it to the original non-specialized
 /// templated type.
 const clang::ClassTemplateDecl* getNonSpecializedVersionOfDecl(const clang::TagDecl* tagdecl);
 
 /// @brief Find the parent namespace (either record or an actual namespace) of a decl
-void findParentNamespace(hdoc::types::Symbol& s, const clang::NamedDecl* d);
+void findParentNamespace(hdoc::types::Symbol& s, const clang::NamedDecl* d, hdoc::indexer::TUContext* ctx);
 
 /// @brief Check if a decl is defined in a non-existent file or in the set of ignored paths
-bool isInIgnoreList(const clang::Decl*              d,
-                    const std::vector<std::string>& ignorePaths,
-                    const std::filesystem::path&    rootDir);
+bool isInIgnoreList(const clang::Decl* d, hdoc::indexer::TUContext* ctx);
 
 /// @brief Check if the decl is in an anonymous namespace
 bool isInAnonymousNamespace(const clang::Decl* d);
@@ -36,9 +35,6 @@ std::string getRecordProto(const hdoc::types::RecordSymbol& c);
 /// @brief Convert a clang::Expr to a string, like clang::Decl->getNameAsString()
 std::string exprToString(const clang::Expr* expr, clang::PrintingPolicy printingPolicy);
 
-/// @brief Build a SymbolID from a decl
-hdoc::types::SymbolID buildID(const clang::NamedDecl* d);
-
 /// @brief Get the Doxygen command name (i.e. brief, param, returns) from a CommandID
 std::string getCommandName(const unsigned& CommandID);
 std::string getParaCommentContents(const clang::comments::Comment* comment, clang::ASTContext& ctx);
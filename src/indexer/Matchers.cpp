@@ -10,7 +10,7 @@
 #include <string>
 
 /// @brief Try to get a SymbolID from a QualType, and return an empty SymbolID if it's not possible
-static hdoc::types::SymbolID getTypeSymbolID(const clang::QualType& typ) {
+static hdoc::types::SymbolID getTypeSymbolID(const clang::QualType& typ, hdoc::indexer::TUContext* ctx) {
   // Get a TagDecl from the QualType, stripping pointers and references if needed.
   // Pointers and references look like different types to clang. If we want to
   // have working links in our documentation, types need to have consistent IDs
@@ -32,36 +32,43 @@ static hdoc::types::SymbolID getTypeSymbolID(const clang::QualType& typ) {
   // Otherwise clang will consider the specialized type distinct from the non-specialized
   // type and unnecessarily give it a different ID.
   if (const auto* nonspec = getNonSpecializedVersionOfDecl((clang::TagDecl*)ret)) {
-    return buildID(nonspec);
+    return ctx->buildID(nonspec);
   } else if (ret == NULL) {
     return hdoc::types::SymbolID();
   } else {
-    return buildID(ret);
+    return ctx->buildID(ret);
   }
 }
 
 void hdoc::indexer::matchers::FunctionMatcher::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
-  const auto res = Result.Nodes.getNodeAs<clang::FunctionDecl>("function");
+  this->process(Result.Nodes.getNodeAs<clang::FunctionDecl>("function"));
+}
 
+void hdoc::indexer::matchers::FunctionMatcher::process(const clang::FunctionDecl* res) {
   // Count the number of functions matched
   this->index->functions.numMatches++;
 
+  // Skip decls in files that another TU is responsible for indexing
+  if (res != nullptr && !this->ctx->owns(res)) {
+    return;
+  }
+
   // Ignore invalid matches, matches in ignored files, and static functions
   if (res == nullptr || res->isOverloadedOperator() ||
-      isInIgnoreList(res, this->cfg->ignorePaths, this->cfg->rootDir) || !res->getSourceRange().isValid() ||
+      isInIgnoreList(res, this->ctx) || !res->getSourceRange().isValid() ||
       (res->isStatic() && !res->isCXXClassMember()) || isInAnonymousNamespace(res) ||
       (res->getAccess() == clang::AS_private && cfg->ignorePrivateMembers == true)) {
     return;
   }
 
-  const hdoc::types::SymbolID ID = buildID(res);
-  if (this->index->functions.contains(ID)) {
+  const hdoc::types::SymbolID ID     = this->ctx->buildID(res);
+  hdoc::types::IndexClaims*   claims = this->ctx->getSymbolClaims();
+  if (!this->index->functions.tryReserve(ID, claims ? &claims->functions : nullptr)) {
     return;
   }
-  this->index->functions.reserve(ID);
   hdoc::types::FunctionSymbol f;
   f.ID = ID;
-  fillOutSymbol(f, res, this->cfg->rootDir);
+  fillOutSymbol(f, res, this->ctx);
 
   // Get a bunch of qualifiers
   f.isVariadic   = res->isVariadic();
@@ -93,7 +100,7 @@ void hdoc::indexer::matchers::FunctionMatcher::run(const clang::ast_matchers::Ma
     hdoc::types::FunctionParam a;
     a.name      = i->getNameAsString();
     a.type.name = i->getType().getAsString(pp);
-    a.type.id   = getTypeSymbolID(i->getType());
+    a.type.id   = getTypeSymbolID(i->getType(), this->ctx);
     if (i->hasDefaultArg()) {
       a.defaultValue = i->hasUninstantiatedDefaultArg() ? exprToString(i->getUninstantiatedDefaultArg(), pp)
                                                         : exprToString(i->getDefaultArg(), pp);
@@ -132,24 +139,31 @@ void hdoc::indexer::matchers::FunctionMatcher::run(const clang::ast_matchers::Ma
   f.isCtorOrDtor = clang::isa<clang::CXXConstructorDecl>(res) || clang::isa<clang::CXXDestructorDecl>(res);
   if (f.isCtorOrDtor == false) {
     f.returnType.name = res->getReturnType().getAsString(pp);
-    f.returnType.id   = getTypeSymbolID(res->getReturnType());
+    f.returnType.id   = getTypeSymbolID(res->getReturnType(), this->ctx);
   }
   f.proto          = getFunctionSignature(f);
   f.isRecordMember = res->isCXXClassMember();
 
-  findParentNamespace(f, res);
+  findParentNamespace(f, res, this->ctx);
   this->index->functions.update(f.ID, f);
 }
 
 void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
-  const auto res = Result.Nodes.getNodeAs<clang::CXXRecordDecl>("record");
+  this->process(Result.Nodes.getNodeAs<clang::CXXRecordDecl>("record"));
+}
 
+void hdoc::indexer::matchers::RecordMatcher::process(const clang::CXXRecordDecl* res) {
   // Count the number of records matched
   this->index->records.numMatches++;
 
+  // Skip decls in files that another TU is responsible for indexing
+  if (res != nullptr && !this->ctx->owns(res)) {
+    return;
+  }
+
   // Ignore invalid matches
   if (res == nullptr || !res->isCompleteDefinition() || !res->getSourceRange().isValid() ||
-      isInIgnoreList(res, this->cfg->ignorePaths, this->cfg->rootDir) || isInAnonymousNamespace(res)) {
+      isInIgnoreList(res, this->ctx) || isInAnonymousNamespace(res)) {
     return;
   }
 
@@ -174,14 +188,14 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
     }
   }
 
-  const hdoc::types::SymbolID ID = buildID(res);
-  if (this->index->records.contains(ID)) {
+  const hdoc::types::SymbolID ID     = this->ctx->buildID(res);
+  hdoc::types::IndexClaims*   claims = this->ctx->getSymbolClaims();
+  if (!this->index->records.tryReserve(ID, claims ? &claims->records : nullptr)) {
     return;
   }
-  this->index->records.reserve(ID);
   hdoc::types::RecordSymbol c;
   c.ID = ID;
-  fillOutSymbol(c, res, this->cfg->rootDir);
+  fillOutSymbol(c, res, this->ctx);
 
   // Apply the cached name found earlier for suspected typedef'ed decls
   if (c.name == "") {
@@ -195,20 +209,20 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
   // Get methods and decls (what's the difference?) for this record
   for (const auto* m : res->methods()) {
     if (m == nullptr || m->isImplicit() || m->isOverloadedOperator() ||
-        isInIgnoreList(m, this->cfg->ignorePaths, this->cfg->rootDir) || isInAnonymousNamespace(m) ||
+        isInIgnoreList(m, this->ctx) || isInAnonymousNamespace(m) ||
         (m->getAccess() == clang::AS_private && cfg->ignorePrivateMembers == true)) {
       continue;
     }
-    c.methodIDs.emplace_back(buildID(m->getCanonicalDecl()));
+    c.methodIDs.emplace_back(this->ctx->buildID(m->getCanonicalDecl()));
   }
   for (const auto* d : res->decls()) {
     if (const auto* ftd = llvm::dyn_cast<clang::FunctionTemplateDecl>(d)) {
       if (ftd == nullptr || ftd->isImplicit() || ftd->getAsFunction()->isOverloadedOperator() ||
-          isInIgnoreList(ftd, this->cfg->ignorePaths, this->cfg->rootDir) || isInAnonymousNamespace(ftd) ||
+          isInIgnoreList(ftd, this->ctx) || isInAnonymousNamespace(ftd) ||
           (ftd->getAccess() == clang::AS_private && cfg->ignorePrivateMembers == true)) {
         continue;
       }
-      c.methodIDs.emplace_back(buildID(ftd));
+      c.methodIDs.emplace_back(this->ctx->buildID(ftd));
     }
   }
 
@@ -219,11 +233,12 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
         // add std prefix for records that are in that namespace
         if (baseRecord->isInStdNamespace()) {
           c.baseRecords.push_back(
-              {buildID(baseRecord), base.getAccessSpecifier(), "std::" + baseRecord->getNameAsString()});
+              {this->ctx->buildID(baseRecord), base.getAccessSpecifier(), "std::" + baseRecord->getNameAsString()});
         }
         // Records that should be in the DB
         else {
-          c.baseRecords.push_back({buildID(baseRecord), base.getAccessSpecifier(), baseRecord->getNameAsString()});
+          c.baseRecords.push_back(
+              {this->ctx->buildID(baseRecord), base.getAccessSpecifier(), baseRecord->getNameAsString()});
         }
       }
     }
@@ -297,7 +312,7 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
       mv.type.name = "anonymous struct/union";
     } else {
       mv.type.name = field->getType().getAsString(pp);
-      mv.type.id   = getTypeSymbolID(field->getType());
+      mv.type.id   = getTypeSymbolID(field->getType(), this->ctx);
     }
 
     const clang::comments::Comment* comment = res->getASTContext().getCommentForDecl(field, nullptr);
@@ -330,7 +345,7 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
         mv.type.name = "anonymous struct/union";
       } else {
         mv.type.name = vd->getType().getAsString(pp);
-        mv.type.id   = getTypeSymbolID(vd->getType());
+        mv.type.id   = getTypeSymbolID(vd->getType(), this->ctx);
       }
 
       const clang::comments::Comment* comment = res->getASTContext().getCommentForDecl(vd, nullptr);
@@ -351,30 +366,37 @@ void hdoc::indexer::matchers::RecordMatcher::run(const clang::ast_matchers::Matc
     processSymbolComment(c, comment, res->getASTContext());
   }
 
-  findParentNamespace(c, res);
+  findParentNamespace(c, res, this->ctx);
   this->index->records.update(c.ID, c);
 }
 
 void hdoc::indexer::matchers::EnumMatcher::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
-  const auto res = Result.Nodes.getNodeAs<clang::EnumDecl>("enum");
+  this->process(Result.Nodes.getNodeAs<clang::EnumDecl>("enum"));
+}
 
+void hdoc::indexer::matchers::EnumMatcher::process(const clang::EnumDecl* res) {
   // Count the number of classes matched
   this->index->enums.numMatches++;
 
+  // Skip decls in files that another TU is responsible for indexing
+  if (res != nullptr && !this->ctx->owns(res)) {
+    return;
+  }
+
   // Ignore invalid matches and anonymous enums
   if (res == nullptr || res->getNameAsString() == "" ||
-      isInIgnoreList(res, this->cfg->ignorePaths, this->cfg->rootDir) || isInAnonymousNamespace(res)) {
+      isInIgnoreList(res, this->ctx) || isInAnonymousNamespace(res)) {
     return;
   }
 
-  const hdoc::types::SymbolID ID = buildID(res);
-  if (this->index->enums.contains(ID)) {
+  const hdoc::types::SymbolID ID     = this->ctx->buildID(res);
+  hdoc::types::IndexClaims*   claims = this->ctx->getSymbolClaims();
+  if (!this->index->enums.tryReserve(ID, claims ? &claims->enums : nullptr)) {
     return;
   }
-  this->index->enums.reserve(ID);
   hdoc::types::EnumSymbol e;
   e.ID = ID;
-  fillOutSymbol(e, res, this->cfg->rootDir);
+  fillOutSymbol(e, res, this->ctx);
 
   if (const auto* parent = llvm::dyn_cast<clang::CXXRecordDecl>(res->getParent())) {
     e.name = parent->getNameAsString() + "::" + e.name;
@@ -413,31 +435,38 @@ void hdoc::indexer::matchers::EnumMatcher::run(const clang::ast_matchers::MatchF
     processSymbolComment(e, comment, res->getASTContext());
   }
 
-  findParentNamespace(e, res);
+  findParentNamespace(e, res, this->ctx);
   this->index->enums.update(e.ID, e);
 }
 
 void hdoc::indexer::matchers::NamespaceMatcher::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
-  const auto res = Result.Nodes.getNodeAs<clang::NamespaceDecl>("namespace");
+  this->process(Result.Nodes.getNodeAs<clang::NamespaceDecl>("namespace"));
+}
 
+void hdoc::indexer::matchers::NamespaceMatcher::process(const clang::NamespaceDecl* res) {
   // Count the number of namespaces matched
   this->index->namespaces.numMatches++;
 
+  // Skip decls in files that another TU is responsible for indexing
+  if (res != nullptr && !this->ctx->owns(res)) {
+    return;
+  }
+
   // Ignore invalid matches and anonymous enums
   if (res == nullptr || res->getNameAsString() == "" ||
-      isInIgnoreList(res, this->cfg->ignorePaths, this->cfg->rootDir) || isInAnonymousNamespace(res)) {
+      isInIgnoreList(res, this->ctx) || isInAnonymousNamespace(res)) {
     return;
   }
 
-  const hdoc::types::SymbolID ID = buildID(res);
-  if (this->index->namespaces.contains(ID)) {
+  const hdoc::types::SymbolID ID     = this->ctx->buildID(res);
+  hdoc::types::IndexClaims*   claims = this->ctx->getSymbolClaims();
+  if (!this->index->namespaces.tryReserve(ID, claims ? &claims->namespaces : nullptr)) {
     return;
   }
-  this->index->namespaces.reserve(ID);
   hdoc::types::NamespaceSymbol n;
   n.ID = ID;
-  fillOutSymbol(n, res, this->cfg->rootDir);
+  fillOutSymbol(n, res, this->ctx);
 
-  findParentNamespace(n, res);
+  findParentNamespace(n, res, this->ctx);
   this->index->namespaces.update(n.ID, n);
 }
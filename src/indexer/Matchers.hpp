@@ -7,6 +7,7 @@
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchersMacros.h"
 
+#include "indexer/TUContext.hpp"
 #include "types/Config.hpp"
 #include "types/Index.hpp"
 
@@ -14,38 +15,27 @@
 
 namespace hdoc::indexer::matchers {
 
-AST_MATCHER_P2(clang::Decl, shouldBeIgnored, std::vector<std::string>, ignoreList, std::filesystem::path, rootDir) {
+AST_MATCHER_P(clang::Decl, shouldBeIgnored, hdoc::indexer::TUContext*, ctx) {
   (void)Builder; // Avoid unused variable warning
-  if (ignoreList.size() == 0) {
-    return false;
-  }
-
   auto& sourceManager = Finder->getASTContext().getSourceManager();
   auto  expansionLoc  = sourceManager.getExpansionLoc(Node.getBeginLoc());
   if (expansionLoc.isInvalid()) {
     return false;
   }
-
-  auto fileEntry = sourceManager.getFileEntryForID(sourceManager.getFileID(expansionLoc));
-  if (!fileEntry) {
-    return false;
-  }
-
-  auto filename = std::filesystem::relative(std::filesystem::path(fileEntry->getName().str()), rootDir).string();
-  for (const auto& substr : ignoreList) {
-    if (filename.find(substr) != std::string::npos) {
-      return true;
-    }
-  }
-  return false;
+  return ctx->getFileInfo(sourceManager.getFileID(expansionLoc), sourceManager).ignored;
+}
 } // namespace internal
 
 class RecordMatcher : public clang::ast_matchers::MatchFinder::MatchCallback {
 public:
   virtual void run(const clang::ast_matchers::MatchFinder::MatchResult& Result);
-  RecordMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
+  /// @brief Index a decl that was either matched by getMatcher() or found by the IndexVisitor
+  void process(const clang::CXXRecordDecl* res);
+  RecordMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg, hdoc::indexer::TUContext* ctx)
+      : index(index), cfg(cfg), ctx(ctx) {}
   hdoc::types::Index*        index;
   const hdoc::types::Config* cfg;
+  hdoc::indexer::TUContext*  ctx;
 
   clang::ast_matchers::DeclarationMatcher getMatcher() {
     return clang::ast_matchers::cxxRecordDecl(
@@ -59,7 +49,7 @@ public:
                    clang::ast_matchers::isTemplateInstantiation(),
                    clang::ast_matchers::isInstantiated(),
                    clang::ast_matchers::isExplicitTemplateSpecialization(),
-                   hdoc::indexer::matchers::shouldBeIgnored(this->cfg->ignorePaths, this->cfg->rootDir))))
+                   hdoc::indexer::matchers::shouldBeIgnored(this->ctx))))
         .bind("record");
   }
 };
@@ -67,9 +57,13 @@ public:
 class FunctionMatcher : public clang::ast_matchers::MatchFinder::MatchCallback {
 public:
   virtual void run(const clang::ast_matchers::MatchFinder::MatchResult& Result);
-  FunctionMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
+  /// @brief Index a decl that was either matched by getMatcher() or found by the IndexVisitor
+  void process(const clang::FunctionDecl* res);
+  FunctionMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg, hdoc::indexer::TUContext* ctx)
+      : index(index), cfg(cfg), ctx(ctx) {}
   hdoc::types::Index*        index;
   const hdoc::types::Config* cfg;
+  hdoc::indexer::TUContext*  ctx;
 
   clang::ast_matchers::DeclarationMatcher getMatcher() {
     return clang::ast_matchers::functionDecl(
@@ -82,7 +76,7 @@ public:
                    clang::ast_matchers::isTemplateInstantiation(),
                    clang::ast_matchers::isInstantiated(),
                    clang::ast_matchers::isExplicitTemplateSpecialization(),
-                   hdoc::indexer::matchers::shouldBeIgnored(this->cfg->ignorePaths, this->cfg->rootDir))))
+                   hdoc::indexer::matchers::shouldBeIgnored(this->ctx))))
         .bind("function");
   }
 };
@@ -90,9 +84,13 @@ public:
 class EnumMatcher : public clang::ast_matchers::MatchFinder::MatchCallback {
 public:
   virtual void run(const clang::ast_matchers::MatchFinder::MatchResult& Result);
-  EnumMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
+  /// @brief Index a decl that was either matched by getMatcher() or found by the IndexVisitor
+  void process(const clang::EnumDecl* res);
+  EnumMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg, hdoc::indexer::TUContext* ctx)
+      : index(index), cfg(cfg), ctx(ctx) {}
   hdoc::types::Index*                     index;
   const hdoc::types::Config*              cfg;
+  hdoc::indexer::TUContext*               ctx;
   clang::ast_matchers::DeclarationMatcher getMatcher() {
     return clang::ast_matchers::enumDecl(
                clang::ast_matchers::isDefinition(),
@@ -103,7 +101,7 @@ public:
                    clang::ast_matchers::isInStdNamespace(),
                    clang::ast_matchers::isExpansionInSystemHeader(),
                    clang::ast_matchers::isImplicit(),
-                   hdoc::indexer::matchers::shouldBeIgnored(this->cfg->ignorePaths, this->cfg->rootDir))))
+                   hdoc::indexer::matchers::shouldBeIgnored(this->ctx))))
         .bind("enum");
   }
 };
@@ -111,9 +109,13 @@ public:
 class NamespaceMatcher : public clang::ast_matchers::MatchFinder::MatchCallback {
 public:
   virtual void run(const clang::ast_matchers::MatchFinder::MatchResult& Result);
-  NamespaceMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
+  /// @brief Index a decl that was either matched by getMatcher() or found by the IndexVisitor
+  void process(const clang::NamespaceDecl* res);
+  NamespaceMatcher(hdoc::types::Index* index, const hdoc::types::Config* cfg, hdoc::indexer::TUContext* ctx)
+      : index(index), cfg(cfg), ctx(ctx) {}
   hdoc::types::Index*                     index;
   const hdoc::types::Config*              cfg;
+  hdoc::indexer::TUContext*               ctx;
   clang::ast_matchers::DeclarationMatcher getMatcher() {
     return clang::ast_matchers::namespaceDecl(
                clang::ast_matchers::unless(clang::ast_matchers::anyOf(
@@ -122,7 +124,7 @@ public:
                    clang::ast_matchers::isInStdNamespace(),
                    clang::ast_matchers::isExpansionInSystemHeader(),
                    clang::ast_matchers::isImplicit(),
-                   hdoc::indexer::matchers::shouldBeIgnored(this->cfg->ignorePaths, this->cfg->rootDir))))
+                   hdoc::indexer::matchers::shouldBeIgnored(this->ctx))))
         .bind("namespace");
   }
 };
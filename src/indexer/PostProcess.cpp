@@ -0,0 +1,204 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/PostProcess.hpp"
+#include "support/Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(const Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+namespace {
+/// What was found while traversing one partition of a Database, which is applied once all partitions are done
+struct Partition {
+  double                             time       = 0; ///< Time taken to traverse the partition
+  uint64_t                           numVisited = 0; ///< Symbols in the partition
+  uint64_t                           numLookups = 0; ///< Lookups of other symbols while traversing the partition
+  std::vector<hdoc::types::SymbolID> pruned;         ///< Symbols to remove from the Index
+  std::vector<std::pair<hdoc::types::NamespaceSymbol*, hdoc::types::SymbolID>> children; ///< Children of namespaces
+};
+} // namespace
+
+/// Call fn on every entry of db on the thread pool, with the entries split into one partition per element of
+/// partitions. Partitions are ranges of buckets of the hash map, so they're found without traversing db first.
+/// Each partition is traced under name.
+template <typename T, typename Fn>
+static void forEachPartition(const llvm::StringRef     name,
+                             hdoc::types::Database<T>& db,
+                             std::vector<Partition>&   partitions,
+                             llvm::ThreadPool&         pool,
+                             Fn                        fn) {
+  const size_t numBuckets    = db.entries.bucket_count();
+  const size_t numPartitions = partitions.size();
+  for (size_t p = 0; p < numPartitions; p++) {
+    pool.async([name, &db, &partitions, fn, p, numBuckets, numPartitions]() {
+      hdoc::utils::TraceScope trace(name);
+      const auto              start = Clock::now();
+      Partition&              out   = partitions[p];
+      for (size_t b = numBuckets * p / numPartitions; b < numBuckets * (p + 1) / numPartitions; b++) {
+        for (auto it = db.entries.begin(b); it != db.entries.end(b); ++it) {
+          fn(it->first, it->second, out);
+          out.numVisited++;
+        }
+      }
+      out.time = msSince(start);
+    });
+  }
+}
+
+/// Reset a TypeRef that points to a record that isn't in the Index
+static void pruneTypeRef(hdoc::types::TypeRef& ref, const hdoc::types::Index& index, Partition& out) {
+  out.numLookups++;
+  if (index.records.contains(ref.id) == false) {
+    ref.id = hdoc::types::SymbolID();
+  }
+}
+
+/// Record the parent of a symbol as a child to be added to it, if the parent is a namespace
+static void findParentNamespace(const hdoc::types::Symbol& s, hdoc::types::Index& index, Partition& out) {
+  // The namespace itself is only modified once every partition is done
+  out.numLookups++;
+  const auto it = index.namespaces.entries.find(s.parentNamespaceID);
+  if (it != index.namespaces.entries.end()) {
+    out.children.emplace_back(&it->second, s.ID);
+  }
+}
+
+void hdoc::indexer::addBaseRecordsToProto(hdoc::types::RecordSymbol& c) {
+  if (c.baseRecords.size() > 0) {
+    uint64_t count = 0;
+    c.proto += " : ";
+    for (const auto& baseRecord : c.baseRecords) {
+      if (count > 0) {
+        c.proto += ", ";
+      }
+
+      // Print the access type that indicates which kind of inheritance was used
+      switch (baseRecord.access) {
+      case clang::AS_public:
+        c.proto += "public ";
+        break;
+      case clang::AS_private:
+        c.proto += "private ";
+        break;
+      case clang::AS_protected:
+        c.proto += "protected ";
+        break;
+      case clang::AS_none:
+      // intentional fallthrough
+      default:
+        break;
+      }
+
+      c.proto += baseRecord.name;
+      count++;
+    }
+  }
+}
+
+/// Sum the traversal times of a set of partitions, and add their counts to stats
+static double totalTime(const std::vector<Partition>& partitions, hdoc::indexer::PostProcessStats& stats) {
+  double time = 0;
+  for (const auto& p : partitions) {
+    time += p.time;
+    stats.numVisited += p.numVisited;
+    stats.numLookups += p.numLookups;
+  }
+  return time;
+}
+
+hdoc::indexer::PostProcessStats hdoc::indexer::postProcess(hdoc::types::Index& index, llvm::ThreadPool& pool) {
+  PostProcessStats stats;
+  const auto       start = Clock::now();
+
+  // During the traversal symbols are only modified by the partition that contains them, and only the keys of the
+  // other databases are read, so the partitions of all databases can be processed at the same time.
+  const size_t           numPartitions = std::max<size_t>(pool.getThreadCount(), 1);
+  std::vector<Partition> functions(numPartitions);
+  std::vector<Partition> records(numPartitions);
+  std::vector<Partition> enums(numPartitions);
+  std::vector<Partition> namespaces(numPartitions);
+
+  const auto processFunction = [&index](const auto& id, auto& f, Partition& out) {
+    // If a method's parent isn't in the index, it was filtered out and not indexed.
+    // ergo, it shouldn't be indexed either, so it's removed
+    if (f.isRecordMember) {
+      out.numLookups++;
+      if (!index.records.contains(f.parentNamespaceID)) {
+        out.pruned.emplace_back(id);
+        return;
+      }
+    }
+    pruneTypeRef(f.returnType, index, out);
+    for (auto& param : f.params) {
+      pruneTypeRef(param.type, index, out);
+    }
+  };
+  const auto processRecord = [&index](const auto&, auto& c, Partition& out) {
+    for (auto& var : c.vars) {
+      pruneTypeRef(var.type, index, out);
+    }
+    hdoc::indexer::addBaseRecordsToProto(c);
+    findParentNamespace(c, index, out);
+  };
+  const auto processChild = [&index](const auto&, auto& s, Partition& out) { findParentNamespace(s, index, out); };
+
+  forEachPartition("Post-process functions", index.functions, functions, pool, processFunction);
+  forEachPartition("Post-process records", index.records, records, pool, processRecord);
+  forEachPartition("Post-process enums", index.enums, enums, pool, processChild);
+  forEachPartition("Post-process namespaces", index.namespaces, namespaces, pool, processChild);
+  pool.wait();
+  stats.traversalTime  = msSince(start);
+  stats.functionsTime  = totalTime(functions, stats);
+  stats.recordsTime    = totalTime(records, stats);
+  stats.enumsTime      = totalTime(enums, stats);
+  stats.namespacesTime = totalTime(namespaces, stats);
+
+  // Each type of child is added to a different vector of NamespaceSymbol, so the three can be done concurrently
+  const auto linkStart = Clock::now();
+  pool.async([&records]() {
+    hdoc::utils::TraceScope trace("Link namespace records");
+    for (const auto& p : records) {
+      for (const auto& [ns, child] : p.children) {
+        ns->records.emplace_back(child);
+      }
+    }
+  });
+  pool.async([&enums]() {
+    hdoc::utils::TraceScope trace("Link namespace enums");
+    for (const auto& p : enums) {
+      for (const auto& [ns, child] : p.children) {
+        ns->enums.emplace_back(child);
+      }
+    }
+  });
+  pool.async([&namespaces]() {
+    hdoc::utils::TraceScope trace("Link namespace namespaces");
+    for (const auto& p : namespaces) {
+      for (const auto& [ns, child] : p.children) {
+        ns->namespaces.emplace_back(child);
+      }
+    }
+  });
+  pool.wait();
+  stats.linkTime = msSince(linkStart);
+
+  const auto              eraseStart = Clock::now();
+  hdoc::utils::TraceScope traceErase("Prune methods");
+  for (const auto& p : functions) {
+    for (const auto& id : p.pruned) {
+      index.functions.entries.erase(id);
+    }
+    stats.numPrunedMethods += p.pruned.size();
+  }
+  stats.eraseTime = msSince(eraseStart);
+  stats.totalTime = msSince(start);
+  return stats;
+}
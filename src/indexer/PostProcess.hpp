@@ -0,0 +1,41 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include "llvm/Support/ThreadPool.h"
+
+#include "types/Index.hpp"
+
+namespace hdoc::indexer {
+/// @brief How long each step of postProcess() took, in milliseconds, and how much it changed
+struct PostProcessStats {
+  double   functionsTime    = 0; ///< Pruning orphaned methods and dangling TypeRefs, summed over all threads
+  double   recordsTime      = 0; ///< Pruning dangling TypeRefs and adding base records to prototypes, summed likewise
+  double   enumsTime        = 0; ///< Finding the parent namespace of enums, summed likewise
+  double   namespacesTime   = 0; ///< Finding the parent namespace of namespaces, summed likewise
+  double   traversalTime    = 0; ///< Wall-clock time of traversing all of the databases concurrently
+  double   linkTime         = 0; ///< Adding the children that were found to their namespaces
+  double   eraseTime        = 0; ///< Removing orphaned methods from the Index
+  double   totalTime        = 0; ///< Wall-clock time of the whole post-processing stage
+  uint64_t numPrunedMethods = 0; ///< Number of methods whose record isn't in the Index
+  uint64_t numVisited       = 0; ///< Number of symbols visited while traversing the databases
+  uint64_t numLookups       = 0; ///< Number of lookups of other symbols while traversing the databases
+};
+
+/// @brief Prepare an Index for serialization once every TU has been indexed.
+///
+/// - Methods of records that aren't in the Index were filtered out, so they are removed.
+/// - TypeRefs to records that aren't in the Index, for example in third-party libraries, are reset to avoid dead
+///   links.
+/// - The prototype of each record is updated with the records it inherits from, which might not have been indexed
+///   yet when the record was.
+/// - Each NamespaceSymbol gets the IDs of its direct children.
+///
+/// All of these only need to look up other symbols, so each database is traversed once, split into partitions that
+/// are processed in parallel on pool.
+PostProcessStats postProcess(hdoc::types::Index& index, llvm::ThreadPool& pool);
+
+/// @brief Update the declaration of a record to indicate the records it inherits from and the type of inheritance
+void addBaseRecordsToProto(hdoc::types::RecordSymbol& c);
+} // namespace hdoc::indexer
@@ -0,0 +1,517 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/SpilledIndex.hpp"
+#include "serde/BinarySerde.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <queue>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(const Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool lessByID(const hdoc::types::SymbolID& lhs, const hdoc::types::SymbolID& rhs) {
+  return lhs.raw() < rhs.raw();
+}
+
+namespace {
+/// Runs are written in chunks of this many bytes, so that a run is never encoded in memory all at once
+constexpr size_t chunkSize = 1 << 20;
+
+/// Names of the files holding each Database of a run, and of the store
+constexpr const char* functionsKind  = "functions";
+constexpr const char* recordsKind    = "records";
+constexpr const char* enumsKind      = "enums";
+constexpr const char* namespacesKind = "namespaces";
+
+/// A stream of symbols sorted by SymbolID, read from a run or from a Database that's still in memory
+template <typename T> class Cursor {
+public:
+  explicit Cursor(std::unique_ptr<llvm::MemoryBuffer> run) : run(std::move(run)), reader(this->run->getBuffer()) {}
+
+  /// Symbols are moved out of db when they're read, but db is left as is if only their SymbolIDs are needed
+  explicit Cursor(hdoc::types::Database<T>& db) : reader("") {
+    this->resident.reserve(db.entries.size());
+    for (auto& [id, symbol] : db.entries) {
+      this->resident.emplace_back(id, &symbol);
+    }
+    std::sort(this->resident.begin(), this->resident.end(), [](const auto& lhs, const auto& rhs) {
+      return lessByID(lhs.first, rhs.first);
+    });
+  }
+
+  /// @brief Move to the next symbol, returning false once there are none left
+  bool next() {
+    if (this->run == nullptr) {
+      if (this->pos >= this->resident.size()) {
+        return false;
+      }
+      this->id = this->resident[this->pos++].first;
+      return true;
+    }
+
+    if (this->reader.done()) {
+      return false;
+    }
+    this->id      = this->reader.readID();
+    this->encoded = this->reader.readStringRef();
+    if (!this->reader.ok()) {
+      spdlog::error("Spilled symbols in {} are corrupt, the rest of them are skipped.",
+                    this->run->getBufferIdentifier().str());
+      return false;
+    }
+    return true;
+  }
+
+  /// @brief Get the current symbol
+  T symbol() {
+    if (this->run == nullptr) {
+      return std::move(*this->resident[this->pos - 1].second);
+    }
+    T                         s;
+    hdoc::serde::BinaryReader symbolReader(this->encoded);
+    symbolReader.read(s);
+    return s;
+  }
+
+  hdoc::types::SymbolID id; ///< SymbolID of the current symbol
+
+private:
+  std::unique_ptr<llvm::MemoryBuffer>               run;      ///< Run being read, or null if reading from memory
+  hdoc::serde::BinaryReader                         reader;   ///< Position in run
+  llvm::StringRef                                   encoded;  ///< Current symbol, as encoded in run
+  std::vector<std::pair<hdoc::types::SymbolID, T*>> resident; ///< Symbols in memory, sorted by SymbolID
+  size_t                                            pos = 0;  ///< Position in resident of the next symbol
+};
+
+/// @brief Writes the symbols of a Database to the store, remembering where each one is so that it can be read back
+template <typename T> class StoreWriter {
+public:
+  explicit StoreWriter(const std::filesystem::path& path) : path(path), os(path.string(), ec) {}
+
+  /// @brief Add a symbol to the store. Thread-compatible, every Database is written by a single thread.
+  void add(const hdoc::types::SymbolID& id, const T& symbol) {
+    if (this->ec) {
+      return;
+    }
+    this->entries.push_back({symbol.name, id, this->numBytes});
+    this->buf.clear();
+    hdoc::serde::BinaryWriter writer(this->buf);
+    writer.write(symbol);
+    this->os << this->buf;
+    this->numBytes += this->buf.size();
+  }
+
+  /// @brief Close the store and read it back into stored, sorted by name like any other FrozenDatabase
+  void finish(hdoc::indexer::SpilledIndex::Stored<T>& stored, const uint32_t numMatches) {
+    this->os.close();
+    if (!this->ec && this->os.has_error()) {
+      this->ec = this->os.error();
+    }
+    this->os.clear_error();
+    if (this->ec) {
+      spdlog::error("Unable to write symbols to {} ({}), they will be missing from hdoc's output.",
+                    this->path.string(),
+                    this->ec.message());
+      return;
+    }
+
+    // Stores are usually large enough to be memory-mapped, so symbols are only paged in when they're read
+    auto buffer = llvm::MemoryBuffer::getFile(this->path.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+      spdlog::error("Unable to read symbols from {} ({}), they will be missing from hdoc's output.",
+                    this->path.string(),
+                    buffer.getError().message());
+      return;
+    }
+
+    // Ties are broken by SymbolID, the same way as for a FrozenDatabase built from memory
+    std::sort(this->entries.begin(), this->entries.end(), [](const Entry& lhs, const Entry& rhs) {
+      return lhs.name != rhs.name ? lhs.name < rhs.name : lessByID(lhs.id, rhs.id);
+    });
+    std::vector<std::pair<hdoc::types::SymbolID, uint64_t>> offsets;
+    offsets.reserve(this->entries.size());
+    for (const Entry& entry : this->entries) {
+      offsets.emplace_back(entry.id, entry.offset);
+    }
+    this->entries = {};
+
+    std::shared_ptr<llvm::MemoryBuffer> data = std::move(*buffer);
+    stored.db                                = hdoc::types::FrozenDatabase<T>(std::move(data), offsets, numMatches);
+    stored.numBytes                          = this->numBytes;
+  }
+
+private:
+  struct Entry {
+    std::string           name;   ///< Name of the symbol, which FrozenDatabases are sorted by
+    hdoc::types::SymbolID id;     ///< SymbolID of the symbol
+    uint64_t              offset; ///< Where the symbol is encoded in the store
+  };
+
+  std::filesystem::path path;
+  std::error_code       ec;           ///< Set if the store couldn't be opened or written, declared before os
+  llvm::raw_fd_ostream  os;
+  std::string           buf;          ///< Encoding of the last symbol that was added
+  std::vector<Entry>    entries;      ///< Every symbol that was added
+  uint64_t              numBytes = 0; ///< Size of the store so far
+};
+} // namespace
+
+/// Write the symbols of db to path, sorted by SymbolID, and add the size of the run to numBytes.
+/// Each symbol is written as its SymbolID followed by the symbol encoded as a string, so that runs can be merged
+/// without decoding symbols that aren't needed.
+template <typename T>
+static std::error_code
+writeRun(const std::filesystem::path& path, const hdoc::types::Database<T>& db, uint64_t& numBytes) {
+  std::vector<const std::pair<const hdoc::types::SymbolID, T>*> entries;
+  entries.reserve(db.entries.size());
+  for (const auto& entry : db.entries) {
+    entries.emplace_back(&entry);
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) {
+    return lessByID(lhs->first, rhs->first);
+  });
+
+  std::error_code      ec;
+  llvm::raw_fd_ostream os(path.string(), ec);
+  if (ec) {
+    return ec;
+  }
+  std::string               buf;
+  std::string               symbol;
+  hdoc::serde::BinaryWriter writer(buf);
+  hdoc::serde::BinaryWriter symbolWriter(symbol);
+  for (const auto* entry : entries) {
+    symbol.clear();
+    symbolWriter.write(entry->second);
+    writer.writeID(entry->first);
+    writer.writeString(symbol);
+    if (buf.size() >= chunkSize) {
+      os << buf;
+      numBytes += buf.size();
+      buf.clear();
+    }
+  }
+  os << buf;
+  numBytes += buf.size();
+
+  os.close();
+  ec = os.error();
+  os.clear_error();
+  return ec;
+}
+
+/// Remove every symbol from db, keeping its number of matches
+template <typename T> static void clear(hdoc::types::Database<T>& db) {
+  // Swapped with an empty map so that the buckets are freed as well
+  decltype(db.entries)().swap(db.entries);
+}
+
+/// Open a Cursor for each run in paths, followed by one for the symbols that are still in db.
+/// Runs are opened in the order they were written, which is the order in which duplicate symbols are kept.
+template <typename T>
+static std::vector<Cursor<T>> openCursors(const std::vector<std::filesystem::path>& paths,
+                                          hdoc::types::Database<T>&                 db) {
+  std::vector<Cursor<T>> cursors;
+  cursors.reserve(paths.size() + 1);
+  for (const auto& path : paths) {
+    auto buffer = llvm::MemoryBuffer::getFile(path.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+      spdlog::error("Unable to read spilled symbols from {} ({}), they will be missing from hdoc's output.",
+                    path.string(),
+                    buffer.getError().message());
+      continue;
+    }
+    cursors.emplace_back(std::move(*buffer));
+  }
+  cursors.emplace_back(db);
+  return cursors;
+}
+
+/// Call fn on every symbol of cursors in order of SymbolID. If several cursors have the same symbol, fn is only called
+/// with the first of them, which matches how Database::merge() keeps the first copy of each symbol.
+template <typename T, typename Fn> static void merge(std::vector<Cursor<T>>& cursors, Fn fn) {
+  // Heads are ordered by SymbolID and then by cursor, so that the first cursor with a symbol is popped first
+  using Head = std::pair<uint64_t, size_t>;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  for (size_t i = 0; i < cursors.size(); i++) {
+    if (cursors[i].next()) {
+      heads.emplace(cursors[i].id.raw(), i);
+    }
+  }
+
+  std::optional<uint64_t> previous;
+  while (!heads.empty()) {
+    const auto [id, i] = heads.top();
+    heads.pop();
+    if (previous != id) {
+      fn(cursors[i]);
+    }
+    previous = id;
+    if (cursors[i].next()) {
+      heads.emplace(cursors[i].id.raw(), i);
+    }
+  }
+}
+
+hdoc::indexer::SpilledIndex::SpilledIndex(const uint64_t threshold, const std::filesystem::path& dir)
+    : residentMemory(hdoc::utils::currentRSS), threshold(threshold) {
+  if (threshold == 0) {
+    return;
+  }
+
+  // A relative prefix is created in the temporary directory
+  std::string prefix = "hdoc-spill";
+  if (!dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    prefix = (dir / prefix).string();
+  }
+  llvm::SmallString<256> path;
+  if (const auto ec = llvm::sys::fs::createUniqueDirectory(prefix, path)) {
+    spdlog::warn("Unable to create a directory for spilled symbols ({}), keeping every symbol in memory.",
+                 ec.message());
+    return;
+  }
+  this->root = path.str().str();
+}
+
+hdoc::indexer::SpilledIndex::~SpilledIndex() {
+  if (!this->root.empty()) {
+    std::error_code ec;
+    std::filesystem::remove_all(this->root, ec);
+  }
+}
+
+std::filesystem::path hdoc::indexer::SpilledIndex::runPath(const uint32_t run, const char* kind) const {
+  return this->root / ("run-" + std::to_string(run) + "." + kind);
+}
+
+uint32_t hdoc::indexer::SpilledIndex::numRuns() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->runs.size();
+}
+
+bool hdoc::indexer::SpilledIndex::shouldSpill(const hdoc::types::Index& index) const {
+  if (!this->enabled()) {
+    return false;
+  }
+  const uint64_t numSymbols = index.functions.entries.size() + index.records.entries.size() +
+                              index.enums.entries.size() + index.namespaces.entries.size();
+  return numSymbols >= this->minSymbolsPerRun && this->residentMemory() >= this->threshold;
+}
+
+bool hdoc::indexer::SpilledIndex::spill(hdoc::types::Index& index) {
+  hdoc::utils::TraceScope trace("Spill index");
+  const uint32_t          run      = this->nextRun++;
+  uint64_t                numBytes = 0;
+
+  std::error_code ec = writeRun(this->runPath(run, functionsKind), index.functions, numBytes);
+  if (!ec) {
+    ec = writeRun(this->runPath(run, recordsKind), index.records, numBytes);
+  }
+  if (!ec) {
+    ec = writeRun(this->runPath(run, enumsKind), index.enums, numBytes);
+  }
+  if (!ec) {
+    ec = writeRun(this->runPath(run, namespacesKind), index.namespaces, numBytes);
+  }
+  if (ec) {
+    spdlog::warn("Unable to spill symbols to {} ({}), keeping them in memory.", this->root.string(), ec.message());
+    for (const char* kind : {functionsKind, recordsKind, enumsKind, namespacesKind}) {
+      llvm::sys::fs::remove(this->runPath(run, kind).string());
+    }
+    return false;
+  }
+
+  clear(index.functions);
+  clear(index.records);
+  clear(index.enums);
+  clear(index.namespaces);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->runs.emplace_back(run);
+  }
+  this->numBytesSpilled += numBytes;
+  hdoc::utils::Metrics::global().numRunsSpilled++;
+  hdoc::utils::Metrics::global().numBytesSpilled += numBytes;
+
+#if defined(__GLIBC__)
+  // The symbols were freed in many small allocations, which would otherwise stay resident in the allocator's arenas
+  // and keep memory over the threshold
+  malloc_trim(0);
+#endif
+  return true;
+}
+
+hdoc::indexer::PostProcessStats hdoc::indexer::SpilledIndex::postProcess(hdoc::types::Index& index,
+                                                                          llvm::ThreadPool&   pool) {
+  PostProcessStats stats;
+  const auto       start = Clock::now();
+
+  std::vector<uint32_t> sortedRuns;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    sortedRuns = this->runs;
+  }
+  std::sort(sortedRuns.begin(), sortedRuns.end());
+  const auto runPaths = [&](const char* kind) {
+    std::vector<std::filesystem::path> paths;
+    for (const uint32_t run : sortedRuns) {
+      paths.emplace_back(this->runPath(run, kind));
+    }
+    return paths;
+  };
+
+  // Every other symbol is added to its namespace and checks whether records exist, so namespaces and the SymbolIDs
+  // of records are merged first
+  hdoc::types::Database<hdoc::types::NamespaceSymbol> namespaces;
+  std::vector<hdoc::types::SymbolID>                  recordIDs;
+  pool.async([&]() {
+    hdoc::utils::TraceScope trace("Merge spilled namespaces");
+    const auto              passStart = Clock::now();
+    auto                    cursors   = openCursors(runPaths(namespacesKind), index.namespaces);
+    merge(cursors, [&](auto& cursor) { namespaces.entries.emplace(cursor.id, cursor.symbol()); });
+    stats.namespacesTime = msSince(passStart);
+  });
+  pool.async([&]() {
+    hdoc::utils::TraceScope trace("Merge spilled record IDs");
+    const auto              passStart = Clock::now();
+    auto                    cursors   = openCursors(runPaths(recordsKind), index.records);
+    merge(cursors, [&](auto& cursor) { recordIDs.emplace_back(cursor.id); });
+    stats.recordsTime = msSince(passStart);
+  });
+  pool.wait();
+
+  // Merged symbols come out sorted by SymbolID, so records are found with a binary search
+  const auto hasRecord = [&recordIDs](const hdoc::types::SymbolID& id) {
+    return std::binary_search(recordIDs.begin(), recordIDs.end(), id, lessByID);
+  };
+  const auto pruneTypeRef = [&hasRecord](hdoc::types::TypeRef& ref) {
+    if (!hasRecord(ref.id)) {
+      ref.id = hdoc::types::SymbolID();
+    }
+  };
+  const auto findParentNamespace = [&namespaces](const hdoc::types::Symbol& s) -> hdoc::types::NamespaceSymbol* {
+    const auto it = namespaces.entries.find(s.parentNamespaceID);
+    return it == namespaces.entries.end() ? nullptr : &it->second;
+  };
+
+  // Each type of child is added to a different vector of NamespaceSymbol, and only the keys of namespaces are
+  // read, so functions, records and enums are merged at the same time
+  StoreWriter<hdoc::types::FunctionSymbol>  functionStore(this->root / functionsKind);
+  StoreWriter<hdoc::types::RecordSymbol>    recordStore(this->root / recordsKind);
+  StoreWriter<hdoc::types::EnumSymbol>      enumStore(this->root / enumsKind);
+  StoreWriter<hdoc::types::NamespaceSymbol> namespaceStore(this->root / namespacesKind);
+  pool.async([&]() {
+    hdoc::utils::TraceScope trace("Post-process spilled functions");
+    const auto              passStart = Clock::now();
+    auto                    cursors   = openCursors(runPaths(functionsKind), index.functions);
+    merge(cursors, [&](auto& cursor) {
+      hdoc::types::FunctionSymbol f = cursor.symbol();
+      // Methods of records that were filtered out are never written to the store
+      if (f.isRecordMember && !hasRecord(f.parentNamespaceID)) {
+        stats.numPrunedMethods++;
+        return;
+      }
+      pruneTypeRef(f.returnType);
+      for (auto& param : f.params) {
+        pruneTypeRef(param.type);
+      }
+      functionStore.add(cursor.id, f);
+    });
+    stats.functionsTime = msSince(passStart);
+  });
+  pool.async([&]() {
+    hdoc::utils::TraceScope trace("Post-process spilled records");
+    const auto              passStart = Clock::now();
+    auto                    cursors   = openCursors(runPaths(recordsKind), index.records);
+    merge(cursors, [&](auto& cursor) {
+      hdoc::types::RecordSymbol c = cursor.symbol();
+      for (auto& var : c.vars) {
+        pruneTypeRef(var.type);
+      }
+      hdoc::indexer::addBaseRecordsToProto(c);
+      if (hdoc::types::NamespaceSymbol* ns = findParentNamespace(c)) {
+        ns->records.emplace_back(cursor.id);
+      }
+      recordStore.add(cursor.id, c);
+    });
+    stats.recordsTime += msSince(passStart);
+  });
+  pool.async([&]() {
+    hdoc::utils::TraceScope trace("Post-process spilled enums");
+    const auto              passStart = Clock::now();
+    auto                    cursors   = openCursors(runPaths(enumsKind), index.enums);
+    merge(cursors, [&](auto& cursor) {
+      const hdoc::types::EnumSymbol e = cursor.symbol();
+      if (hdoc::types::NamespaceSymbol* ns = findParentNamespace(e)) {
+        ns->enums.emplace_back(cursor.id);
+      }
+      enumStore.add(cursor.id, e);
+    });
+    stats.enumsTime = msSince(passStart);
+  });
+  pool.wait();
+  stats.traversalTime = msSince(start);
+
+  const auto linkStart = Clock::now();
+  {
+    hdoc::utils::TraceScope trace("Link spilled namespaces");
+    for (const auto& [id, ns] : namespaces.entries) {
+      if (hdoc::types::NamespaceSymbol* parent = findParentNamespace(ns)) {
+        parent->namespaces.emplace_back(id);
+      }
+    }
+    for (const auto& [id, ns] : namespaces.entries) {
+      namespaceStore.add(id, ns);
+    }
+    clear(namespaces);
+  }
+  stats.linkTime = msSince(linkStart);
+
+  functionStore.finish(this->functions, index.functions.numMatches);
+  recordStore.finish(this->records, index.records.numMatches);
+  enumStore.finish(this->enums, index.enums.numMatches);
+  namespaceStore.finish(this->namespaces, index.namespaces.numMatches);
+  clear(index.functions);
+  clear(index.records);
+  clear(index.enums);
+  clear(index.namespaces);
+
+  // The runs have all been merged into the store
+  for (const uint32_t run : sortedRuns) {
+    for (const char* kind : {functionsKind, recordsKind, enumsKind, namespacesKind}) {
+      llvm::sys::fs::remove(this->runPath(run, kind).string());
+    }
+  }
+  stats.totalTime = msSince(start);
+  return stats;
+}
+
+hdoc::types::FrozenIndex hdoc::indexer::SpilledIndex::freeze() {
+  hdoc::types::FrozenIndex frozen;
+  frozen.functions  = std::move(this->functions.db);
+  frozen.records    = std::move(this->records.db);
+  frozen.enums      = std::move(this->enums.db);
+  frozen.namespaces = std::move(this->namespaces.db);
+  return frozen;
+}
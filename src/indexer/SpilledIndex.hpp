@@ -0,0 +1,94 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "llvm/Support/ThreadPool.h"
+
+#include "indexer/PostProcess.hpp"
+#include "types/FrozenIndex.hpp"
+#include "types/Index.hpp"
+
+namespace hdoc::indexer {
+/// @brief Keeps indexed symbols on disk instead of in memory, for codebases whose Index doesn't fit in memory.
+///
+/// Once hdoc's resident memory crosses a threshold, the Index of each thread is written to a "run", in which the
+/// symbols of each Database are sorted by SymbolID, and then cleared. Once every TU is indexed, the runs and the
+/// symbols that are still in memory are merged by SymbolID, keeping the copy of each symbol from the earliest run like
+/// Database::merge() does. Symbols are post-processed one at a time as they're merged and written to a store, which
+/// the FrozenIndex returned by freeze() reads from, so the whole Index is never in memory at once.
+///
+/// Namespaces are the only symbols that are held in memory while merging, because post-processing adds every other
+/// symbol to its namespace. Records are only needed to check which records exist, so only their SymbolIDs are kept.
+class SpilledIndex {
+public:
+  /// Runs and the store are written to a new directory in dir, or in the temporary directory if dir is empty, which
+  /// is removed when the SpilledIndex is destroyed. A threshold of 0 bytes disables spilling.
+  SpilledIndex(const uint64_t threshold, const std::filesystem::path& dir);
+  ~SpilledIndex();
+
+  /// @brief Check if symbols are spilled once the threshold is crossed
+  bool enabled() const {
+    return this->threshold > 0 && !this->root.empty();
+  }
+
+  /// @brief Check if index should be spilled to free memory. Thread-safe.
+  bool shouldSpill(const hdoc::types::Index& index) const;
+
+  /// @brief Write the symbols of index to a new run and clear them, keeping the number of matches. Thread-safe.
+  /// Returns false and leaves index untouched if the run couldn't be written.
+  bool spill(hdoc::types::Index& index);
+
+  /// @brief Get the number of runs that were written. Thread-safe.
+  uint32_t numRuns() const;
+
+  /// @brief Check if any symbols were spilled, in which case the Index is post-processed and frozen by this
+  bool spilled() const {
+    return this->numRuns() > 0;
+  }
+
+  /// @brief Merge the runs with the symbols that are still in index, post-process them like
+  /// hdoc::indexer::postProcess(), and write them to the store. index is left with only its number of matches.
+  PostProcessStats postProcess(hdoc::types::Index& index, llvm::ThreadPool& pool);
+
+  /// @brief Get a FrozenIndex that reads symbols from the store, which must outlive it. Call after postProcess().
+  hdoc::types::FrozenIndex freeze();
+
+  /// @brief A Database that was written to the store by postProcess()
+  template <typename T> struct Stored {
+    hdoc::types::FrozenDatabase<T> db;
+    uint64_t                       numBytes = 0; ///< Size of the encoded symbols
+  };
+
+  Stored<hdoc::types::FunctionSymbol>  functions;
+  Stored<hdoc::types::RecordSymbol>    records;
+  Stored<hdoc::types::EnumSymbol>      enums;
+  Stored<hdoc::types::NamespaceSymbol> namespaces;
+
+  std::atomic<uint64_t> numBytesSpilled = 0; ///< Total size of the runs
+
+  /// @brief Get the resident memory of hdoc, in bytes. Can be replaced to make spilling deterministic in tests.
+  std::function<uint64_t()> residentMemory;
+
+  /// Indexes with fewer symbols aren't spilled, so that memory taken by TUs that are being parsed doesn't lead to
+  /// lots of tiny runs
+  uint64_t minSymbolsPerRun = 4096;
+
+private:
+  /// @brief Path of the file holding the symbols of kind from run
+  std::filesystem::path runPath(const uint32_t run, const char* kind) const;
+
+  uint64_t              threshold; ///< Resident memory above which symbols are spilled (0 == never)
+  std::filesystem::path root;      ///< Directory of the runs and the store
+
+  std::atomic<uint32_t> nextRun = 0; ///< Sequence number of the next run
+  mutable std::mutex    mutex;       ///< Guards runs
+  std::vector<uint32_t> runs;        ///< Sequence numbers of the runs that were written
+};
+} // namespace hdoc::indexer
@@ -0,0 +1,155 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "indexer/TUContext.hpp"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Index/USRGeneration.h"
+#include "llvm/Support/Path.h"
+
+#include "spdlog/spdlog.h"
+
+#include <filesystem>
+
+/// When hdoc is run by multiple threads, we use a VFS (virtual file system) to access
+/// files safely. The working directory of the parser is changed during indexing, and
+/// other threads have no visibility of this. Consequently, canonical paths
+/// generated in a non-VFS-aware way can be wrong.
+/// This function is similar to one defined in clang, and gets the canonical path in a
+/// VFS-aware way.
+static llvm::Optional<std::string> getCanonicalPath(const clang::FileEntry*     fileEntry,
+                                                    const clang::SourceManager& sourceManager) {
+  llvm::SmallString<128> path = fileEntry->getName();
+  if (!llvm::sys::path::is_absolute(path)) {
+    if (auto ec = sourceManager.getFileManager().getVirtualFileSystem().makeAbsolute(path)) {
+      spdlog::warn("Could not turn relative path '{}' to absolute: {}", path.c_str(), ec.message().c_str());
+      return llvm::None;
+    }
+  }
+
+  if (auto dir = sourceManager.getFileManager().getDirectory(llvm::sys::path::parent_path(path))) {
+    const llvm::StringRef  dirName = sourceManager.getFileManager().getCanonicalName(*dir);
+    llvm::SmallString<128> realPath;
+    llvm::sys::path::append(realPath, dirName, llvm::sys::path::filename(path));
+    return realPath.str().str();
+  }
+
+  return path.str().str();
+}
+
+bool hdoc::indexer::FileClaims::tryClaim(const llvm::sys::fs::UniqueID& file, const uint32_t claimant) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const auto [it, inserted] = this->owners.try_emplace(file, claimant);
+  if (inserted) {
+    this->numClaims++;
+  } else if (it->second != claimant) {
+    this->numConflicts++;
+  }
+  return it->second == claimant;
+}
+
+bool hdoc::indexer::TUContext::owns(const clang::Decl* d) {
+  if (this->claims == nullptr) {
+    return true;
+  }
+
+  // Redeclarations are owned by whichever TU owns the first declaration of the symbol. Otherwise an out-of-line
+  // definition in a file owned by this TU could be indexed before the TU that owns the header gets to the
+  // declaration, losing what's only spelled on the declaration (default arguments, virtual, etc.)
+  const clang::Decl* owner = d->getCanonicalDecl();
+
+  // Types are only indexed where they're defined, and the first declaration may be a forward declaration in a header
+  // that's also included by TUs that never see the definition. Those TUs would claim the header and skip the type,
+  // so types are owned by whichever TU owns the file of their definition instead.
+  const clang::Decl* tag = d;
+  if (const auto* classTemplate = llvm::dyn_cast<clang::ClassTemplateDecl>(d)) {
+    tag = classTemplate->getTemplatedDecl();
+  }
+  if (const auto* tagDecl = llvm::dyn_cast<clang::TagDecl>(tag)) {
+    if (const auto* definition = tagDecl->getDefinition()) {
+      owner = definition;
+    }
+  }
+
+  const auto&                 sourceManager = d->getASTContext().getSourceManager();
+  const clang::SourceLocation loc           = owner->getLocation();
+  const clang::FileID         fileID        = sourceManager.getFileID(sourceManager.getExpansionLoc(loc));
+  if (const auto it = this->ownedFiles.find(fileID); it != this->ownedFiles.end()) {
+    return it->second;
+  }
+
+  // Decls that aren't located in a real file (i.e. builtins) can't be claimed, so every TU sees them
+  bool owned = true;
+  if (const auto* fileEntry = sourceManager.getFileEntryForID(fileID)) {
+    owned = this->claims->tryClaim(fileEntry->getUniqueID(), this->claimant);
+  }
+  this->ownedFiles.try_emplace(fileID, owned);
+  return owned;
+}
+
+const hdoc::indexer::FileInfo& hdoc::indexer::TUContext::getFileInfo(const clang::FileID        fileID,
+                                                                     const clang::SourceManager& sourceManager) {
+  // The invalid FileID is the empty key of the DenseMap, so it can't be cached
+  static const FileInfo noFile;
+  if (fileID.isInvalid()) {
+    return noFile;
+  }
+
+  const auto [it, inserted] = this->fileInfos.try_emplace(fileID);
+  FileInfo& info            = it->second;
+  if (!inserted) {
+    return info;
+  }
+
+  // Decls that aren't located in a real file (i.e. builtins or macro expansions) are left outside of rootDir
+  const auto* fileEntry = sourceManager.getFileEntryForID(fileID);
+  if (fileEntry == nullptr) {
+    return info;
+  }
+  const auto canonicalPath = getCanonicalPath(fileEntry, sourceManager);
+  if (!canonicalPath) {
+    return info;
+  }
+
+  info.canonicalPath = *canonicalPath;
+  info.relPath       = std::filesystem::relative(info.canonicalPath, this->cfg->rootDir).string();
+  // ".." is used as a janky way to determine if the path is outside of rootDir since the canonicalized path
+  // should not have any ".."s in it
+  info.inRootDir = info.relPath.find("..") == std::string::npos;
+  info.ignored   = this->cfg->ignorePaths.matches(info.relPath);
+  return info;
+}
+
+const hdoc::indexer::FileInfo& hdoc::indexer::TUContext::getFileInfo(const clang::Decl* d) {
+  const auto& sourceManager = d->getASTContext().getSourceManager();
+  return this->getFileInfo(sourceManager.getFileID(d->getLocation()), sourceManager);
+}
+
+hdoc::types::SymbolID hdoc::indexer::TUContext::buildID(const clang::NamedDecl* d) {
+  this->numIDLookups++;
+  const auto [it, inserted] = this->declIDs.try_emplace(d);
+  if (!inserted) {
+    this->numIDCacheHits++;
+    return it->second;
+  }
+
+  llvm::SmallString<128> USR;
+  if (clang::index::generateUSRForDecl(d, USR)) {
+    spdlog::error("Unable to generate USR for the given symbol with name {}", d->getNameAsString());
+    return it->second;
+  }
+
+  const hdoc::types::SymbolID id(USR);
+  std::string                 otherUSR;
+  if (this->symbolIDs != nullptr && !this->symbolIDs->check(id, USR, otherUSR)) {
+    spdlog::error("SymbolID collision: {} and {} both hash to {}, only one of them will be documented.",
+                  otherUSR,
+                  USR.str(),
+                  id.str());
+  }
+  it->second = id;
+  return id;
+}
@@ -0,0 +1,106 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/FileSystem/UniqueID.h"
+
+#include "types/ClaimTable.hpp"
+#include "types/Config.hpp"
+#include "types/SymbolIDTable.hpp"
+
+namespace clang {
+class SourceManager;
+} // namespace clang
+
+namespace hdoc::indexer {
+/// @brief Process-wide registry of which translation unit indexes each file.
+///
+/// Popular headers are included by many TUs, and without coordination every one of those TUs would run the
+/// matchers over the header's decls only to discard the results because the symbols are already in the Index.
+/// The first TU to reach a file claims it, and all other TUs skip the decls located in that file.
+class FileClaims {
+public:
+  /// @brief Get a unique identifier for a TU that wants to claim files
+  uint32_t newClaimant() {
+    return ++this->lastClaimant;
+  }
+
+  /// @brief Claim a file for a TU, returning true if the file is (now) owned by that TU
+  bool tryClaim(const llvm::sys::fs::UniqueID& file, const uint32_t claimant);
+
+  std::atomic<uint32_t> numClaims    = 0; ///< Number of files that were claimed
+  std::atomic<uint32_t> numConflicts = 0; ///< Number of times a TU found a file already claimed by another TU
+
+private:
+  std::atomic<uint32_t>                             lastClaimant = 0; ///< Last identifier handed out by newClaimant()
+  llvm::DenseMap<llvm::sys::fs::UniqueID, uint32_t> owners;           ///< Maps each claimed file to the TU that owns it
+  std::mutex                                        mutex;            ///< Guards owners
+};
+
+/// @brief Where a file is located relative to the project, computed once per file instead of once per decl
+struct FileInfo {
+  std::string canonicalPath;     ///< Absolute path of the file with symlinks resolved, empty if it isn't a real file
+  std::string relPath;           ///< canonicalPath relative to rootDir
+  bool        inRootDir = false; ///< Is the file located under rootDir?
+  bool        ignored   = false; ///< Does relPath match any of the ignorePaths?
+};
+
+/// @brief State that is local to the indexing of a single translation unit.
+/// A TUContext is only ever used by the thread that is indexing its TU, so it doesn't need any locking.
+class TUContext {
+public:
+  /// If claims is null, every file is considered to be owned by this TU.
+  /// If symbolClaims is null, symbols are only deduplicated within the Index that the TU is indexed into.
+  /// If symbolIDs is null, SymbolIDs aren't checked for collisions.
+  /// If claimant is 0, files are claimed under a new claimant, otherwise under the given one from claims.
+  TUContext(const hdoc::types::Config*  cfg,
+            FileClaims*                 claims,
+            hdoc::types::IndexClaims*   symbolClaims = nullptr,
+            hdoc::types::SymbolIDTable* symbolIDs    = nullptr,
+            const uint32_t              claimant     = 0)
+      : cfg(cfg), claims(claims), claimant(claims && claimant == 0 ? claims->newClaimant() : claimant),
+        symbolClaims(symbolClaims), symbolIDs(symbolIDs) {}
+
+  /// @brief Get the location of a file relative to the project, canonicalizing its path the first time it's seen.
+  /// The reference is invalidated by the next call for a different file.
+  const FileInfo& getFileInfo(const clang::FileID fileID, const clang::SourceManager& sourceManager);
+
+  /// @brief Get the location of the file in which the decl is spelled
+  const FileInfo& getFileInfo(const clang::Decl* d);
+
+  /// @brief Check if this TU owns the file in which the decl's symbol is declared, claiming the file if it's unclaimed.
+  /// That's the file of the definition for classes, structs, unions, and enums, and of the first declaration otherwise.
+  bool owns(const clang::Decl* d);
+
+  /// @brief Build the SymbolID of a decl from its USR.
+  /// Each decl's USR is only generated and hashed the first time its SymbolID is needed in this TU.
+  /// If SymbolIDs are checked, a collision with the SymbolID of a different symbol is reported.
+  hdoc::types::SymbolID buildID(const clang::NamedDecl* d);
+
+  uint64_t numIDLookups   = 0; ///< Number of calls to buildID()
+  uint64_t numIDCacheHits = 0; ///< Number of calls to buildID() for a decl whose SymbolID was already built
+
+  /// @brief Get the process-wide claims on each SymbolID, or nullptr if symbols aren't claimed
+  hdoc::types::IndexClaims* getSymbolClaims() const {
+    return this->symbolClaims;
+  }
+
+private:
+  const hdoc::types::Config*                                cfg;
+  FileClaims*                                               claims;
+  uint32_t                                                  claimant;
+  hdoc::types::IndexClaims*                                 symbolClaims;
+  hdoc::types::SymbolIDTable*                               symbolIDs;
+  llvm::DenseMap<clang::FileID, bool>                       ownedFiles; ///< Cached claim result of each file in this TU
+  llvm::DenseMap<clang::FileID, FileInfo>                   fileInfos;  ///< Cached FileInfo of each file in this TU
+  llvm::DenseMap<const clang::Decl*, hdoc::types::SymbolID> declIDs;    ///< Cached SymbolID of each decl in this TU
+};
+} // namespace hdoc::indexer
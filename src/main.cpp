@@ -1,6 +1,7 @@
 // Copyright 2019-2023 hdoc
 // SPDX-License-Identifier: AGPL-3.0-only
 
+#include "spdlog/spdlog.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
@@ -8,8 +9,9 @@
 #include "frontend/Frontend.hpp"
 #include "indexer/Indexer.hpp"
 #include "serde/HTMLWriter.hpp"
-#include "serde/SerdeUtils.hpp"
 #include "serde/Serialization.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
 
 int main(int argc, char** argv) {
   // Print stack trace on failure
@@ -24,17 +26,19 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  auto&                  metrics = hdoc::utils::Metrics::global();
   llvm::ThreadPool       pool(llvm::hardware_concurrency(cfg.numThreads));
   hdoc::indexer::Indexer indexer(&cfg, pool);
+  metrics.startPhase("index");
   indexer.run();
-  indexer.pruneMethods();
-  indexer.pruneTypeRefs();
-  indexer.resolveNamespaces();
-  indexer.updateRecordNames();
+  metrics.startPhase("post-process");
+  indexer.postProcess();
   indexer.printStats();
-  const hdoc::types::Index* index = indexer.dump();
+  metrics.startPhase("freeze");
+  const hdoc::types::FrozenIndex index = indexer.freeze();
 
-  hdoc::serde::HTMLWriter htmlWriter(index, &cfg, pool);
+  metrics.startPhase("html");
+  hdoc::serde::HTMLWriter htmlWriter(&index, &cfg, pool);
   htmlWriter.printFunctions();
   htmlWriter.printRecords();
   htmlWriter.printNamespaces();
@@ -45,11 +49,18 @@ int main(int argc, char** argv) {
 
   // Ensure that cfg was properly initialized
   if (cfg.debugDumpJSONPayload) {
-    const std::string data = hdoc::serde::serializeToJSON(*index, cfg);
-    bool              res  = dumpJSONPayload(data);
-    if (res == false) {
+    metrics.startPhase("json");
+    if (!hdoc::serde::serializeToJSON(index, cfg, "hdoc-payload.json")) {
       return EXIT_FAILURE;
     }
+    spdlog::info("hdoc-payload.json successfully written to current working directory.");
+  }
+
+  if (!cfg.tracePath.empty() && !hdoc::utils::TraceRecorder::global().write(cfg.tracePath)) {
+    spdlog::error("Failed to write trace to {}", cfg.tracePath.string());
+  }
+  if (!cfg.metricsPath.empty() && !metrics.write(cfg.metricsPath)) {
+    spdlog::error("Failed to write metrics to {}", cfg.metricsPath.string());
   }
 
   return EXIT_SUCCESS;
@@ -0,0 +1,328 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "serde/BinarySerde.hpp"
+
+#include "llvm/Support/LEB128.h"
+
+#include <algorithm>
+
+namespace hdoc::serde {
+
+void BinaryWriter::writeUInt(const uint64_t val) {
+  uint8_t        tmp[16];
+  const unsigned len = llvm::encodeULEB128(val, tmp);
+  this->buf.append(reinterpret_cast<const char*>(tmp), len);
+}
+
+void BinaryWriter::writeInt(const int64_t val) {
+  uint8_t        tmp[16];
+  const unsigned len = llvm::encodeSLEB128(val, tmp);
+  this->buf.append(reinterpret_cast<const char*>(tmp), len);
+}
+
+void BinaryWriter::writeString(const std::string_view str) {
+  this->writeUInt(str.size());
+  this->buf.append(str);
+}
+
+void BinaryWriter::writeID(const hdoc::types::SymbolID& id) {
+  this->writeUInt(id.raw());
+}
+
+void BinaryWriter::writeSymbol(const hdoc::types::Symbol& s) {
+  this->writeID(s.ID);
+  this->writeString(s.name);
+  this->writeString(s.briefComment);
+  this->writeString(s.docComment);
+  this->writeString(s.file);
+  this->writeUInt(s.line);
+  this->writeID(s.parentNamespaceID);
+}
+
+void BinaryWriter::writeTypeRef(const hdoc::types::TypeRef& t) {
+  this->writeID(t.id);
+  this->writeString(t.name);
+}
+
+void BinaryWriter::writeTemplateParams(const std::vector<hdoc::types::TemplateParam>& tparams) {
+  this->writeUInt(tparams.size());
+  for (const auto& tparam : tparams) {
+    this->writeUInt(static_cast<uint64_t>(tparam.templateType));
+    this->writeString(tparam.name);
+    this->writeString(tparam.type);
+    this->writeString(tparam.docComment);
+    this->writeString(tparam.defaultValue);
+    this->writeUInt(tparam.isParameterPack);
+    this->writeUInt(tparam.isTypename);
+  }
+}
+
+void BinaryWriter::writeIDs(const std::vector<hdoc::types::SymbolID>& ids) {
+  this->writeUInt(ids.size());
+  for (const auto& id : ids) {
+    this->writeID(id);
+  }
+}
+
+void BinaryWriter::write(const hdoc::types::FunctionSymbol& f) {
+  this->writeSymbol(f);
+  this->writeUInt(f.isRecordMember);
+  this->writeUInt(f.isConstexpr);
+  this->writeUInt(f.isConsteval);
+  this->writeUInt(f.isInline);
+  this->writeUInt(f.isConst);
+  this->writeUInt(f.isVolatile);
+  this->writeUInt(f.isRestrict);
+  this->writeUInt(f.isVirtual);
+  this->writeUInt(f.isVariadic);
+  this->writeUInt(f.isNoExcept);
+  this->writeUInt(f.hasTrailingReturn);
+  this->writeUInt(f.isCtorOrDtor);
+  this->writeUInt(f.nameStart);
+  this->writeUInt(f.postTemplate);
+  this->writeUInt(f.access);
+  this->writeUInt(f.storageClass);
+  this->writeUInt(f.refQualifier);
+  this->writeString(f.proto);
+  this->writeTypeRef(f.returnType);
+  this->writeString(f.returnTypeDocComment);
+  this->writeUInt(f.params.size());
+  for (const auto& param : f.params) {
+    this->writeString(param.name);
+    this->writeTypeRef(param.type);
+    this->writeString(param.docComment);
+    this->writeString(param.defaultValue);
+  }
+  this->writeTemplateParams(f.templateParams);
+}
+
+void BinaryWriter::write(const hdoc::types::RecordSymbol& r) {
+  this->writeSymbol(r);
+  this->writeString(r.type);
+  this->writeString(r.proto);
+  this->writeUInt(r.vars.size());
+  for (const auto& var : r.vars) {
+    this->writeUInt(var.isStatic);
+    this->writeString(var.name);
+    this->writeTypeRef(var.type);
+    this->writeString(var.defaultValue);
+    this->writeString(var.docComment);
+    this->writeUInt(var.access);
+  }
+  this->writeIDs(r.methodIDs);
+  this->writeUInt(r.baseRecords.size());
+  for (const auto& base : r.baseRecords) {
+    this->writeID(base.id);
+    this->writeUInt(base.access);
+    this->writeString(base.name);
+  }
+  this->writeTemplateParams(r.templateParams);
+}
+
+void BinaryWriter::write(const hdoc::types::EnumSymbol& e) {
+  this->writeSymbol(e);
+  this->writeString(e.type);
+  this->writeUInt(e.members.size());
+  for (const auto& member : e.members) {
+    this->writeInt(member.value);
+    this->writeString(member.name);
+    this->writeString(member.docComment);
+  }
+}
+
+void BinaryWriter::write(const hdoc::types::NamespaceSymbol& n) {
+  this->writeSymbol(n);
+  this->writeIDs(n.records);
+  this->writeIDs(n.namespaces);
+  this->writeIDs(n.enums);
+}
+
+uint64_t BinaryReader::readUInt() {
+  if (this->failed) {
+    return 0;
+  }
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(this->data.data());
+  unsigned       len   = 0;
+  const char*    err   = nullptr;
+  const uint64_t val   = llvm::decodeULEB128(begin + this->pos, &len, begin + this->data.size(), &err);
+  if (err != nullptr) {
+    this->failed = true;
+    return 0;
+  }
+  this->pos += len;
+  return val;
+}
+
+int64_t BinaryReader::readInt() {
+  if (this->failed) {
+    return 0;
+  }
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(this->data.data());
+  unsigned       len   = 0;
+  const char*    err   = nullptr;
+  const int64_t  val   = llvm::decodeSLEB128(begin + this->pos, &len, begin + this->data.size(), &err);
+  if (err != nullptr) {
+    this->failed = true;
+    return 0;
+  }
+  this->pos += len;
+  return val;
+}
+
+uint64_t BinaryReader::readCount() {
+  const uint64_t count = this->readUInt();
+  // Every element takes at least one byte, so a larger count means the data is corrupt
+  if (count > this->data.size() - std::min<uint64_t>(this->pos, this->data.size())) {
+    this->failed = true;
+    return 0;
+  }
+  return count;
+}
+
+std::string BinaryReader::readString() {
+  return this->readStringRef().str();
+}
+
+llvm::StringRef BinaryReader::readStringRef() {
+  const uint64_t len = this->readCount();
+  if (this->failed) {
+    return "";
+  }
+  const llvm::StringRef str = this->data.substr(this->pos, len);
+  this->pos += len;
+  return str;
+}
+
+hdoc::types::SymbolID BinaryReader::readID() {
+  return hdoc::types::SymbolID(this->readUInt());
+}
+
+void BinaryReader::readSymbol(hdoc::types::Symbol& s) {
+  s.ID                = this->readID();
+  s.name              = this->readString();
+  s.briefComment      = this->readString();
+  s.docComment        = this->readString();
+  s.file              = this->readString();
+  s.line              = this->readUInt();
+  s.parentNamespaceID = this->readID();
+}
+
+void BinaryReader::readTypeRef(hdoc::types::TypeRef& t) {
+  t.id   = this->readID();
+  t.name = this->readString();
+}
+
+void BinaryReader::readTemplateParams(std::vector<hdoc::types::TemplateParam>& tparams) {
+  const uint64_t count = this->readCount();
+  tparams.reserve(count);
+  for (uint64_t i = 0; i < count && !this->failed; i++) {
+    hdoc::types::TemplateParam tparam;
+    tparam.templateType    = static_cast<hdoc::types::TemplateParam::TemplateType>(this->readUInt());
+    tparam.name            = this->readString();
+    tparam.type            = this->readString();
+    tparam.docComment      = this->readString();
+    tparam.defaultValue    = this->readString();
+    tparam.isParameterPack = this->readUInt();
+    tparam.isTypename      = this->readUInt();
+    tparams.emplace_back(tparam);
+  }
+}
+
+void BinaryReader::readIDs(std::vector<hdoc::types::SymbolID>& ids) {
+  const uint64_t count = this->readCount();
+  ids.reserve(count);
+  for (uint64_t i = 0; i < count && !this->failed; i++) {
+    ids.emplace_back(this->readID());
+  }
+}
+
+void BinaryReader::read(hdoc::types::FunctionSymbol& f) {
+  this->readSymbol(f);
+  f.isRecordMember    = this->readUInt();
+  f.isConstexpr       = this->readUInt();
+  f.isConsteval       = this->readUInt();
+  f.isInline          = this->readUInt();
+  f.isConst           = this->readUInt();
+  f.isVolatile        = this->readUInt();
+  f.isRestrict        = this->readUInt();
+  f.isVirtual         = this->readUInt();
+  f.isVariadic        = this->readUInt();
+  f.isNoExcept        = this->readUInt();
+  f.hasTrailingReturn = this->readUInt();
+  f.isCtorOrDtor      = this->readUInt();
+  f.nameStart         = this->readUInt();
+  f.postTemplate      = this->readUInt();
+  f.access            = static_cast<clang::AccessSpecifier>(this->readUInt());
+  f.storageClass      = static_cast<clang::StorageClass>(this->readUInt());
+  f.refQualifier      = static_cast<clang::RefQualifierKind>(this->readUInt());
+  f.proto             = this->readString();
+  this->readTypeRef(f.returnType);
+  f.returnTypeDocComment = this->readString();
+
+  const uint64_t numParams = this->readCount();
+  f.params.reserve(numParams);
+  for (uint64_t i = 0; i < numParams && !this->failed; i++) {
+    hdoc::types::FunctionParam param;
+    param.name = this->readString();
+    this->readTypeRef(param.type);
+    param.docComment   = this->readString();
+    param.defaultValue = this->readString();
+    f.params.emplace_back(param);
+  }
+  this->readTemplateParams(f.templateParams);
+}
+
+void BinaryReader::read(hdoc::types::RecordSymbol& r) {
+  this->readSymbol(r);
+  r.type  = this->readString();
+  r.proto = this->readString();
+
+  const uint64_t numVars = this->readCount();
+  r.vars.reserve(numVars);
+  for (uint64_t i = 0; i < numVars && !this->failed; i++) {
+    hdoc::types::MemberVariable var;
+    var.isStatic = this->readUInt();
+    var.name     = this->readString();
+    this->readTypeRef(var.type);
+    var.defaultValue = this->readString();
+    var.docComment   = this->readString();
+    var.access       = static_cast<clang::AccessSpecifier>(this->readUInt());
+    r.vars.emplace_back(var);
+  }
+  this->readIDs(r.methodIDs);
+
+  const uint64_t numBases = this->readCount();
+  r.baseRecords.reserve(numBases);
+  for (uint64_t i = 0; i < numBases && !this->failed; i++) {
+    hdoc::types::RecordSymbol::BaseRecord base;
+    base.id     = this->readID();
+    base.access = static_cast<clang::AccessSpecifier>(this->readUInt());
+    base.name   = this->readString();
+    r.baseRecords.emplace_back(base);
+  }
+  this->readTemplateParams(r.templateParams);
+}
+
+void BinaryReader::read(hdoc::types::EnumSymbol& e) {
+  this->readSymbol(e);
+  e.type = this->readString();
+
+  const uint64_t numMembers = this->readCount();
+  e.members.reserve(numMembers);
+  for (uint64_t i = 0; i < numMembers && !this->failed; i++) {
+    hdoc::types::EnumMember member;
+    member.value      = this->readInt();
+    member.name       = this->readString();
+    member.docComment = this->readString();
+    e.members.emplace_back(member);
+  }
+}
+
+void BinaryReader::read(hdoc::types::NamespaceSymbol& n) {
+  this->readSymbol(n);
+  this->readIDs(n.records);
+  this->readIDs(n.namespaces);
+  this->readIDs(n.enums);
+}
+} // namespace hdoc::serde
@@ -0,0 +1,83 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "types/Symbols.hpp"
+
+namespace hdoc::serde {
+
+/// @brief Encodes hdoc's symbols into a compact binary format.
+/// Unlike the JSON payload, every field of every symbol is encoded so that a decoded symbol is
+/// indistinguishable from the original. This is used for hdoc's on-disk caches and is not a stable format.
+class BinaryWriter {
+public:
+  BinaryWriter(std::string& buf) : buf(buf) {}
+
+  void writeUInt(const uint64_t val);
+  void writeInt(const int64_t val);
+  void writeString(const std::string_view str);
+  void writeID(const hdoc::types::SymbolID& id);
+
+  void write(const hdoc::types::FunctionSymbol& f);
+  void write(const hdoc::types::RecordSymbol& r);
+  void write(const hdoc::types::EnumSymbol& e);
+  void write(const hdoc::types::NamespaceSymbol& n);
+
+private:
+  void writeSymbol(const hdoc::types::Symbol& s);
+  void writeTypeRef(const hdoc::types::TypeRef& t);
+  void writeTemplateParams(const std::vector<hdoc::types::TemplateParam>& tparams);
+  void writeIDs(const std::vector<hdoc::types::SymbolID>& ids);
+
+  std::string& buf;
+};
+
+/// @brief Decodes symbols encoded by BinaryWriter.
+/// Reading past the end of the buffer or reading malformed data puts the reader into an error state
+/// which is checked with ok(). Values read after an error are default-initialized.
+class BinaryReader {
+public:
+  BinaryReader(llvm::StringRef data) : data(data) {}
+
+  uint64_t              readUInt();
+  int64_t               readInt();
+  std::string           readString();
+  hdoc::types::SymbolID readID();
+
+  /// @brief Read a string without copying it, which is only valid as long as the data the reader was given
+  llvm::StringRef readStringRef();
+
+  void read(hdoc::types::FunctionSymbol& f);
+  void read(hdoc::types::RecordSymbol& r);
+  void read(hdoc::types::EnumSymbol& e);
+  void read(hdoc::types::NamespaceSymbol& n);
+
+  /// @brief Returns false if any read failed
+  bool ok() const {
+    return !this->failed;
+  }
+
+  /// @brief Returns true if all of the data has been consumed
+  bool done() const {
+    return this->pos >= this->data.size();
+  }
+
+private:
+  void readSymbol(hdoc::types::Symbol& s);
+  void readTypeRef(hdoc::types::TypeRef& t);
+  void readTemplateParams(std::vector<hdoc::types::TemplateParam>& tparams);
+  void readIDs(std::vector<hdoc::types::SymbolID>& ids);
+
+  /// @brief Read the number of elements of a container, failing if the count can't possibly fit in the buffer
+  uint64_t readCount();
+
+  llvm::StringRef data;
+  uint64_t        pos    = 0;
+  bool            failed = false;
+};
+} // namespace hdoc::serde
@@ -7,16 +7,21 @@
 #include "clang/Format/Format.h"
 #include "llvm/Support/JSON.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <stack>
 #include <string>
 
 #include "serde/CppReferenceURLs.hpp"
 #include "serde/HTMLWriter.hpp"
-#include "serde/SerdeUtils.hpp"
 #include "support/MarkdownConverter.hpp"
+#include "support/Metrics.hpp"
 #include "support/StringUtils.hpp"
+#include "support/Trace.hpp"
 #include "types/Symbols.hpp"
 
 /// Implementation of to_string() for Clang member variable access specifier
@@ -35,6 +40,45 @@ static std::string to_string(const clang::AccessSpecifier& access) {
   }
 }
 
+namespace {
+/// @brief Renders pages on a thread pool while bounding how many of them are queued at once.
+/// Each queued page holds a copy of its symbol, so queueing every page of a large index up front would keep a second
+/// copy of the whole index in memory, which defeats reading symbols from disk one at a time.
+class PageQueue {
+public:
+  explicit PageQueue(llvm::ThreadPool& pool) : pool(pool), maxQueued(4 * std::max(pool.getThreadCount(), 1U)) {}
+
+  /// @brief Queue a page on the thread pool like llvm::ThreadPool::async(), first waiting for a free slot
+  template <typename Function, typename... Args> void async(Function&& F, Args&&... ArgList) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->finished.wait(lock, [this] { return this->numQueued < this->maxQueued; });
+      this->numQueued++;
+    }
+    this->pool.async([this, task = std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...)]() mutable {
+      task();
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->numQueued--;
+      }
+      this->finished.notify_one();
+    });
+  }
+
+  /// @brief Wait until every queued page is rendered
+  void wait() {
+    this->pool.wait();
+  }
+
+private:
+  llvm::ThreadPool&       pool;
+  const uint32_t          maxQueued; ///< Most pages that are queued or being rendered at once
+  std::mutex              mutex;     ///< Guards numQueued
+  std::condition_variable finished;  ///< Notified whenever a page is rendered
+  uint32_t                numQueued = 0;
+};
+} // namespace
+
 extern uint8_t      ___assets_styles_css[];
 extern uint8_t      ___assets_favicon_ico[];
 extern uint8_t      ___assets_favicon_32x32_png[];
@@ -60,9 +104,9 @@ extern unsigned int ___assets_auto_render_min_js_len;
 extern unsigned int ___assets_highlight_min_js_len;
 extern unsigned int ___assets_index_min_js_len;
 
-hdoc::serde::HTMLWriter::HTMLWriter(const hdoc::types::Index*  index,
-                                    const hdoc::types::Config* cfg,
-                                    llvm::ThreadPool&          pool)
+hdoc::serde::HTMLWriter::HTMLWriter(const hdoc::types::FrozenIndex* index,
+                                    const hdoc::types::Config*      cfg,
+                                    llvm::ThreadPool&               pool)
     : index(index), cfg(cfg), pool(pool) {
   // Create the directory where the HTML files will be placed
   std::error_code ec;
@@ -113,7 +157,8 @@ static void printNewPage(const hdoc::types::Config&   cfg,
                          const std::filesystem::path& path,
                          const std::string_view       pageTitle,
                          CTML::Node                   breadcrumbs = CTML::Node()) {
-  CTML::Document html;
+  hdoc::utils::TraceScope trace("Write page", path.native());
+  CTML::Document          html;
 
   // Create the header, which includes Bulma CSS framework
   html.AppendNodeToHead(CTML::Node("meta").SetAttr("charset", "utf-8"));
@@ -214,7 +259,9 @@ static void printNewPage(const hdoc::types::Config&   cfg,
   html.AppendNodeToBody(CTML::Node("footer.footer").AddChild(p1).AddChild(p2).AddChild(p3));
 
   // Dump to a file
-  std::ofstream(path) << html.ToString();
+  const std::string page = html.ToString();
+  std::ofstream(path) << page;
+  hdoc::utils::Metrics::global().recordPage(page.size());
 }
 
 /// Return a short string describing a symbol for its entry in the overview list
@@ -249,6 +296,8 @@ static std::string getSymbolBlurb(const hdoc::types::Symbol& s) {
 
 /// Run clang-format with a custom style over the given string
 std::string hdoc::serde::clangFormat(const std::string_view s, const uint64_t& columnLimit) {
+  hdoc::utils::TraceScope trace("clang-format");
+
   // Run clang-format over function name to break width to 50 chars
   auto style              = clang::format::getChromiumStyle(clang::format::FormatStyle::LK_Cpp);
   style.ColumnLimit       = columnLimit;
@@ -333,7 +382,7 @@ std::string hdoc::serde::getHyperlinkedFunctionProto(const std::string_view
 /// Indexed types are hyperlinked to, as are certain std:: types.
 /// All others are returned without hyperlinks as the plain type name.
 static std::string getHyperlinkedTypeName(const hdoc::types::TypeRef& type) {
-  std::string fullTypeName = type.name;
+  std::string fullTypeName = type.name.str();
   std::string bareTypeName = hdoc::serde::getBareTypeName(fullTypeName);
 
   fullTypeName = hdoc::serde::clangFormat(fullTypeName);
@@ -373,18 +422,18 @@ static CTML::Node getDeclaredAtNode(const hdoc::types::Symbol& s,
                                     const std::string_view     gitDefaultBranch = "") {
   auto p = CTML::Node("p", "Declared at: ");
   if (gitRepoURL == "") {
-    return p.AddChild(CTML::Node("span.is-family-code", s.file + ":" + std::to_string(s.line)));
+    return p.AddChild(CTML::Node("span.is-family-code", s.file.str() + ":" + std::to_string(s.line)));
   } else {
-    return p.AddChild(CTML::Node("a.is-family-code", s.file + ":" + std::to_string(s.line))
+    return p.AddChild(CTML::Node("a.is-family-code", s.file.str() + ":" + std::to_string(s.line))
                           .SetAttr("href",
-                                   std::string(gitRepoURL) + "blob/" + std::string(gitDefaultBranch) + "/" + s.file +
-                                       "#L" + std::to_string(s.line)));
+                                   std::string(gitRepoURL) + "blob/" + std::string(gitDefaultBranch) + "/" +
+                                       s.file.str() + "#L" + std::to_string(s.line)));
   }
 }
 
 /// Creates a Bulma breadcrumb node to make the provenance of the current symbol more clear and aid in navigation.
 static CTML::Node
-getBreadcrumbNode(const std::string& prefix, const hdoc::types::Symbol& s, const hdoc::types::Index& index) {
+getBreadcrumbNode(const std::string& prefix, const hdoc::types::Symbol& s, const hdoc::types::FrozenIndex& index) {
   // Symbols that have no parents don't have any breadcrumbs.
   if (s.parentNamespaceID.raw() == 0) {
     return CTML::Node();
@@ -403,14 +452,12 @@ getBreadcrumbNode(const std::string& prefix, const hdoc::types::Symbol& s, const
   std::stack<ParentSymbol> stack;
   hdoc::types::Symbol      parent = s;
   while (true) {
-    if (index.namespaces.contains(parent.parentNamespaceID)) {
-      const auto& newParent = index.namespaces.entries.at(parent.parentNamespaceID);
-      stack.push({"namespace", newParent});
-      parent = newParent;
-    } else if (index.records.contains(parent.parentNamespaceID)) {
-      const auto& newParent = index.records.entries.at(parent.parentNamespaceID);
-      stack.push({newParent.type, newParent});
-      parent = newParent;
+    if (const auto ns = index.namespaces.find(parent.parentNamespaceID)) {
+      stack.push({"namespace", *ns});
+      parent = *ns;
+    } else if (const auto record = index.records.find(parent.parentNamespaceID)) {
+      stack.push({record->type, *record});
+      parent = *record;
     } else {
       break;
     }
@@ -519,14 +566,15 @@ static void printFunction(const hdoc::types::FunctionSymbol& f,
 
 /// Print all of the functions that aren't record members in a project
 void hdoc::serde::HTMLWriter::printFunctions() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print functions");
+  CTML::Node              main("main");
   main.AddChild(CTML::Node("h1", "Functions"));
 
   // Print a bullet list of functions
   uint64_t   numFunctions = 0; // Number of functions that aren't methods
   CTML::Node ul("ul");
-  for (const auto& id : getSortedIDs(map2vec(this->index->functions), this->index->functions)) {
-    const auto& f = this->index->functions.entries.at(id);
+  PageQueue  pages(this->pool);
+  for (const auto& f : this->index->functions) {
     if (f.isRecordMember) {
       continue;
     }
@@ -535,8 +583,9 @@ void hdoc::serde::HTMLWriter::printFunctions() const {
                     .AddChild(CTML::Node("a.is-family-code", f.name).SetAttr("href", f.url()))
                     .AppendText(getSymbolBlurb(f)));
     CTML::Node page("main");
-    this->pool.async(
+    pages.async(
         [&](const hdoc::types::FunctionSymbol& func, CTML::Node pg) {
+          hdoc::utils::TraceScope trace("Render function", func.name);
           printFunction(func, pg, this->cfg->gitRepoURL, this->cfg->gitDefaultBranch);
           printNewPage(*this->cfg,
                        pg,
@@ -547,7 +596,7 @@ void hdoc::serde::HTMLWriter::printFunctions() const {
         f,
         page);
   }
-  this->pool.wait();
+  pages.wait();
   main.AddChild(CTML::Node("h2", "Overview"));
   if (numFunctions == 0) {
     main.AddChild(CTML::Node("p", "No functions were declared in this project."));
@@ -558,7 +607,7 @@ void hdoc::serde::HTMLWriter::printFunctions() const {
       *this->cfg, main, this->cfg->outputDir / "functions.html", "Functions: " + this->cfg->getPageTitleSuffix());
 }
 
-static std::vector<hdoc::types::RecordSymbol::BaseRecord> getInheritedSymbols(const hdoc::types::Index*        index,
+static std::vector<hdoc::types::RecordSymbol::BaseRecord> getInheritedSymbols(const hdoc::types::FrozenIndex* index,
                                                                               const hdoc::types::RecordSymbol& root) {
   std::vector<hdoc::types::RecordSymbol::BaseRecord> vec   = {};
   std::stack<hdoc::types::RecordSymbol::BaseRecord>  stack = {};
@@ -572,7 +621,8 @@ static std::vector<hdoc::types::RecordSymbol::BaseRecord> getInheritedSymbols(co
     stack.pop();
 
     // Quit if the base record is in std namespace
-    if (index->records.contains(record.id) == false) {
+    const auto c = index->records.find(record.id);
+    if (c == nullptr) {
       continue;
     }
 
@@ -586,8 +636,7 @@ static std::vector<hdoc::types::RecordSymbol::BaseRecord> getInheritedSymbols(co
     vec.emplace_back(record);
 
     // Add children to stack for traversing
-    const auto& c = index->records.entries.at(record.id);
-    for (const auto& baseRecord : c.baseRecords) {
+    for (const auto& baseRecord : c->baseRecords) {
       stack.push(baseRecord);
     }
   }
@@ -646,11 +695,11 @@ static void printMemberVariables(const hdoc::types::RecordSymbol& c, CTML::Node&
 
 /// Print a list of inherited methods for the given record, truncating the method declaration
 static void
-printInheritedMethods(const hdoc::types::Index* index, const hdoc::types::RecordSymbol& c, CTML::Node& main) {
+printInheritedMethods(const hdoc::types::FrozenIndex* index, const hdoc::types::RecordSymbol& c, CTML::Node& main) {
   auto ul = CTML::Node("ul");
 
-  for (const auto& methodID : getSortedIDs(c.methodIDs, index->functions)) {
-    const auto& f = index->functions.entries.at(methodID);
+  for (const auto& method : index->functions.sorted(c.methodIDs)) {
+    const auto& f = *method;
     // Skip private functions and ctors/dtors that aren't inherited
     if (f.access == clang::AS_private || f.isCtorOrDtor) {
       continue;
@@ -672,7 +721,8 @@ printInheritedMethods(const hdoc::types::Index* index, const hdoc::types::Record
 
 /// Print a record to main
 void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Render record", c.name);
+  CTML::Node              main("main");
 
   const std::string pageTitle = c.type + " " + c.name;
   main.AddChild(CTML::Node("h1", pageTitle));
@@ -703,11 +753,10 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
         baseP.AppendText(", ");
       }
       // Check if type is a string, indicating it's a std record that isn't in the DB
-      if (this->index->records.contains(baseRecord.id) == false) {
-        baseP.AppendText(baseRecord.name);
+      if (const auto p = this->index->records.find(baseRecord.id)) {
+        baseP.AddChild(CTML::Node("a", p->name).SetAttr("href", p->url()));
       } else {
-        const auto& p = this->index->records.entries.at(baseRecord.id);
-        baseP.AddChild(CTML::Node("a", p.name).SetAttr("href", p.url()));
+        baseP.AppendText(baseRecord.name);
       }
       count++;
     }
@@ -745,7 +794,8 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
   // Print inherited member variables
   const auto inheritedRecords = getInheritedSymbols(this->index, c);
   for (const auto& base : inheritedRecords) {
-    const auto& ic = this->index->records.entries.at(base.id);
+    const auto  inherited = this->index->records.at(base.id);
+    const auto& ic        = *inherited;
     if (hasMemberVariableHeading == false && ic.vars.size() > 0) {
       main.AddChild(CTML::Node("h2", "Member Variables"));
       hasMemberVariableHeading = true;
@@ -754,14 +804,14 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
   }
 
   // Method overview in list form
-  const auto& sortedMethodIDs          = getSortedIDs(c.methodIDs, this->index->functions);
-  bool        hasMethodOverviewHeading = false;
-  if (sortedMethodIDs.size() > 0) {
+  const auto sortedMethods            = this->index->functions.sorted(c.methodIDs);
+  bool       hasMethodOverviewHeading = false;
+  if (sortedMethods.size() > 0) {
     main.AddChild(CTML::Node("h2", "Method Overview"));
     hasMethodOverviewHeading = true;
     CTML::Node ul("ul");
-    for (auto methodID : sortedMethodIDs) {
-      const hdoc::types::FunctionSymbol m = this->index->functions.entries.at(methodID);
+    for (const auto& method : sortedMethods) {
+      const hdoc::types::FunctionSymbol& m = *method;
 
       // Divide up the full function declaration so its name can be bold in the HTML
       const uint64_t    nameLen  = m.name.size();
@@ -778,7 +828,8 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
 
   // Add inherited methods to the list
   for (const auto& base : inheritedRecords) {
-    const auto& ic = this->index->records.entries.at(base.id);
+    const auto  inherited = this->index->records.at(base.id);
+    const auto& ic        = *inherited;
     if (hasMethodOverviewHeading == false && c.methodIDs.size() > 0) {
       main.AddChild(CTML::Node("h2", "Method Overview"));
       hasMethodOverviewHeading = true;
@@ -787,16 +838,10 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
   }
 
   // List of methods with full information
-  if (sortedMethodIDs.size() > 0) {
+  if (sortedMethods.size() > 0) {
     main.AddChild(CTML::Node("h2", "Methods"));
-    for (const auto& methodID : sortedMethodIDs) {
-      // TODO: get to the bottom of what's causing empty method decls to appear in Writer.hpp
-      // For now this hack just avoids printing them, but this shouldn't be necessary
-      if (index->functions.contains(methodID) == false) {
-        continue;
-      }
-      printFunction(
-          this->index->functions.entries.at(methodID), main, this->cfg->gitRepoURL, this->cfg->gitDefaultBranch);
+    for (const auto& method : sortedMethods) {
+      printFunction(*method, main, this->cfg->gitRepoURL, this->cfg->gitDefaultBranch);
     }
   }
 
@@ -809,21 +854,22 @@ void hdoc::serde::HTMLWriter::printRecord(const hdoc::types::RecordSymbol& c) co
 
 /// Print all of the records in a project
 void hdoc::serde::HTMLWriter::printRecords() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print records");
+  CTML::Node              main("main");
   main.AddChild(CTML::Node("h1", "Records"));
 
   // List of all the records defined, with links to the individual record HTML
   CTML::Node ul("ul");
-  for (const auto& id : getSortedIDs(map2vec(this->index->records), this->index->records)) {
-    const auto& c = this->index->records.entries.at(id);
+  PageQueue  pages(this->pool);
+  for (const auto& c : this->index->records) {
     ul.AddChild(CTML::Node("li")
                     .AddChild(CTML::Node("a.is-family-code", c.type + " " + c.name).SetAttr("href", c.url()))
                     .AppendText(getSymbolBlurb(c)));
-    this->pool.async([&](const hdoc::types::RecordSymbol& cls) { printRecord(cls); }, c);
+    pages.async([&](const hdoc::types::RecordSymbol& cls) { printRecord(cls); }, c);
   }
-  this->pool.wait();
+  pages.wait();
   main.AddChild(CTML::Node("h2", "Overview"));
-  if (this->index->records.entries.size() == 0) {
+  if (this->index->records.empty()) {
     main.AddChild(CTML::Node("p", "No records were declared in this project."));
   } else {
     main.AddChild(ul);
@@ -833,7 +879,7 @@ void hdoc::serde::HTMLWriter::printRecords() const {
 
 /// Recursively print an single namespace and all of its children
 /// Should be tail-call optimized
-static CTML::Node printNamespace(const hdoc::types::NamespaceSymbol& ns, const hdoc::types::Index& index) {
+static CTML::Node printNamespace(const hdoc::types::NamespaceSymbol& ns, const hdoc::types::FrozenIndex& index) {
   // Base case: stop recursion when namespace has no further children
   // and return an empty node, which will not be appended since we have a custom version of CTML
   if (ns.records.size() == 0 && ns.enums.size() == 0 && ns.namespaces.size() == 0) {
@@ -843,52 +889,37 @@ static CTML::Node printNamespace(const hdoc::types::NamespaceSymbol& ns, const h
   auto node  = CTML::Node("li.is-family-code#" + ns.ID.str(), ns.name);
   auto subUL = CTML::Node("ul");
 
-  const std::vector<hdoc::types::SymbolID> childNamespaces = getSortedIDs(ns.namespaces, index.namespaces);
-  const std::vector<hdoc::types::SymbolID> childRecords    = getSortedIDs(ns.records, index.records);
-  const std::vector<hdoc::types::SymbolID> childEnums      = getSortedIDs(ns.enums, index.enums);
-
-  for (const auto& childID : childNamespaces) {
-    if (index.namespaces.contains(childID == false)) {
-      continue;
-    }
-    auto childNode = printNamespace(index.namespaces.entries.at(childID), index);
+  for (const auto& child : index.namespaces.sorted(ns.namespaces)) {
+    auto childNode = printNamespace(*child, index);
     subUL.AddChild(childNode);
   }
-  for (const auto& childID : childRecords) {
-    if (index.records.contains(childID == false)) {
-      continue;
-    }
-    const hdoc::types::RecordSymbol s = index.records.entries.at(childID);
+  for (const auto& s : index.records.sorted(ns.records)) {
     subUL.AddChild(
-        CTML::Node("li.is-family-code").AddChild(CTML::Node("a", s.type + " " + s.name).SetAttr("href", s.url())));
+        CTML::Node("li.is-family-code").AddChild(CTML::Node("a", s->type + " " + s->name).SetAttr("href", s->url())));
   }
-  for (const auto& childID : childEnums) {
-    if (index.enums.contains(childID == false)) {
-      continue;
-    }
-    const hdoc::types::EnumSymbol s = index.enums.entries.at(childID);
+  for (const auto& s : index.enums.sorted(ns.enums)) {
     subUL.AddChild(
-        CTML::Node("li.is-family-code").AddChild(CTML::Node("a", s.type + " " + s.name).SetAttr("href", s.url())));
+        CTML::Node("li.is-family-code").AddChild(CTML::Node("a", s->type + " " + s->name).SetAttr("href", s->url())));
   }
   return node.AddChild(subUL);
 }
 
 /// Print all of the namespaces in a project in a nice tree-view
 void hdoc::serde::HTMLWriter::printNamespaces() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print namespaces");
+  CTML::Node              main("main");
   main.AddChild(CTML::Node("h1", "Namespaces"));
 
   CTML::Node namespaceTree("ul");
 
-  for (const auto& id : getSortedIDs(map2vec(this->index->namespaces), this->index->namespaces)) {
-    const auto& ns = this->index->namespaces.entries.at(id);
+  for (const auto& ns : this->index->namespaces) {
     // Only recurse root namespaces (that have no parents)
     if (ns.parentNamespaceID.raw() != 0) {
       continue;
     }
     namespaceTree.AddChild(printNamespace(ns, *this->index));
   }
-  if (this->index->namespaces.entries.size() == 0) {
+  if (this->index->namespaces.empty()) {
     main.AddChild(CTML::Node("p", "No namespaces were declared in this project."));
   } else {
     main.AddChild(namespaceTree);
@@ -899,8 +930,9 @@ void hdoc::serde::HTMLWriter::printNamespaces() const {
 
 /// Print an enum to main
 void hdoc::serde::HTMLWriter::printEnum(const hdoc::types::EnumSymbol& e) const {
-  CTML::Node        main("main");
-  const std::string pageTitle = e.type + " " + e.name;
+  hdoc::utils::TraceScope trace("Render enum", e.name);
+  CTML::Node              main("main");
+  const std::string       pageTitle = e.type + " " + e.name;
   main.AddChild(CTML::Node("h1", pageTitle));
 
   // Description
@@ -946,20 +978,21 @@ void hdoc::serde::HTMLWriter::printEnum(const hdoc::types::EnumSymbol& e) const
 
 /// Print all of the enums in a project
 void hdoc::serde::HTMLWriter::printEnums() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print enums");
+  CTML::Node              main("main");
   main.AddChild(CTML::Node("h1", "Enums"));
 
   CTML::Node ul("ul");
-  for (const auto& id : getSortedIDs(map2vec(this->index->enums), this->index->enums)) {
-    const auto& e = this->index->enums.entries.at(id);
+  PageQueue  pages(this->pool);
+  for (const auto& e : this->index->enums) {
     ul.AddChild(CTML::Node("li")
                     .AddChild(CTML::Node("a.is-family-code", e.type + " " + e.name).SetAttr("href", e.url()))
                     .AppendText(getSymbolBlurb(e)));
-    this->pool.async([&](const hdoc::types::EnumSymbol& en) { printEnum(en); }, e);
+    pages.async([&](const hdoc::types::EnumSymbol& en) { printEnum(en); }, e);
   }
-  this->pool.wait();
+  pages.wait();
   main.AddChild(CTML::Node("h2", "Overview"));
-  if (this->index->enums.entries.size() == 0) {
+  if (this->index->enums.empty()) {
     main.AddChild(CTML::Node("p", "No enums were declared in this project."));
   } else {
     main.AddChild(ul);
@@ -968,7 +1001,8 @@ void hdoc::serde::HTMLWriter::printEnums() const {
 }
 
 void hdoc::serde::HTMLWriter::printSearchPage() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print search page");
+  CTML::Node              main("main");
 
   main.AddChild(CTML::Node("h1", "Search"));
   const auto noscriptTagText = R"(Search requires Javascript to be enabled.
@@ -993,18 +1027,16 @@ We have left the Javascript code unminified so that you are able to inspect it y
   llvm::json::OStream  json(jsonPath);
 
   json.array([&] {
-    for (const auto& s : this->index->functions.entries)
+    for (const auto& f : this->index->functions)
       json.object([&] {
-        auto& f = s.second;
         json.attribute("sid", f.isRecordMember ? f.parentNamespaceID.str() + ".html#" + f.ID.str() : f.ID.str());
         json.attribute("name", f.name);
         json.attribute("decl", f.proto);
         json.attribute("type", f.isRecordMember ? 0 : 1);
       });
 
-    for (const auto& s : this->index->records.entries) {
+    for (const auto& c : this->index->records) {
       json.object([&] {
-        auto& c = s.second;
         json.attribute("sid", c.ID.str());
         json.attribute("name", c.name);
         json.attribute("decl", c.proto);
@@ -1018,18 +1050,16 @@ We have left the Javascript code unminified so that you are able to inspect it y
       });
     }
 
-    for (const auto& s : this->index->enums.entries) {
+    for (const auto& e : this->index->enums) {
       json.object([&] {
-        auto& e = s.second;
         json.attribute("sid", e.ID.str());
         json.attribute("name", e.name);
         json.attribute("decl", e.name);
         json.attribute("type", 5);
       });
 
-      for (const auto& ev : s.second.members) {
+      for (const auto& ev : e.members) {
         json.object([&] {
-          auto& e = s.second;
           json.attribute("sid", e.ID.str());
           json.attribute("name", ev.name);
           json.attribute("decl", e.name + "::" + ev.name);
@@ -1042,7 +1072,8 @@ We have left the Javascript code unminified so that you are able to inspect it y
 
 /// Print the homepage of the documentation
 void hdoc::serde::HTMLWriter::printProjectIndex() const {
-  CTML::Node main("main");
+  hdoc::utils::TraceScope trace("Print project index");
+  CTML::Node              main("main");
 
   // If index markdown page was supplied, convert it to markdown and print it
   if (this->cfg->homepage != "") {
@@ -1065,6 +1096,7 @@ void hdoc::serde::HTMLWriter::printProjectIndex() const {
 }
 
 void hdoc::serde::HTMLWriter::processMarkdownFiles() const {
+  hdoc::utils::TraceScope trace("Process markdown files");
   for (const auto& f : this->cfg->mdPaths) {
     spdlog::info("Processing markdown file {}", f.string());
     hdoc::utils::MarkdownConverter converter(f);
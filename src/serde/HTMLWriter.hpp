@@ -6,7 +6,7 @@
 #include "llvm/Support/ThreadPool.h"
 
 #include "types/Config.hpp"
-#include "types/Index.hpp"
+#include "types/FrozenIndex.hpp"
 
 namespace hdoc {
 namespace serde {
@@ -14,7 +14,7 @@ namespace serde {
 /// @brief Serialize hdoc's index to HTML files
 class HTMLWriter {
 public:
-  HTMLWriter(const hdoc::types::Index* index, const hdoc::types::Config* cfg, llvm::ThreadPool& pool);
+  HTMLWriter(const hdoc::types::FrozenIndex* index, const hdoc::types::Config* cfg, llvm::ThreadPool& pool);
   void printFunctions() const;
   void printRecords() const;
   void printRecord(const hdoc::types::RecordSymbol& c) const;
@@ -32,9 +32,9 @@ public:
   void processMarkdownFiles() const;
 
 private:
-  const hdoc::types::Index*  index;
-  const hdoc::types::Config* cfg;
-  llvm::ThreadPool&          pool;
+  const hdoc::types::FrozenIndex* index;
+  const hdoc::types::Config*      cfg;
+  llvm::ThreadPool&               pool;
 };
 std::string getHyperlinkedFunctionProto(const std::string_view proto, const hdoc::types::FunctionSymbol& f);
 std::string clangFormat(const std::string_view s, const uint64_t& columnLimit = 50);
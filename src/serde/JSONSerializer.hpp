@@ -5,10 +5,16 @@
 
 #include "serde/SerdeUtils.hpp"
 #include "types/Config.hpp"
+#include "types/FrozenIndex.hpp"
 #include "types/Index.hpp"
 
+#include "rapidjson/ostreamwrapper.h"
 #include "rapidjson/prettywriter.h"
 
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
 namespace hdoc {
 namespace serde {
 
@@ -25,7 +31,7 @@ public:
     writer.String("briefComment");
     writer.String(sym.briefComment);
     writer.String("file");
-    writer.String(sym.file);
+    writer.String(sym.file.data(), sym.file.size());
     writer.String("line");
     writer.Uint64(sym.line);
     writer.String("parentNamespaceID");
@@ -37,7 +43,7 @@ public:
     writer.String("id");
     writer.Uint64(typeRef.id.hashValue);
     writer.String("name");
-    writer.String(typeRef.name);
+    writer.String(typeRef.name.data(), typeRef.name.size());
     writer.EndObject();
   }
 
@@ -136,8 +142,7 @@ public:
   template <typename Writer> void serializeFunctions(Writer& writer) const {
     writer.Key("functions");
     writer.StartArray();
-    for (const auto& id : getSortedIDs(map2vec(this->index->functions), this->index->functions)) {
-      const auto& f = this->index->functions.entries.at(id);
+    for (const auto& f : this->index->functions) {
       this->serializeFunction(f, writer);
     }
     writer.EndArray();
@@ -208,8 +213,7 @@ public:
   template <typename Writer> void serializeRecords(Writer& writer) const {
     writer.Key("records");
     writer.StartArray();
-    for (const auto& id : getSortedIDs(map2vec(this->index->records), this->index->records)) {
-      const auto& s = this->index->records.entries.at(id);
+    for (const auto& s : this->index->records) {
       this->serializeRecord(s, writer);
     }
     writer.EndArray();
@@ -247,8 +251,7 @@ public:
   template <typename Writer> void serializeNamespaces(Writer& writer) const {
     writer.Key("namespaces");
     writer.StartArray();
-    for (const auto& id : getSortedIDs(map2vec(this->index->namespaces), this->index->namespaces)) {
-      const auto& s = this->index->namespaces.entries.at(id);
+    for (const auto& s : this->index->namespaces) {
       this->serializeNamespace(s, writer);
     }
     writer.EndArray();
@@ -280,8 +283,7 @@ public:
   template <typename Writer> void serializeEnums(Writer& writer) const {
     writer.Key("enums");
     writer.StartArray();
-    for (const auto& id : getSortedIDs(map2vec(this->index->enums), this->index->enums)) {
-      const auto& e = this->index->enums.entries.at(id);
+    for (const auto& e : this->index->enums) {
       this->serializeEnum(e, writer);
     }
     writer.EndArray();
@@ -312,12 +314,13 @@ public:
     }
   }
 
-  JSONSerializer(const hdoc::types::Index* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
-
-  std::string getJSONPayload() const {
-    rapidjson::StringBuffer                          buf;
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buf);
+  JSONSerializer(const hdoc::types::FrozenIndex* index, const hdoc::types::Config* cfg) : index(index), cfg(cfg) {}
+  /// @brief Serialize an Index that hasn't been frozen yet, which freezes a copy of it
+  JSONSerializer(const hdoc::types::Index* index, const hdoc::types::Config* cfg)
+      : ownedIndex(std::make_unique<hdoc::types::FrozenIndex>(*index)), index(ownedIndex.get()), cfg(cfg) {}
 
+  /// @brief Write the whole payload with writer, one symbol at a time
+  template <typename Writer> void serializePayload(Writer& writer) const {
     writer.StartObject();
     writer.Key("config");
     writer.StartObject();
@@ -348,13 +351,26 @@ public:
     this->serializeMarkdownFiles(writer);
     writer.EndArray();
     writer.EndObject();
+  }
 
-    return buf.GetString();
+  /// @brief Write the payload to a file as it's serialized, so that the payload of an Index that was spilled to disk
+  /// is never held in memory all at once. Returns false if the file couldn't be written.
+  bool writeJSONPayload(const std::filesystem::path& path) const {
+    std::ofstream out(path);
+    if (!out) {
+      return false;
+    }
+    rapidjson::OStreamWrapper                          os(out);
+    rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(os);
+    this->serializePayload(writer);
+    out.flush();
+    return out.good();
   }
 
 private:
-  const hdoc::types::Index*  index;
-  const hdoc::types::Config* cfg;
+  std::unique_ptr<hdoc::types::FrozenIndex> ownedIndex; ///< Only set if the serializer was given an unfrozen Index
+  const hdoc::types::FrozenIndex*           index;
+  const hdoc::types::Config*                cfg;
 };
 } // namespace serde
 } // namespace hdoc
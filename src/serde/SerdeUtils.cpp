@@ -20,15 +20,3 @@ void slurpFile(const std::filesystem::path& path, std::string& str) {
 
   str.assign((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
 }
-
-bool dumpJSONPayload(const std::string_view data) {
-  std::ofstream out("hdoc-payload.json");
-  if (!out) {
-    spdlog::error("Failed to open hdoc-payload.json file in current working directory.");
-    return false;
-  }
-
-  out << data;
-  spdlog::info("hdoc-payload.json successfully written to current working directory.");
-  return true;
-}
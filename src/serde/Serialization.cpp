@@ -5,6 +5,8 @@
 #include "serde/JSONDeserializer.hpp"
 #include "serde/JSONSerializer.hpp"
 #include "serde/SerdeUtils.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
 #include "types/SerializedMarkdownFile.hpp"
 #include "types/Symbols.hpp"
 
@@ -12,6 +14,9 @@
 #include "spdlog/spdlog.h"
 
 #include <httplib.h>
+
+#include <algorithm>
+#include <fstream>
 #include <string>
 
 #ifdef HDOC_RELEASE_BUILD
@@ -22,10 +27,19 @@ constexpr char hdocURL[] = "https://staging.hdoc.io";
 
 namespace hdoc::serde {
 
-std::string serializeToJSON(const hdoc::types::Index& index, const hdoc::types::Config& cfg) {
+bool serializeToJSON(const hdoc::types::FrozenIndex& index,
+                     const hdoc::types::Config&      cfg,
+                     const std::filesystem::path&    path) {
+  hdoc::utils::TraceScope     trace("Serialize to JSON");
   hdoc::serde::JSONSerializer jsonSerializer(&index, &cfg);
-  std::string                 payload = jsonSerializer.getJSONPayload();
-  return payload;
+  if (!jsonSerializer.writeJSONPayload(path)) {
+    spdlog::error("Failed to write JSON payload to {}.", path.string());
+    return false;
+  }
+
+  std::error_code ec;
+  hdoc::utils::Metrics::global().jsonPayloadSize = std::filesystem::file_size(path, ec);
+  return true;
 }
 
 bool deserializeFromJSON(hdoc::types::Index& index, hdoc::types::Config& cfg) {
@@ -93,7 +107,7 @@ bool verify() {
   return true;
 }
 
-void uploadDocs(const std::string_view data) {
+void uploadDocs(const std::filesystem::path& path) {
   spdlog::info("Uploading documentation for hosting.");
   const char* val     = std::getenv("HDOC_PROJECT_API_KEY");
   std::string api_key = val == NULL ? std::string("") : std::string(val);
@@ -110,7 +124,31 @@ void uploadDocs(const std::string_view data) {
       {"X-Schema-Version", "v5"},
   };
 
-  const auto res = cli.Put("/api/upload/", headers, data.data(), data.size(), "application/json");
+  // The payload is read from disk as it's sent instead of being loaded into memory all at once, so only its compressed
+  // form is ever held in memory
+  std::ifstream   payload(path, std::ios::binary);
+  std::error_code ec;
+  const uint64_t  size = std::filesystem::file_size(path, ec);
+  if (!payload || ec) {
+    spdlog::error("Unable to read JSON payload from {}, unable to proceed.", path.string());
+    return;
+  }
+
+  const auto res = cli.Put(
+      "/api/upload/",
+      headers,
+      size,
+      [&payload](const size_t offset, const size_t length, httplib::DataSink& sink) {
+        char buf[64 * 1024];
+        payload.seekg(offset);
+        payload.read(buf, std::min(length, sizeof(buf)));
+        if (payload.gcount() <= 0) {
+          return false;
+        }
+        sink.write(buf, payload.gcount());
+        return true;
+      },
+      "application/json");
   if (res == nullptr) {
     spdlog::error("Upload failed, unable to proceed. Check that you're connected to the internet.");
     return;
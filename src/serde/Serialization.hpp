@@ -3,12 +3,18 @@
 
 #pragma once
 
+#include <filesystem>
+
 #include "types/Config.hpp"
+#include "types/FrozenIndex.hpp"
 #include "types/Index.hpp"
 
 namespace hdoc::serde {
 /// @brief Serialize hdoc's index to a single file in JSON format on the disk
-std::string serializeToJSON(const hdoc::types::Index& index, const hdoc::types::Config& cfg);
+/// Returns true if the file was written, and false if it wasn't.
+bool serializeToJSON(const hdoc::types::FrozenIndex& index,
+                     const hdoc::types::Config&      cfg,
+                     const std::filesystem::path&    path);
 
 /// @brief Deserialize hdoc's index in JSON format back into hdoc's internal data structures
 /// Returns true if the deserialization succeeded, and false if it didn't.
@@ -17,6 +23,6 @@ bool deserializeFromJSON(hdoc::types::Index& index, hdoc::types::Config& cfg);
 /// @brief Verify that the user's API key is valid prior to uploading documentation
 bool verify();
 
-/// @brief Upload the serialized Index to hdoc.io for hosting
-void uploadDocs(const std::string_view data);
+/// @brief Upload the serialized Index at path to hdoc.io for hosting
+void uploadDocs(const std::filesystem::path& path);
 } // namespace hdoc::serde
@@ -0,0 +1,233 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/CachingFileSystem.hpp"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+namespace {
+/// @brief A MemoryBuffer that refers to a buffer in the FileSystemCache, keeping it alive
+class SharedMemoryBuffer : public llvm::MemoryBuffer {
+public:
+  SharedMemoryBuffer(std::shared_ptr<llvm::MemoryBuffer> buffer, const std::string& name)
+      : buffer(std::move(buffer)), name(name) {
+    // Cached buffers are always null-terminated, so they satisfy callers that need it and those that don't
+    this->init(this->buffer->getBufferStart(), this->buffer->getBufferEnd(), true);
+  }
+
+  llvm::StringRef getBufferIdentifier() const override {
+    return this->name;
+  }
+
+  BufferKind getBufferKind() const override {
+    return this->buffer->getBufferKind();
+  }
+
+private:
+  std::shared_ptr<llvm::MemoryBuffer> buffer;
+  std::string                         name;
+};
+
+/// @brief A file whose status and contents come from the FileSystemCache
+class CachedFile : public llvm::vfs::File {
+public:
+  CachedFile(llvm::vfs::Status status, std::shared_ptr<llvm::MemoryBuffer> buffer)
+      : fileStatus(std::move(status)), buffer(std::move(buffer)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status() override {
+    return this->fileStatus;
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const llvm::Twine& name, int64_t, bool, bool) override {
+    return std::make_unique<SharedMemoryBuffer>(this->buffer, name.str());
+  }
+
+  std::error_code close() override {
+    return std::error_code();
+  }
+
+protected:
+  void setPath(const llvm::Twine& path) override {
+    this->fileStatus = llvm::vfs::Status::copyWithNewName(this->fileStatus, path);
+  }
+
+private:
+  llvm::vfs::Status                   fileStatus;
+  std::shared_ptr<llvm::MemoryBuffer> buffer;
+};
+
+/// @brief Iterates over a cached directory listing, prefixing each entry with the path the directory was listed as
+class CachedDirIterImpl : public llvm::vfs::detail::DirIterImpl {
+public:
+  CachedDirIterImpl(const std::string& dir, hdoc::indexer::FileSystemCache::Listing listing)
+      : dir(dir), listing(std::move(listing)) {
+    this->setCurrentEntry();
+  }
+
+  std::error_code increment() override {
+    this->index++;
+    this->setCurrentEntry();
+    return std::error_code();
+  }
+
+private:
+  void setCurrentEntry() {
+    if (this->index >= this->listing->size()) {
+      this->CurrentEntry = llvm::vfs::directory_entry();
+      return;
+    }
+    const hdoc::indexer::FileSystemCache::DirEntry& entry = (*this->listing)[this->index];
+    llvm::SmallString<256>                          path(this->dir);
+    llvm::sys::path::append(path, entry.name);
+    this->CurrentEntry = llvm::vfs::directory_entry(path.str().str(), entry.type);
+  }
+
+  std::string                             dir;
+  hdoc::indexer::FileSystemCache::Listing listing;
+  size_t                                  index = 0;
+};
+} // namespace
+
+hdoc::indexer::FileSystemCache::Shard& hdoc::indexer::FileSystemCache::shard(const llvm::StringRef path) {
+  return this->shards[llvm::xxHash64(path) % numShards];
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+hdoc::indexer::FileSystemCache::status(const llvm::StringRef                                  path,
+                                       llvm::function_ref<llvm::ErrorOr<llvm::vfs::Status>()> lookup) {
+  Shard& s = this->shard(path);
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (const auto it = s.statuses.find(path); it != s.statuses.end()) {
+      this->numStatusHits.fetch_add(1, std::memory_order_relaxed);
+      return it->getValue();
+    }
+  }
+
+  // Another thread might look up the same path at the same time, in which case its result is kept
+  this->numStatusMisses.fetch_add(1, std::memory_order_relaxed);
+  llvm::ErrorOr<llvm::vfs::Status> result = lookup();
+  std::lock_guard<std::mutex>      lock(s.mutex);
+  return s.statuses.try_emplace(path, std::move(result)).first->getValue();
+}
+
+llvm::ErrorOr<std::shared_ptr<llvm::MemoryBuffer>> hdoc::indexer::FileSystemCache::buffer(
+    const llvm::StringRef path, llvm::function_ref<llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>()> read) {
+  Shard& s = this->shard(path);
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (const auto it = s.buffers.find(path); it != s.buffers.end()) {
+      this->numBufferHits.fetch_add(1, std::memory_order_relaxed);
+      return it->getValue();
+    }
+  }
+
+  this->numBufferMisses.fetch_add(1, std::memory_order_relaxed);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> result = read();
+  if (!result) {
+    return result.getError();
+  }
+  std::shared_ptr<llvm::MemoryBuffer> buffer = std::move(*result);
+  std::lock_guard<std::mutex>         lock(s.mutex);
+  const auto [it, inserted]                  = s.buffers.try_emplace(path, buffer);
+  if (inserted) {
+    this->bytesCached.fetch_add(buffer->getBufferSize(), std::memory_order_relaxed);
+  }
+  return it->getValue();
+}
+
+llvm::ErrorOr<hdoc::indexer::FileSystemCache::Listing>
+hdoc::indexer::FileSystemCache::directory(const llvm::StringRef                                      path,
+                                          llvm::function_ref<llvm::ErrorOr<std::vector<DirEntry>>()> list) {
+  Shard& s = this->shard(path);
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (const auto it = s.directories.find(path); it != s.directories.end()) {
+      this->numDirectoryHits.fetch_add(1, std::memory_order_relaxed);
+      return it->getValue();
+    }
+  }
+
+  this->numDirectoryMisses.fetch_add(1, std::memory_order_relaxed);
+  llvm::ErrorOr<std::vector<DirEntry>> entries = list();
+  llvm::ErrorOr<Listing>               result  = entries.getError();
+  if (entries) {
+    result = std::make_shared<const std::vector<DirEntry>>(std::move(*entries));
+  }
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.directories.try_emplace(path, std::move(result)).first->getValue();
+}
+
+std::string hdoc::indexer::CachingFileSystem::absolute(const llvm::Twine& path) const {
+  llvm::SmallString<256> result;
+  path.toVector(result);
+  // If the working directory can't be determined, the path is looked up as is, which is what the
+  // underlying file system would do as well
+  this->makeAbsolute(result);
+  llvm::sys::path::remove_dots(result);
+  return result.str().str();
+}
+
+llvm::ErrorOr<llvm::vfs::Status> hdoc::indexer::CachingFileSystem::status(const llvm::Twine& path) {
+  const std::string                      absolutePath = this->absolute(path);
+  const llvm::ErrorOr<llvm::vfs::Status> result =
+      this->cache->status(absolutePath, [&] { return this->getUnderlyingFS().status(absolutePath); });
+  if (!result) {
+    return result;
+  }
+  return llvm::vfs::Status::copyWithNewName(*result, path);
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+hdoc::indexer::CachingFileSystem::openFileForRead(const llvm::Twine& path) {
+  const std::string                      absolutePath = this->absolute(path);
+  const llvm::ErrorOr<llvm::vfs::Status> fileStatus =
+      this->cache->status(absolutePath, [&] { return this->getUnderlyingFS().status(absolutePath); });
+  if (!fileStatus) {
+    return fileStatus.getError();
+  }
+  if (fileStatus->isDirectory()) {
+    return std::make_error_code(std::errc::is_a_directory);
+  }
+
+  const auto buffer = this->cache->buffer(absolutePath, [&]() -> llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> {
+    auto file = this->getUnderlyingFS().openFileForRead(absolutePath);
+    if (!file) {
+      return file.getError();
+    }
+    // Sources aren't modified while hdoc runs, so they're memory-mapped where possible instead of copied
+    return (*file)->getBuffer(absolutePath, fileStatus->getSize(), true, false);
+  });
+  if (!buffer) {
+    return buffer.getError();
+  }
+  return std::make_unique<CachedFile>(llvm::vfs::Status::copyWithNewName(*fileStatus, path), *buffer);
+}
+
+llvm::vfs::directory_iterator hdoc::indexer::CachingFileSystem::dir_begin(const llvm::Twine& dir, std::error_code& ec) {
+  const std::string                             absolutePath = this->absolute(dir);
+  const llvm::ErrorOr<FileSystemCache::Listing> listing      =
+      this->cache->directory(absolutePath, [&]() -> llvm::ErrorOr<std::vector<FileSystemCache::DirEntry>> {
+        std::vector<FileSystemCache::DirEntry> entries;
+        std::error_code                        err;
+        for (auto it = this->getUnderlyingFS().dir_begin(absolutePath, err), end = llvm::vfs::directory_iterator();
+             it != end && !err;
+             it.increment(err)) {
+          entries.push_back({llvm::sys::path::filename(it->path()).str(), it->type()});
+        }
+        if (err) {
+          return err;
+        }
+        return entries;
+      });
+
+  if (!listing) {
+    ec = listing.getError();
+    return llvm::vfs::directory_iterator();
+  }
+  ec = std::error_code();
+  return llvm::vfs::directory_iterator(std::make_shared<CachedDirIterImpl>(dir.str(), *listing));
+}
@@ -0,0 +1,92 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+namespace hdoc::indexer {
+/// @brief File system lookups that are shared by the CachingFileSystems of every thread.
+///
+/// Sources don't change while they're being indexed, but every TU looks for the same headers in the same include
+/// paths, so each thread would otherwise stat, list, and read the same files over and over. Statuses, including
+/// ones for paths that don't exist, directory listings, and file contents are stored the first time they're looked
+/// up. Large files are memory-mapped rather than copied. Paths are absolute, so the cache is independent of the
+/// working directory of each thread, and it's split into shards with their own lock to keep contention low.
+class FileSystemCache {
+public:
+  /// @brief A directory entry, stored without the path of its directory
+  struct DirEntry {
+    std::string              name;
+    llvm::sys::fs::file_type type;
+  };
+
+  using Listing = std::shared_ptr<const std::vector<DirEntry>>;
+
+  /// @brief Get the status of path, calling lookup without holding a lock if it isn't cached
+  llvm::ErrorOr<llvm::vfs::Status> status(const llvm::StringRef                                  path,
+                                          llvm::function_ref<llvm::ErrorOr<llvm::vfs::Status>()> lookup);
+
+  /// @brief Get the contents of path, calling read without holding a lock if they aren't cached.
+  /// Errors aren't cached, since they can be transient, i.e. running out of file descriptors.
+  llvm::ErrorOr<std::shared_ptr<llvm::MemoryBuffer>>
+  buffer(const llvm::StringRef path, llvm::function_ref<llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>()> read);
+
+  /// @brief Get the entries of the directory at path, calling list without holding a lock if they aren't cached
+  llvm::ErrorOr<Listing> directory(const llvm::StringRef                                   path,
+                                   llvm::function_ref<llvm::ErrorOr<std::vector<DirEntry>>()> list);
+
+  std::atomic<uint64_t> numStatusHits      = 0; ///< Status lookups that were served from the cache
+  std::atomic<uint64_t> numStatusMisses    = 0; ///< Status lookups that went to disk
+  std::atomic<uint64_t> numBufferHits      = 0; ///< Files that were read from the cache
+  std::atomic<uint64_t> numBufferMisses    = 0; ///< Files that were read from disk
+  std::atomic<uint64_t> numDirectoryHits   = 0; ///< Directories that were listed from the cache
+  std::atomic<uint64_t> numDirectoryMisses = 0; ///< Directories that were listed from disk
+  std::atomic<uint64_t> bytesCached        = 0; ///< Total size of the cached files
+
+private:
+  static constexpr size_t numShards = 64;
+
+  struct alignas(64) Shard {
+    std::mutex                                           mutex;
+    llvm::StringMap<llvm::ErrorOr<llvm::vfs::Status>>    statuses;
+    llvm::StringMap<std::shared_ptr<llvm::MemoryBuffer>> buffers;
+    llvm::StringMap<llvm::ErrorOr<Listing>>              directories;
+  };
+
+  Shard& shard(const llvm::StringRef path);
+
+  std::array<Shard, numShards> shards;
+};
+
+/// @brief A file system that looks up statuses, directories, and files in a FileSystemCache shared with other threads.
+///
+/// Each thread wraps its own physical file system, so that each thread keeps its own working directory. Relative
+/// paths are made absolute before they're looked up, and results carry the path they were requested with, just
+/// like the physical file system. Everything else, including the working directory, is forwarded.
+class CachingFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+  CachingFileSystem(std::shared_ptr<FileSystemCache> cache, llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS)
+      : ProxyFileSystem(std::move(FS)), cache(std::move(cache)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status>                status(const llvm::Twine& path) override;
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override;
+  llvm::vfs::directory_iterator                   dir_begin(const llvm::Twine& dir, std::error_code& ec) override;
+
+private:
+  /// @brief Make path absolute using the working directory of this file system
+  std::string absolute(const llvm::Twine& path) const;
+
+  std::shared_ptr<FileSystemCache> cache;
+};
+} // namespace hdoc::indexer
@@ -0,0 +1,124 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/CostReport.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+void hdoc::indexer::CostReport::add(TUCost cost) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (const auto& entry : cost.headers) {
+    HeaderCost& header = this->headers[entry.getKey()];
+    if (header.numTUs == 0) {
+      header.path = entry.getKey().str();
+    }
+    header.totalTime += entry.getValue();
+    header.numTUs += 1;
+  }
+  // Only the totals are reported, so there's no need to keep the headers of each TU around
+  cost.headers.clear();
+  this->tus.emplace_back(std::move(cost));
+}
+
+std::vector<hdoc::indexer::TUCost> hdoc::indexer::CostReport::slowestTUs(const size_t n) const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  std::vector<TUCost>         result = this->tus;
+  const auto                  end    = result.begin() + std::min(n, result.size());
+  std::partial_sort(result.begin(), end, result.end(), [](const TUCost& lhs, const TUCost& rhs) {
+    return lhs.totalTime > rhs.totalTime;
+  });
+  result.erase(end, result.end());
+  return result;
+}
+
+std::vector<hdoc::indexer::HeaderCost> hdoc::indexer::CostReport::costliestHeaders(const size_t n) const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  std::vector<HeaderCost>     result;
+  result.reserve(this->headers.size());
+  for (const auto& entry : this->headers) {
+    result.emplace_back(entry.getValue());
+  }
+  const auto end = result.begin() + std::min(n, result.size());
+  std::partial_sort(result.begin(), end, result.end(), [](const HeaderCost& lhs, const HeaderCost& rhs) {
+    return lhs.totalTime > rhs.totalTime;
+  });
+  result.erase(end, result.end());
+  return result;
+}
+
+void hdoc::indexer::CostReport::print(const size_t n) const {
+  const auto tus = this->slowestTUs(n);
+  spdlog::info("{} slowest TUs:", tus.size());
+  for (const auto& tu : tus) {
+    spdlog::info("  {:9.1f} ms ({:.1f} ms parsing, {:.1f} ms matching, {} matches){} {}",
+                 tu.totalTime,
+                 tu.parseTime,
+                 tu.matchTime,
+                 tu.numCallbacks(),
+                 tu.failed ? " FAILED" : "",
+                 tu.path);
+  }
+
+  const auto headers = this->costliestHeaders(n);
+  if (headers.empty()) {
+    return;
+  }
+  spdlog::info("{} most expensive headers:", headers.size());
+  for (const auto& header : headers) {
+    spdlog::info("  {:9.1f} ms in {} TUs ({:.1f} ms per TU) {}",
+                 header.totalTime,
+                 header.numTUs,
+                 header.totalTime / header.numTUs,
+                 header.path);
+  }
+}
+
+bool hdoc::indexer::CostReport::write(const std::filesystem::path& path, const size_t n) const {
+  std::error_code      ec;
+  llvm::raw_fd_ostream out(path.string(), ec);
+  if (ec) {
+    return false;
+  }
+
+  llvm::json::OStream json(out, 2);
+  json.object([&] {
+    json.attributeArray("slowestTUs", [&] {
+      for (const auto& tu : this->slowestTUs(n)) {
+        json.object([&] {
+          json.attribute("path", tu.path);
+          json.attribute("failed", tu.failed);
+          json.attribute("totalTimeMs", tu.totalTime);
+          json.attribute("parseTimeMs", tu.parseTime);
+          json.attribute("matchTimeMs", tu.matchTime);
+          json.attribute("memoryBytes", static_cast<int64_t>(tu.memory));
+          json.attributeObject("matches", [&] {
+            json.attribute("functions", static_cast<int64_t>(tu.numFunctions));
+            json.attribute("records", static_cast<int64_t>(tu.numRecords));
+            json.attribute("enums", static_cast<int64_t>(tu.numEnums));
+            json.attribute("namespaces", static_cast<int64_t>(tu.numNamespaces));
+          });
+        });
+      }
+    });
+    json.attributeArray("costliestHeaders", [&] {
+      for (const auto& header : this->costliestHeaders(n)) {
+        json.object([&] {
+          json.attribute("path", header.path);
+          json.attribute("totalTimeMs", header.totalTime);
+          json.attribute("numTUs", static_cast<int64_t>(header.numTUs));
+        });
+      }
+    });
+  });
+  out << "\n";
+  out.flush();
+
+  // raw_fd_ostream aborts on destruction if an error wasn't cleared
+  const bool success = !out.has_error();
+  out.clear_error();
+  return success;
+}
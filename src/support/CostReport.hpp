@@ -0,0 +1,70 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace hdoc::indexer {
+/// @brief Where the time spent on a single TU went. Times are in milliseconds.
+struct TUCost {
+  std::string path;                 ///< Path of the TU's main file
+  bool        failed        = false; ///< Did clang fail to parse the TU?
+  double      totalTime     = 0;     ///< Wall-clock time from starting the TU to indexing its last symbol
+  double      parseTime     = 0;     ///< Preprocessing, parsing, and semantic analysis of the TU
+  double      matchTime     = 0;     ///< Running the matchers or the IndexVisitor over the AST
+  uint64_t    numFunctions  = 0;     ///< Functions that were matched, including ones that weren't indexed
+  uint64_t    numRecords    = 0;     ///< Records that were matched, likewise
+  uint64_t    numEnums      = 0;     ///< Enums that were matched, likewise
+  uint64_t    numNamespaces = 0;     ///< Namespaces that were matched, likewise
+  uint64_t    memory        = 0;     ///< Bytes allocated by clang for the TU's AST, preprocessor, and source manager
+
+  /// Time between entering and leaving each header, including the headers it includes. Only filled in when
+  /// header costs are being collected.
+  llvm::StringMap<double> headers;
+
+  uint64_t numCallbacks() const {
+    return this->numFunctions + this->numRecords + this->numEnums + this->numNamespaces;
+  }
+};
+
+/// @brief Cost of a header, summed over every TU that parsed it
+struct HeaderCost {
+  std::string path;
+  double      totalTime = 0; ///< Time spent parsing the header and the headers it includes, in milliseconds
+  uint32_t    numTUs    = 0; ///< Number of TUs that parsed the header
+};
+
+/// @brief Collects the cost of every TU that is indexed, to find the TUs and headers that make indexing slow.
+///
+/// The slowest TUs are candidates for ignore paths or splitting up, and headers that are expensive in total are
+/// candidates for a shared PCH or for cleaning up their includes.
+class CostReport {
+public:
+  /// @brief Add the cost of a TU, merging its headers into the total cost of each header. Thread-safe.
+  void add(TUCost cost);
+
+  /// @brief Get up to n TUs, from slowest to fastest
+  std::vector<TUCost> slowestTUs(const size_t n) const;
+
+  /// @brief Get up to n headers, from most to least expensive
+  std::vector<HeaderCost> costliestHeaders(const size_t n) const;
+
+  /// @brief Log the n slowest TUs and n costliest headers
+  void print(const size_t n) const;
+
+  /// @brief Write the n slowest TUs and n costliest headers to path as JSON.
+  /// Returns false if the file couldn't be written.
+  bool write(const std::filesystem::path& path, const size_t n) const;
+
+private:
+  mutable std::mutex          mutex;   ///< Protects everything below
+  std::vector<TUCost>         tus;     ///< Every TU that was added, without their headers
+  llvm::StringMap<HeaderCost> headers; ///< Total cost of each header over all TUs
+};
+} // namespace hdoc::indexer
@@ -0,0 +1,190 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/CoveringTUs.hpp"
+
+#include "spdlog/spdlog.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningService.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningTool.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Path.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <queue>
+
+namespace deps = clang::tooling::dependencies;
+
+/// @brief Split the dependencies of a Makefile rule, which are separated by whitespace or escaped newlines, and
+/// may contain escaped spaces
+static std::vector<std::string> parseMakeDependencies(llvm::StringRef rule) {
+  std::vector<std::string> files;
+  // Skip the target of the rule
+  rule = rule.split(": ").second;
+
+  std::string current;
+  for (size_t i = 0; i < rule.size(); i++) {
+    const char c = rule[i];
+    if (c == '\\' && i + 1 < rule.size() && (rule[i + 1] == ' ' || rule[i + 1] == '#')) {
+      current += rule[++i];
+      continue;
+    }
+    if (c == '\\' && i + 1 < rule.size() && rule[i + 1] == '\n') {
+      i++;
+    } else if (c == '$' && i + 1 < rule.size() && rule[i + 1] == '$') {
+      current += rule[++i];
+      continue;
+    } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      current += c;
+      continue;
+    }
+    if (!current.empty()) {
+      files.emplace_back(std::move(current));
+      current.clear();
+    }
+  }
+  if (!current.empty()) {
+    files.emplace_back(std::move(current));
+  }
+  return files;
+}
+
+/// @brief Returns true if file is under rootDir and isn't ignored, i.e. it might contain documented symbols
+static bool isProjectFile(const std::string& file, const hdoc::types::Config* cfg) {
+  const std::string relPath = std::filesystem::relative(file, cfg->rootDir).string();
+  return !relPath.empty() && relPath.find("..") == std::string::npos && !cfg->ignorePaths.matches(relPath);
+}
+
+std::vector<std::string> hdoc::indexer::selectCoveringTUs(const clang::tooling::CompilationDatabase& cmpdb,
+                                                          const std::vector<std::string>&            files,
+                                                          const clang::tooling::ArgumentsAdjuster&   adjuster,
+                                                          const hdoc::types::Config*                 cfg,
+                                                          llvm::ThreadPool&                          pool) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // The service caches the minimized contents of every file, so it's shared by every thread. Each thread gets its
+  // own tool because the tools themselves aren't thread-safe.
+  deps::DependencyScanningService service(deps::ScanningMode::MinimizedSourcePreprocessing,
+                                          deps::ScanningOutputFormat::Make);
+  std::vector<std::vector<std::string>> dependencies(files.size());
+  std::vector<uint8_t>                  scanned(files.size(), false); // Not vector<bool>, it's written concurrently
+
+  const size_t numChunks = std::max<size_t>(pool.getThreadCount(), 1);
+  for (size_t chunk = 0; chunk < numChunks; chunk++) {
+    pool.async([&, chunk]() {
+      deps::DependencyScanningTool tool(service);
+      for (size_t i = chunk; i < files.size(); i += numChunks) {
+        bool ok = true;
+        for (const auto& cmd : cmpdb.getCompileCommands(files[i])) {
+          llvm::Expected<std::string> rule =
+              tool.getDependencyFile(adjuster(cmd.CommandLine, cmd.Filename), cmd.Directory);
+          if (!rule) {
+            spdlog::warn("Unable to scan the dependencies of {} ({}), it will be indexed regardless.",
+                         files[i],
+                         llvm::toString(rule.takeError()));
+            ok = false;
+            break;
+          }
+          for (auto& dep : parseMakeDependencies(*rule)) {
+            llvm::SmallString<256> path(dep);
+            if (llvm::sys::path::is_relative(path)) {
+              path = cmd.Directory;
+              llvm::sys::path::append(path, dep);
+            }
+            llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+            dependencies[i].emplace_back(path.str());
+          }
+        }
+        scanned[i] = ok && !dependencies[i].empty();
+      }
+    });
+  }
+  pool.wait();
+
+  // Number every project file so that the cover can be computed with integers. Other files are numbered -1.
+  llvm::StringMap<int64_t>           fileIDs;
+  std::vector<std::vector<uint32_t>> covers(files.size());
+  std::vector<bool>                  isIncluded; ///< Is the file included by any TU (i.e. not only a main file)?
+  for (size_t i = 0; i < files.size(); i++) {
+    for (const auto& dep : dependencies[i]) {
+      const auto [it, inserted] = fileIDs.try_emplace(dep, -1);
+      if (inserted && isProjectFile(dep, cfg)) {
+        it->second = isIncluded.size();
+        isIncluded.emplace_back(false);
+      }
+      if (it->second < 0) {
+        continue;
+      }
+      covers[i].emplace_back(it->second);
+      // The first dependency of a TU is its main file
+      if (&dep != &dependencies[i].front()) {
+        isIncluded[it->second] = true;
+      }
+    }
+    std::sort(covers[i].begin(), covers[i].end());
+    covers[i].erase(std::unique(covers[i].begin(), covers[i].end()), covers[i].end());
+  }
+
+  // TUs that couldn't be scanned are always selected since it's not known what they include
+  std::vector<bool> selected(files.size(), false);
+  std::vector<bool> covered(isIncluded.size(), false);
+  for (size_t i = 0; i < files.size(); i++) {
+    if (!scanned[i]) {
+      selected[i] = true;
+    }
+  }
+
+  // Main files that aren't included by any other TU can only be covered by their own TU. Selecting every such TU
+  // would select every TU, so only files that are #included somewhere need to be covered.
+  auto gain = [&](const size_t i) {
+    return std::count_if(
+        covers[i].begin(), covers[i].end(), [&](const uint32_t f) { return isIncluded[f] && !covered[f]; });
+  };
+
+  // Greedy set cover. The gain of a TU can only decrease as files are covered, so a TU's gain is only recomputed
+  // when it reaches the top of the queue (lazy greedy), and it's selected if it's still the best after that.
+  using Candidate = std::pair<int64_t, int64_t>; ///< (gain, -index), so ties go to the TU that comes first
+  std::priority_queue<Candidate> queue;
+  for (size_t i = 0; i < files.size(); i++) {
+    if (!selected[i]) {
+      queue.emplace(gain(i), -static_cast<int64_t>(i));
+    }
+  }
+  while (!queue.empty()) {
+    const auto [oldGain, negIndex] = queue.top();
+    const size_t i                 = -negIndex;
+    queue.pop();
+    if (oldGain == 0) {
+      break;
+    }
+
+    const int64_t newGain = gain(i);
+    if (!queue.empty() && newGain < queue.top().first) {
+      queue.emplace(newGain, negIndex);
+      continue;
+    }
+    if (newGain == 0) {
+      continue;
+    }
+    selected[i] = true;
+    for (const uint32_t f : covers[i]) {
+      covered[f] = true;
+    }
+  }
+
+  std::vector<std::string> result;
+  for (size_t i = 0; i < files.size(); i++) {
+    if (selected[i]) {
+      result.emplace_back(files[i]);
+    }
+  }
+
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  spdlog::info("Scanned the dependencies of {} TUs in {:.1f}s, {} TUs cover all {} included project files.",
+               files.size(),
+               elapsed,
+               result.size(),
+               std::count(isIncluded.begin(), isIncluded.end(), true));
+  return result;
+}
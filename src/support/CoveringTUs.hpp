@@ -0,0 +1,29 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "types/Config.hpp"
+
+namespace hdoc::indexer {
+/// @brief Select a small set of TUs that together include every project file that any TU includes.
+///
+/// Every TU in files is run through clang's dependency scanner, which only preprocesses a minimized version of each
+/// file and is much cheaper than a full parse, to find the files it includes. A greedy set cover then repeatedly
+/// picks the TU that includes the most project files (files under rootDir that aren't ignored) that aren't
+/// included by an already selected TU. Indexing only the selected TUs indexes every project header, but symbols
+/// that are only declared in the main file of a TU that wasn't selected are not indexed.
+/// TUs that can't be scanned are always selected. The selected TUs are returned in the order they appear in files.
+std::vector<std::string> selectCoveringTUs(const clang::tooling::CompilationDatabase& cmpdb,
+                                           const std::vector<std::string>&            files,
+                                           const clang::tooling::ArgumentsAdjuster&   adjuster,
+                                           const hdoc::types::Config*                 cfg,
+                                           llvm::ThreadPool&                          pool);
+} // namespace hdoc::indexer
@@ -0,0 +1,179 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/HeaderCompilationDatabase.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include <algorithm>
+#include <fstream>
+
+/// @brief Returns true if path has the extension of a C or C++ header
+static bool isHeader(const std::filesystem::path& path) {
+  const std::string ext = path.extension().string();
+  return ext == ".h" || ext == ".hh" || ext == ".hpp" || ext == ".hxx" || ext == ".h++";
+}
+
+/// @brief Find every header under rootDir, grouped by the directory it is in
+static std::map<std::filesystem::path, std::vector<std::string>> findHeaders(const hdoc::types::Config* cfg) {
+  // The build directory usually holds copies of third-party headers, and the cache directory holds hdoc's own files
+  const std::filesystem::path buildDir = (cfg->rootDir / cfg->compileCommandsJSON).parent_path();
+  const std::filesystem::path cacheDir = cfg->cacheDir;
+
+  std::map<std::filesystem::path, std::vector<std::string>> headers;
+  std::error_code                                           ec;
+  auto it = std::filesystem::recursive_directory_iterator(
+      cfg->rootDir, std::filesystem::directory_options::skip_permission_denied, ec);
+  for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+    const std::filesystem::path& path = it->path();
+    if (it->is_directory(ec)) {
+      const bool isHidden = path.filename().string().front() == '.';
+      if (isHidden || (path == buildDir && buildDir != cfg->rootDir) || path == cacheDir) {
+        it.disable_recursion_pending();
+      }
+      continue;
+    }
+    if (!it->is_regular_file(ec) || !isHeader(path)) {
+      continue;
+    }
+
+    // Headers are ignored in the same way as the matchers ignore decls, so that no header is parsed for nothing
+    if (!cfg->ignorePaths.matches(std::filesystem::relative(path, cfg->rootDir).string())) {
+      headers[path.parent_path()].emplace_back(path.string());
+    }
+  }
+  if (ec) {
+    spdlog::warn("Error while searching for headers in {} ({}).", cfg->rootDir.string(), ec.message());
+  }
+
+  // Sort the headers so that the synthetic TUs are identical from one run to the next
+  for (auto& [dir, files] : headers) {
+    std::sort(files.begin(), files.end());
+  }
+  return headers;
+}
+
+hdoc::indexer::HeaderCompilationDatabase::HeaderCompilationDatabase(
+    std::unique_ptr<clang::tooling::CompilationDatabase> cmpdb, const hdoc::types::Config* cfg)
+    : isTemporary(cfg->cacheDir.empty()) {
+  if (this->isTemporary) {
+    llvm::SmallString<128> prefix;
+    llvm::SmallString<128> tmpDir;
+    llvm::sys::path::system_temp_directory(/*erasedOnReboot=*/true, prefix);
+    llvm::sys::path::append(prefix, "hdoc-headers");
+    if (const auto ec = llvm::sys::fs::createUniqueDirectory(prefix, tmpDir)) {
+      spdlog::error("Unable to create a directory for header TUs ({}).", ec.message());
+      return;
+    }
+    this->dir = tmpDir.str().str();
+  } else {
+    this->dir = cfg->cacheDir / "header-tus";
+    std::error_code ec;
+    std::filesystem::create_directories(this->dir, ec);
+    if (ec) {
+      spdlog::error("Unable to create a directory for header TUs in {} ({}).", this->dir.string(), ec.message());
+      return;
+    }
+  }
+
+  // Headers are matched to the most similar source file in the compilation database to get their flags
+  const std::unique_ptr<clang::tooling::CompilationDatabase> inferred =
+      clang::tooling::inferMissingCompileCommands(std::move(cmpdb));
+
+  uint32_t numHeaders = 0;
+  for (const auto& [headerDir, headers] : findHeaders(cfg)) {
+    for (size_t begin = 0; begin < headers.size(); begin += cfg->headersPerTU) {
+      const size_t                   end = std::min<size_t>(begin + cfg->headersPerTU, headers.size());
+      const std::vector<std::string> group(headers.begin() + begin, headers.begin() + end);
+
+      std::vector<clang::tooling::CompileCommand> cmds = inferred->getCompileCommands(group.front());
+      if (cmds.empty()) {
+        spdlog::warn("Unable to find compile flags for {}, it will not be indexed.", group.front());
+        continue;
+      }
+      clang::tooling::CompileCommand cmd = std::move(cmds.front());
+
+      // Headers named .h get an explicit language (-x c-header or -x c++-header) from the source file they were
+      // matched to. The synthetic TU is a source file, so the language is conveyed by its extension instead.
+      std::vector<std::string> commandLine;
+      std::string              language = "c++";
+      for (size_t i = 0; i < cmd.CommandLine.size(); i++) {
+        if (cmd.CommandLine[i] == "-x" && i + 1 < cmd.CommandLine.size()) {
+          language = cmd.CommandLine[++i];
+          continue;
+        }
+        commandLine.emplace_back(cmd.CommandLine[i]);
+      }
+      const bool isC = language == "c" || language == "c-header";
+
+      std::string contents = "// Generated by hdoc to index the headers in " + headerDir.string() + "\n";
+      for (const auto& header : group) {
+        contents += "#include \"" + header + "\"\n";
+      }
+
+      // Synthetic TUs are named after their contents so that their index cache shards can be reused between runs
+      const std::string tuPath =
+          (this->dir / (llvm::utohexstr(llvm::xxHash64(contents)) + (isC ? ".c" : ".cpp"))).string();
+      std::ofstream(tuPath) << contents;
+
+      for (auto& arg : commandLine) {
+        if (arg == cmd.Filename) {
+          arg = tuPath;
+        }
+      }
+      cmd.CommandLine = std::move(commandLine);
+      cmd.Filename    = tuPath;
+      cmd.Heuristic   = "hdoc header TU, " + cmd.Heuristic;
+      this->commands.emplace(tuPath, std::move(cmd));
+      numHeaders += group.size();
+    }
+  }
+  spdlog::info("Indexing {} headers in {} synthetic TUs.", numHeaders, this->commands.size());
+
+  // Remove synthetic TUs from previous runs that are no longer needed, since headers were added or removed
+  if (!this->isTemporary) {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(this->dir, ec)) {
+      if (this->commands.count(entry.path().string()) == 0) {
+        std::filesystem::remove(entry.path(), ec);
+      }
+    }
+  }
+}
+
+hdoc::indexer::HeaderCompilationDatabase::~HeaderCompilationDatabase() {
+  if (this->isTemporary && !this->dir.empty()) {
+    std::error_code ec;
+    std::filesystem::remove_all(this->dir, ec);
+  }
+}
+
+std::vector<clang::tooling::CompileCommand>
+hdoc::indexer::HeaderCompilationDatabase::getCompileCommands(llvm::StringRef file) const {
+  if (const auto it = this->commands.find(file.str()); it != this->commands.end()) {
+    return {it->second};
+  }
+  return {};
+}
+
+std::vector<std::string> hdoc::indexer::HeaderCompilationDatabase::getAllFiles() const {
+  std::vector<std::string> files;
+  files.reserve(this->commands.size());
+  for (const auto& [file, cmd] : this->commands) {
+    files.emplace_back(file);
+  }
+  return files;
+}
+
+std::vector<clang::tooling::CompileCommand> hdoc::indexer::HeaderCompilationDatabase::getAllCompileCommands() const {
+  std::vector<clang::tooling::CompileCommand> cmds;
+  cmds.reserve(this->commands.size());
+  for (const auto& [file, cmd] : this->commands) {
+    cmds.emplace_back(cmd);
+  }
+  return cmds;
+}
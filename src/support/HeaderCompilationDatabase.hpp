@@ -0,0 +1,43 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "types/Config.hpp"
+
+namespace hdoc::indexer {
+/// @brief A compilation database of synthetic TUs that #include the project's headers.
+///
+/// Documentation only comes from declarations, which for most libraries live in headers, so parsing every source
+/// file mostly re-parses the same headers over and over. Instead, the headers under rootDir (minus ignorePaths)
+/// are grouped by directory and each group is #included by a small synthetic source file. The flags of each
+/// synthetic TU are borrowed from the compile command that clang infers for the first header in its group, which
+/// comes from the most similar source file in the original compilation database.
+class HeaderCompilationDatabase : public clang::tooling::CompilationDatabase {
+public:
+  /// Synthetic TUs are written to the cache directory if there is one, so that their cache shards stay valid
+  /// between runs, or to a temporary directory otherwise.
+  HeaderCompilationDatabase(std::unique_ptr<clang::tooling::CompilationDatabase> cmpdb,
+                            const hdoc::types::Config*                           cfg);
+
+  /// Removes the synthetic TUs if they were written to a temporary directory.
+  ~HeaderCompilationDatabase() override;
+
+  std::vector<clang::tooling::CompileCommand> getCompileCommands(llvm::StringRef file) const override;
+  std::vector<std::string>                    getAllFiles() const override;
+  std::vector<clang::tooling::CompileCommand> getAllCompileCommands() const override;
+
+private:
+  std::filesystem::path                                 dir;         ///< Where synthetic TUs are written
+  bool                                                  isTemporary; ///< Should dir be removed when done?
+  std::map<std::string, clang::tooling::CompileCommand> commands;    ///< Compile command of each synthetic TU
+};
+} // namespace hdoc::indexer
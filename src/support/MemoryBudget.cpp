@@ -0,0 +1,185 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/MemoryBudget.hpp"
+#include "support/Metrics.hpp"
+#include "support/Trace.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+hdoc::indexer::MemoryBudget::MemoryBudget(const uint64_t               budget,
+                                          const std::filesystem::path& dir,
+                                          const uint32_t               numThreads)
+    : residentMemory(hdoc::utils::currentRSS), budget(budget), numThreads(std::max(numThreads, 1U)), baseline(0) {
+  if (!this->enabled() || dir.empty()) {
+    return;
+  }
+  this->path = dir / "tu-memory";
+
+  // Each line of the file is the memory used by a TU in bytes, followed by a tab and the path of the TU
+  auto buf = llvm::MemoryBuffer::getFile(this->path.string());
+  if (!buf) {
+    return;
+  }
+  llvm::SmallVector<llvm::StringRef> lines;
+  buf.get()->getBuffer().split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (const llvm::StringRef line : lines) {
+    const auto [bytes, file] = line.split('\t');
+    uint64_t used            = 0;
+    if (file.empty() || bytes.getAsInteger(10, used)) {
+      continue;
+    }
+    this->previousUsage.emplace(file.str(), used);
+  }
+}
+
+void hdoc::indexer::MemoryBudget::estimate(const std::vector<std::string>& files) {
+  if (!this->enabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->baseline = this->residentMemory();
+  for (const auto& file : files) {
+    uint64_t size = 0;
+    llvm::sys::fs::file_size(file, size);
+    this->sizes[file] = size;
+    if (const auto it = this->previousUsage.find(file); it != this->previousUsage.end()) {
+      this->knownUsage += it->second;
+      this->knownSize += size;
+    }
+  }
+  spdlog::info("Parsing TUs within a memory budget of {} MB, {} MB are already in use.",
+               this->budget / 1'000'000,
+               this->baseline / 1'000'000);
+}
+
+uint64_t hdoc::indexer::MemoryBudget::estimateLocked(const std::string& file) const {
+  if (const auto it = this->previousUsage.find(file); it != this->previousUsage.end()) {
+    return it->second;
+  }
+
+  // TUs that weren't parsed on the previous run are estimated from the size of their main file, scaled by how much
+  // memory each byte of the TUs with a known usage took. Until any usage is known, each TU gets an equal share.
+  const auto it = this->sizes.find(file);
+  if (it == this->sizes.end() || this->knownSize == 0) {
+    return this->budget / this->numThreads;
+  }
+  return static_cast<uint64_t>(static_cast<double>(this->knownUsage) / this->knownSize * it->second);
+}
+
+uint64_t hdoc::indexer::MemoryBudget::admit(const std::string& file) {
+  if (!this->enabled()) {
+    return 0;
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  const uint64_t               expected = this->estimateLocked(file);
+
+  // Resident memory includes the TUs that are being parsed so far, while the reservations include how much they're
+  // expected to use by the time they finish, so the larger of the two is used
+  auto fits = [&] {
+    const uint64_t projected = std::max(this->residentMemory(), this->baseline + this->reserved) + expected;
+    return this->numRunning == 0 || projected <= this->budget;
+  };
+
+  if (!fits()) {
+    hdoc::utils::TraceScope trace("Wait for memory", file);
+    const auto              start = std::chrono::steady_clock::now();
+    this->numDelayed++;
+    this->numWaiting++;
+    // Resident memory can also go down without any TU finishing, so it's checked periodically as well
+    while (!fits()) {
+      this->released.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    this->numWaiting--;
+    this->waitTime += std::chrono::steady_clock::now() - start;
+  }
+
+  this->reserved += expected;
+  this->numRunning++;
+  this->maxRunning = std::max(this->maxRunning, this->numRunning);
+  return expected;
+}
+
+void hdoc::indexer::MemoryBudget::release(const std::string& file, const uint64_t reserved, const uint64_t used) {
+  if (!this->enabled()) {
+    return;
+  }
+
+  bool waiting = false;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->reserved -= reserved;
+    this->numRunning--;
+    // Only TUs that weren't parsed before improve the estimates of other TUs, since the rest are already counted
+    if (used > 0 && this->usage.emplace(file, used).second && this->previousUsage.count(file) == 0) {
+      this->knownUsage += used;
+      this->knownSize += this->sizes[file];
+    }
+    waiting = this->numWaiting > 0;
+  }
+
+#if defined(__GLIBC__)
+  // Memory freed by a TU stays resident in the allocator's arenas, which would hold back TUs that are waiting
+  if (waiting) {
+    malloc_trim(0);
+  }
+#endif
+  this->released.notify_all();
+}
+
+void hdoc::indexer::MemoryBudget::finish(const std::vector<std::string>& files) {
+  if (!this->enabled()) {
+    return;
+  }
+
+  spdlog::info("Parsed up to {} TUs at once within the memory budget, {} TUs waited {:.1f}s in total for memory.",
+               this->maxRunning,
+               this->numDelayed,
+               std::chrono::duration<double>(this->waitTime).count());
+  if (this->path.empty()) {
+    return;
+  }
+
+  // Keep the usage of TUs that weren't parsed during this run (i.e. were loaded from the index cache), but forget
+  // about TUs that are no longer in the compilation database
+  std::string out;
+  for (const auto& file : files) {
+    auto it = this->usage.find(file);
+    if (it == this->usage.end()) {
+      it = this->previousUsage.find(file);
+      if (it == this->previousUsage.end()) {
+        continue;
+      }
+    }
+    out += std::to_string(it->second) + '\t' + file + '\n';
+  }
+
+  // Write to a temporary file and move it into place so that an interrupted run never leaves a partial file behind
+  int                    fd;
+  llvm::SmallString<256> tmpPath;
+  if (const auto ec = llvm::sys::fs::createUniqueFile(this->path.string() + "-%%%%%%%%.tmp", fd, tmpPath)) {
+    spdlog::warn("Unable to save TU memory usage ({}).", ec.message());
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << out;
+  }
+  if (const auto ec = llvm::sys::fs::rename(tmpPath, this->path.string())) {
+    spdlog::warn("Unable to save TU memory usage ({}).", ec.message());
+    llvm::sys::fs::remove(tmpPath);
+  }
+}
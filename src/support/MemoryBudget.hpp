@@ -0,0 +1,74 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hdoc::indexer {
+/// @brief Limits how many TUs are parsed at once so that hdoc's memory usage stays under a budget.
+///
+/// Most TUs are small, but large template-heavy TUs can take several gigabytes each, so the number of threads alone
+/// either wastes cores on small TUs or runs out of memory on large ones. Before a TU is parsed, its peak memory is
+/// estimated from what it used on the previous run, or from the size of its main file if it wasn't parsed before.
+/// The TU is only started if the projected memory usage, which is the larger of the current resident memory and
+/// the estimates of the TUs that are being parsed, plus the estimate of the TU, stays under the budget. A TU is
+/// always started if no other TU is being parsed, so that every TU is eventually parsed.
+class MemoryBudget {
+public:
+  /// Loads the memory used by each TU during the previous run from dir, if dir isn't empty.
+  /// A budget of 0 bytes disables admission control.
+  MemoryBudget(const uint64_t budget, const std::filesystem::path& dir, const uint32_t numThreads);
+
+  /// @brief Check if TUs are being held back to stay under the budget
+  bool enabled() const {
+    return this->budget > 0;
+  }
+
+  /// @brief Estimate the peak memory of files. Must be called before any of them are admitted.
+  void estimate(const std::vector<std::string>& files);
+
+  /// @brief Wait until file can be parsed without exceeding the budget, then reserve its estimated memory.
+  /// Returns the number of bytes reserved, which must be passed to release() when the TU is finished.
+  uint64_t admit(const std::string& file);
+
+  /// @brief Release the memory reserved for a TU and record how much it used, if known. Thread-safe.
+  void release(const std::string& file, const uint64_t reserved, const uint64_t used);
+
+  /// @brief Save the recorded memory usage for the next run, and log how often TUs had to wait for memory
+  void finish(const std::vector<std::string>& files);
+
+  /// @brief Get the resident memory of hdoc, in bytes. Can be replaced to make admission deterministic in tests.
+  std::function<uint64_t()> residentMemory;
+
+private:
+  /// @brief Estimate the peak memory of file. mutex must be held.
+  uint64_t estimateLocked(const std::string& file) const;
+
+  uint64_t              budget;     ///< Bytes that hdoc may use (0 == unlimited)
+  uint32_t              numThreads; ///< Number of threads parsing TUs
+  uint64_t              baseline;   ///< Resident memory before any TU was parsed
+  std::filesystem::path path;       ///< Where memory usage is persisted (empty == off)
+
+  std::mutex                                mutex;           ///< Guards everything below
+  std::condition_variable                   released;        ///< Notified whenever a TU finishes
+  std::unordered_map<std::string, uint64_t> previousUsage;   ///< Memory used by each TU on the previous run
+  std::unordered_map<std::string, uint64_t> usage;           ///< Memory used by each TU during this run
+  std::unordered_map<std::string, uint64_t> sizes;           ///< Size of the main file of each TU
+  uint64_t                                  knownUsage = 0;  ///< Total memory used by TUs with a known usage
+  uint64_t                                  knownSize  = 0;  ///< Total size of the main files of those TUs
+  uint64_t                                  reserved   = 0;  ///< Total memory reserved by the TUs being parsed
+  uint32_t                                  numRunning = 0;  ///< Number of TUs being parsed
+  uint32_t                                  maxRunning = 0;  ///< Most TUs that were parsed at once
+  uint32_t                                  numWaiting = 0;  ///< Number of TUs waiting for memory
+  uint32_t                                  numDelayed = 0;  ///< Number of TUs that had to wait for memory
+  std::chrono::steady_clock::duration       waitTime   = {}; ///< Total time that TUs waited for memory
+};
+} // namespace hdoc::indexer
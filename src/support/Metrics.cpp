@@ -0,0 +1,199 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/Metrics.hpp"
+#include "types/StringPool.hpp"
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+uint64_t hdoc::utils::currentRSS() {
+  // The second field of statm is the number of resident pages
+  std::ifstream statm("/proc/self/statm");
+  uint64_t      size = 0, resident = 0;
+  if (!(statm >> size >> resident)) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+double hdoc::utils::processCPUTime() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  const auto toMs = [](const timeval& t) { return t.tv_sec * 1000.0 + t.tv_usec / 1000.0; };
+  return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+}
+
+hdoc::utils::Metrics::~Metrics() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopped = true;
+  }
+  this->stopSampling.notify_all();
+  if (this->sampler.joinable()) {
+    this->sampler.join();
+  }
+}
+
+void hdoc::utils::Metrics::enable() {
+  if (this->enabled.exchange(true)) {
+    return;
+  }
+  this->peakRSS = currentRSS();
+  this->sampler = std::thread([this]() { this->sample(); });
+}
+
+void hdoc::utils::Metrics::sample() {
+  // Phases last for at least hundreds of milliseconds on any real project, so this is frequent enough to catch
+  // the peak of each phase without costing anything noticeable
+  constexpr auto               interval = std::chrono::milliseconds(10);
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (!this->stopSampling.wait_for(lock, interval, [this]() { return this->stopped; })) {
+    // Reading /proc is slow compared to everything else that takes the mutex
+    lock.unlock();
+    const uint64_t rss  = currentRSS();
+    uint64_t       peak = this->peakRSS.load(std::memory_order_relaxed);
+    while (rss > peak && !this->peakRSS.compare_exchange_weak(peak, rss, std::memory_order_relaxed)) {
+    }
+    lock.lock();
+  }
+}
+
+void hdoc::utils::Metrics::startPhase(const llvm::StringRef name) {
+  if (!this->isEnabled()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->endPhaseLocked();
+  this->inPhase           = true;
+  this->current           = Phase{name.str()};
+  this->phaseStart        = Clock::now();
+  this->phaseStartCPUTime = processCPUTime();
+  this->peakRSS           = currentRSS();
+}
+
+void hdoc::utils::Metrics::endPhase() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->endPhaseLocked();
+}
+
+void hdoc::utils::Metrics::endPhaseLocked() {
+  if (!this->inPhase) {
+    return;
+  }
+  this->current.wallTime = std::chrono::duration<double, std::milli>(Clock::now() - this->phaseStart).count();
+  this->current.cpuTime  = processCPUTime() - this->phaseStartCPUTime;
+  this->current.peakRSS  = std::max(this->peakRSS.load(), currentRSS());
+  this->phases.emplace_back(std::move(this->current));
+  this->inPhase = false;
+}
+
+void hdoc::utils::Metrics::recordDatabase(const llvm::StringRef name, const hdoc::types::MemoryUsage& usage) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->databases.emplace_back(name.str(), usage);
+}
+
+void hdoc::utils::Metrics::recordSpilledDatabase(const llvm::StringRef name, const uint64_t numBytes) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->spilledDatabases.emplace_back(name.str(), numBytes);
+}
+
+void hdoc::utils::Metrics::recordCache(const llvm::StringRef name, const uint64_t hits, const uint64_t misses) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->caches.push_back({name.str(), hits, misses});
+}
+
+bool hdoc::utils::Metrics::write(const std::filesystem::path& path) {
+  std::error_code      ec;
+  llvm::raw_fd_ostream out(path.string(), ec);
+  if (ec) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->endPhaseLocked();
+
+  uint64_t            peakRSS = 0;
+  llvm::json::OStream json(out, 2);
+  json.object([&] {
+    json.attributeArray("phases", [&] {
+      for (const auto& phase : this->phases) {
+        peakRSS = std::max(peakRSS, phase.peakRSS);
+        json.object([&] {
+          json.attribute("name", phase.name);
+          json.attribute("wallTimeMs", phase.wallTime);
+          json.attribute("cpuTimeMs", phase.cpuTime);
+          json.attribute("peakRSSBytes", static_cast<int64_t>(phase.peakRSS));
+        });
+      }
+    });
+    json.attribute("peakRSSBytes", static_cast<int64_t>(peakRSS));
+
+    json.attributeObject("databases", [&] {
+      for (const auto& [name, usage] : this->databases) {
+        json.attributeObject(name, [&] {
+          json.attribute("stringBytes", static_cast<int64_t>(usage.strings));
+          json.attribute("vectorBytes", static_cast<int64_t>(usage.vectors));
+          json.attribute("mapBytes", static_cast<int64_t>(usage.maps));
+          json.attribute("totalBytes", static_cast<int64_t>(usage.total()));
+        });
+      }
+      // Spilled Databases aren't in memory, so only their size on disk is known
+      for (const auto& [name, numBytes] : this->spilledDatabases) {
+        json.attributeObject(name, [&] {
+          json.attribute("spilled", true);
+          json.attribute("diskBytes", static_cast<int64_t>(numBytes));
+        });
+      }
+    });
+
+    json.attributeObject("caches", [&] {
+      for (const auto& cache : this->caches) {
+        const uint64_t lookups = cache.hits + cache.misses;
+        json.attributeObject(cache.name, [&] {
+          json.attribute("hits", static_cast<int64_t>(cache.hits));
+          json.attribute("misses", static_cast<int64_t>(cache.misses));
+          json.attribute("hitRate", lookups == 0 ? 0.0 : static_cast<double>(cache.hits) / lookups);
+        });
+      }
+    });
+
+    const auto& pool = hdoc::types::StringPool::global();
+    json.attributeObject("stringPool", [&] {
+      json.attribute("numInterned", static_cast<int64_t>(pool.numInterned.load()));
+      json.attribute("numUnique", static_cast<int64_t>(pool.numUnique.load()));
+      json.attribute("uniqueBytes", static_cast<int64_t>(pool.bytesUnique.load()));
+      json.attribute("savedBytes", static_cast<int64_t>(pool.bytesSaved()));
+    });
+
+    json.attributeObject("tus", [&] {
+      json.attribute("parsed", static_cast<int64_t>(this->numTUsParsed.load()));
+      json.attribute("failed", static_cast<int64_t>(this->numTUsFailed.load()));
+      json.attribute("fromCache", static_cast<int64_t>(this->numTUsFromCache.load()));
+    });
+
+    json.attributeObject("spill", [&] {
+      json.attribute("runs", static_cast<int64_t>(this->numRunsSpilled.load()));
+      json.attribute("bytes", static_cast<int64_t>(this->numBytesSpilled.load()));
+    });
+
+    json.attributeObject("output", [&] {
+      json.attribute("htmlPages", static_cast<int64_t>(this->numPagesWritten.load()));
+      json.attribute("htmlBytes", static_cast<int64_t>(this->numHTMLBytesWritten.load()));
+      json.attribute("jsonPayloadBytes", static_cast<int64_t>(this->jsonPayloadSize.load()));
+    });
+  });
+  out << "\n";
+  out.flush();
+
+  // raw_fd_ostream aborts on destruction if an error wasn't cleared
+  const bool success = !out.has_error();
+  out.clear_error();
+  return success;
+}
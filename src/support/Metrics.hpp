@@ -0,0 +1,127 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "types/MemoryUsage.hpp"
+
+namespace hdoc::utils {
+/// @brief Collects metrics about a run of hdoc and writes them as a JSON report, so that regressions in speed or
+/// memory usage can be tracked over time.
+///
+/// The run is split into sequential phases, i.e. indexing or writing HTML. Wall-clock time, CPU time of the whole
+/// process, and peak resident memory are recorded for each phase. Resident memory is sampled by a background thread
+/// while metrics are enabled. Counters are always updated, since they're cheap, but only written if enabled.
+class Metrics {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// @brief The Metrics of this run of hdoc
+  static Metrics& global() {
+    static Metrics metrics;
+    return metrics;
+  }
+
+  Metrics() = default;
+  ~Metrics();
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  /// @brief Start sampling resident memory. Phases are only recorded once metrics are enabled.
+  void enable();
+
+  /// @brief Check if metrics are being recorded
+  bool isEnabled() const {
+    return this->enabled.load(std::memory_order_relaxed);
+  }
+
+  /// @brief End the current phase, if any, and start a new one
+  void startPhase(const llvm::StringRef name);
+
+  /// @brief End the current phase, if any
+  void endPhase();
+
+  /// @brief Record the memory used by one of the Databases of the Index
+  void recordDatabase(const llvm::StringRef name, const hdoc::types::MemoryUsage& usage);
+
+  /// @brief Record the size on disk of one of the Databases of an Index that was spilled to disk
+  void recordSpilledDatabase(const llvm::StringRef name, const uint64_t numBytes);
+
+  /// @brief Record how many lookups into one of hdoc's caches were hits and misses
+  void recordCache(const llvm::StringRef name, const uint64_t hits, const uint64_t misses);
+
+  /// @brief Record that a page of HTML documentation was written
+  void recordPage(const uint64_t numBytes) {
+    this->numPagesWritten.fetch_add(1, std::memory_order_relaxed);
+    this->numHTMLBytesWritten.fetch_add(numBytes, std::memory_order_relaxed);
+  }
+
+  /// @brief Write all of the metrics to path, ending the current phase first.
+  /// Returns false if the file couldn't be written.
+  bool write(const std::filesystem::path& path);
+
+  std::atomic<uint64_t> numTUsParsed        = 0; ///< TUs that were parsed successfully
+  std::atomic<uint64_t> numTUsFailed        = 0; ///< TUs that clang failed to parse
+  std::atomic<uint64_t> numTUsFromCache     = 0; ///< TUs that were loaded from the index cache instead of parsed
+  std::atomic<uint64_t> numPagesWritten     = 0; ///< HTML pages written
+  std::atomic<uint64_t> numHTMLBytesWritten = 0; ///< Total size of the HTML pages written
+  std::atomic<uint64_t> jsonPayloadSize     = 0; ///< Size of the serialized JSON payload, if one was built
+  std::atomic<uint64_t> numRunsSpilled      = 0; ///< Runs of symbols that were spilled to disk while indexing
+  std::atomic<uint64_t> numBytesSpilled     = 0; ///< Total size of the runs spilled to disk
+
+private:
+  struct Phase {
+    std::string name;
+    double      wallTime = 0; ///< In milliseconds
+    double      cpuTime  = 0; ///< User and system time of all threads, in milliseconds
+    uint64_t    peakRSS  = 0; ///< Highest resident memory that was sampled during the phase, in bytes
+  };
+
+  struct Cache {
+    std::string name;
+    uint64_t    hits   = 0;
+    uint64_t    misses = 0;
+  };
+
+  /// @brief Sample resident memory until stopped
+  void sample();
+
+  /// @brief End the current phase. mutex must be held.
+  void endPhaseLocked();
+
+  std::atomic<bool>       enabled = false;
+  std::atomic<uint64_t>   peakRSS = 0; ///< Highest resident memory sampled since the current phase started
+  std::mutex              mutex;       ///< Protects everything below
+  std::condition_variable stopSampling;
+  bool                    stopped = false;
+  std::thread             sampler;
+
+  std::vector<Phase> phases;
+  bool               inPhase = false;
+  Phase              current;
+  Clock::time_point  phaseStart;
+  double             phaseStartCPUTime = 0;
+
+  std::vector<std::pair<std::string, hdoc::types::MemoryUsage>> databases;        ///< Memory used by each Database
+  std::vector<std::pair<std::string, uint64_t>>                 spilledDatabases; ///< Size on disk of spilled Databases
+  std::vector<Cache>                                            caches;           ///< Hits and misses of each cache
+};
+
+/// @brief Get the current resident memory of hdoc, in bytes, or 0 if it can't be determined
+uint64_t currentRSS();
+
+/// @brief Get the user and system CPU time used by all of hdoc's threads so far, in milliseconds
+double processCPUTime();
+} // namespace hdoc::utils
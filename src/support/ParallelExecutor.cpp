@@ -2,11 +2,220 @@
 // SPDX-License-Identifier: AGPL-3.0-only
 
 #include "support/ParallelExecutor.hpp"
+#include "indexer/IndexAction.hpp"
+#include "support/CachingFileSystem.hpp"
+#include "support/CostReport.hpp"
+#include "support/CoveringTUs.hpp"
+#include "support/MemoryBudget.hpp"
+#include "support/Metrics.hpp"
+#include "support/SharedPCH.hpp"
+#include "support/TUScheduler.hpp"
+#include "support/Trace.hpp"
 #include "spdlog/spdlog.h"
 
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/VirtualFileSystem.h"
 
-void hdoc::indexer::ParallelExecutor::execute(std::unique_ptr<clang::tooling::FrontendActionFactory> action) {
+#include <list>
+#include <thread>
+
+namespace {
+/// @brief Gives each thread its own Index to write to, so that threads never contend on a shared Index
+class ThreadIndexes {
+public:
+  /// @brief Get the Index of the calling thread
+  hdoc::types::Index& get() {
+    // Only taken once per TU to find the thread's Index, never while symbols are being indexed
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto&                       index = this->indexes[std::this_thread::get_id()];
+    if (index == nullptr) {
+      index = std::make_unique<hdoc::types::Index>();
+    }
+    return *index;
+  }
+
+  /// @brief Get the Indexes of every thread that called get()
+  std::vector<hdoc::types::Index*> all() {
+    std::vector<hdoc::types::Index*> result;
+    for (auto& [id, index] : this->indexes) {
+      result.emplace_back(index.get());
+    }
+    return result;
+  }
+
+private:
+  std::mutex                                                               mutex;
+  std::unordered_map<std::thread::id, std::unique_ptr<hdoc::types::Index>> indexes;
+};
+
+/// @brief Merges the shard of each TU into one Index in compile database order when caching.
+/// The first copy of a symbol is the one that's kept, so merging shards as threads finish them would make the Index
+/// depend on which thread was fastest. Shards that finish early wait until every shard before them is merged.
+class OrderedShards {
+public:
+  explicit OrderedShards(const size_t numShards) : pending(numShards) {}
+
+  /// @brief Add the shard of the TU at position i in the compile database, and merge every shard that's now next
+  /// in line. spillIfNeeded is called with the merged Index after each merge.
+  template <typename Spill> void add(const size_t i, hdoc::types::Index&& shard, Spill&& spillIfNeeded) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending[i] = std::make_unique<hdoc::types::Index>(std::move(shard));
+    for (; this->next < this->pending.size() && this->pending[this->next] != nullptr; this->next++) {
+      this->merged.merge(*this->pending[this->next]);
+      this->pending[this->next].reset();
+      spillIfNeeded(this->merged);
+    }
+  }
+
+  hdoc::types::Index merged; ///< Shards that were merged so far, in compile database order
+
+private:
+  std::mutex                                       mutex;
+  std::vector<std::unique_ptr<hdoc::types::Index>> pending;  ///< Shards that are waiting for an earlier shard
+  size_t                                           next = 0; ///< Position of the next shard to be merged
+};
+
+/// @brief Keeps the FileManagers of each thread alive between TUs, so that the files and directories that were
+/// looked up while parsing a TU are still cached when the same thread parses its next TU.
+///
+/// FileManager caches files by the path they were requested with, and relative paths depend on the working directory
+/// of the compile command, so TUs only share a FileManager if they're compiled in the same directory. Each thread
+/// keeps the FileManagers of the few directories it used most recently. The files and directories that any thread
+/// looked up are also cached across all threads by a FileSystemCache.
+class ThreadFileManagers {
+public:
+  explicit ThreadFileManagers(std::shared_ptr<hdoc::indexer::FileSystemCache> cache) : cache(std::move(cache)) {}
+
+  /// @brief A FileManager and the VFS it reads from, whose working directory is changed by ClangTool
+  struct Files {
+    std::string                                     directory; ///< Working directory of the TUs that use these Files
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS;
+    llvm::IntrusiveRefCntPtr<clang::FileManager>    fileManager;
+  };
+
+  /// @brief Get the Files of the calling thread for TUs compiled in directory, creating them if needed
+  Files& get(const std::string& directory) {
+    std::list<Files>* recent = nullptr;
+    {
+      // Only taken once per TU to find the thread's Files, FileManagers are only used by the thread that owns them
+      std::lock_guard<std::mutex> lock(this->mutex);
+      recent = &this->files[std::this_thread::get_id()];
+    }
+
+    for (auto it = recent->begin(); it != recent->end(); ++it) {
+      if (it->directory == directory) {
+        recent->splice(recent->begin(), *recent, it);
+        this->numReused++;
+        return recent->front();
+      }
+    }
+
+    if (recent->size() >= maxDirectoriesPerThread) {
+      recent->pop_back();
+    }
+    // Each thread gets an independent copy of a VFS to allow different concurrent working directories, but they
+    // all read through the same cache
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS(
+        new hdoc::indexer::CachingFileSystem(this->cache, llvm::vfs::createPhysicalFileSystem().release()));
+    FS->setCurrentWorkingDirectory(directory);
+    llvm::IntrusiveRefCntPtr<clang::FileManager> fileManager(new clang::FileManager(clang::FileSystemOptions(), FS));
+    recent->push_front({directory, FS, fileManager});
+    this->numCreated++;
+    return recent->front();
+  }
+
+  std::atomic<uint64_t> numCreated = 0; ///< Number of FileManagers that were created
+  std::atomic<uint64_t> numReused  = 0; ///< Number of TUs that reused the FileManager of an earlier TU
+
+private:
+  static constexpr size_t maxDirectoriesPerThread = 4;
+
+  std::shared_ptr<hdoc::indexer::FileSystemCache>        cache;
+  std::mutex                                             mutex;
+  std::unordered_map<std::thread::id, std::list<Files>> files; ///< Most recently used first
+};
+} // namespace
+
+/// @brief Release the claims on every symbol in index, which was indexed with claims and is being discarded
+static void releaseSymbolClaims(hdoc::types::IndexClaims* claims, const hdoc::types::Index& index) {
+  if (claims == nullptr) {
+    return;
+  }
+  for (const auto& [id, _] : index.functions.entries) {
+    claims->functions.release(id);
+  }
+  for (const auto& [id, _] : index.records.entries) {
+    claims->records.release(id);
+  }
+  for (const auto& [id, _] : index.enums.entries) {
+    claims->enums.release(id);
+  }
+  for (const auto& [id, _] : index.namespaces.entries) {
+    claims->namespaces.release(id);
+  }
+}
+
+/// @brief Move the entries of every shard into db, keeping the first entry for each SymbolID.
+/// Each shard's entries are first scattered into buckets by the hash of their SymbolID, one task per shard. Each
+/// partition then deduplicates its bucket of every shard, in shard order, so every entry is only visited once by
+/// each phase. Entries are moved between maps as nodes, and the partitions are disjoint, so they're spliced into db
+/// without any further lookups or copies.
+template <typename T>
+static void mergeDatabases(hdoc::types::Database<T>&              db,
+                           std::vector<hdoc::types::Database<T>*> shards,
+                           llvm::ThreadPool&                      pool) {
+  using Node    = typename decltype(db.entries)::node_type;
+  using Buckets = std::vector<std::vector<Node>>;
+
+  // Entries that are already in db take precedence over the shards
+  shards.insert(shards.begin(), &db);
+
+  const size_t         numPartitions = std::max(pool.getThreadCount(), 1U);
+  std::vector<Buckets> buckets(shards.size());
+  for (size_t s = 0; s < shards.size(); s++) {
+    pool.async([&, s]() {
+      hdoc::utils::TraceScope trace("Scatter shard");
+      auto& entries = shards[s]->entries;
+      buckets[s].resize(numPartitions);
+      for (auto it = entries.begin(); it != entries.end();) {
+        const size_t p = std::hash<hdoc::types::SymbolID>()(it->first) % numPartitions;
+        buckets[s][p].emplace_back(entries.extract(it++));
+      }
+    });
+  }
+  pool.wait();
+
+  std::vector<std::unordered_map<hdoc::types::SymbolID, T>> partitions(numPartitions);
+  for (size_t p = 0; p < numPartitions; p++) {
+    // Each partition only reads its own column of buckets, so no entry is touched by two threads
+    pool.async([&, p]() {
+      hdoc::utils::TraceScope trace("Merge partition");
+      for (Buckets& shardBuckets : buckets) {
+        for (Node& node : shardBuckets[p]) {
+          // Duplicates are handed back by insert() and freed right away
+          partitions[p].insert(std::move(node));
+        }
+      }
+    });
+  }
+  pool.wait();
+
+  uint32_t numMatches = 0;
+  for (hdoc::types::Database<T>* shard : shards) {
+    numMatches += shard->numMatches;
+  }
+  db.numMatches = numMatches;
+  for (auto& partition : partitions) {
+    db.entries.merge(partition);
+  }
+}
+
+void hdoc::indexer::ParallelExecutor::execute(hdoc::types::Index&          index,
+                                              hdoc::indexer::IndexCache&   cache,
+                                              hdoc::types::IndexClaims&    symbolClaims,
+                                              hdoc::types::SymbolIDTable*  symbolIDs,
+                                              hdoc::indexer::SpilledIndex* spill) {
   std::mutex mutex;
 
   // Add a counter to track progress
@@ -19,44 +228,263 @@ void hdoc::indexer::ParallelExecutor::execute(std::unique_ptr<clang::tooling::Fr
 
   std::vector<std::string> allFilesInCmpdb = this->cmpdb.getAllFiles();
 
-  if (this->debugLimitNumIndexedFiles > 0) {
-    allFilesInCmpdb.resize(this->debugLimitNumIndexedFiles);
-    totalNumFiles = std::to_string(this->debugLimitNumIndexedFiles);
+  // Files and symbols are claimed by the first TU that reaches them so that they're only indexed once.
+  // This is disabled when caching because every TU's shard needs to contain all of the symbols the TU contributes.
+  hdoc::indexer::FileClaims  claims;
+  hdoc::indexer::FileClaims* claimsPtr       = cache.enabled() ? nullptr : &claims;
+  hdoc::types::IndexClaims*  symbolClaimsPtr = cache.enabled() ? nullptr : &symbolClaims;
+
+  // Each thread indexes into its own Index, which are all merged into index at the end
+  ThreadIndexes threadIndexes;
+
+  // Spilling between TUs means that a thread's Index never changes while it's being written to disk
+  auto spillIfNeeded = [spill](hdoc::types::Index& threadIndex) {
+    if (spill != nullptr && spill->shouldSpill(threadIndex)) {
+      spill->spill(threadIndex);
+    }
+  };
+
+  // Files are looked up through a cache shared by all threads, which has to outlive their FileManagers
+  const auto         fsCache = std::make_shared<hdoc::indexer::FileSystemCache>();
+  ThreadFileManagers threadFiles(fsCache);
+
+  // The cost of each TU is only collected when it's going to be reported, or to learn how much memory it needs
+  hdoc::indexer::MemoryBudget budget(this->cfg->memoryBudget, this->cfg->cacheDir, this->pool.getThreadCount());
+  const bool                  reportCosts  = !this->cfg->costReportPath.empty();
+  const bool                  collectCosts = reportCosts || budget.enabled();
+  hdoc::indexer::CostReport   costReport;
+
+  if (this->cfg->debugLimitNumIndexedFiles > 0) {
+    allFilesInCmpdb.resize(this->cfg->debugLimitNumIndexedFiles);
+    totalNumFiles = std::to_string(this->cfg->debugLimitNumIndexedFiles);
+  }
+
+  // Argument adjusters so that system includes and others are picked up on
+  // TODO: determine if the -fsyntax-only flag actually does anything
+  namespace tooling = clang::tooling;
+
+  tooling::ArgumentsAdjuster adjuster = tooling::getClangStripOutputAdjuster();
+
+  adjuster = tooling::combineAdjusters(adjuster, tooling::getClangStripDependencyFileAdjuster());
+  adjuster = tooling::combineAdjusters(adjuster, tooling::getClangSyntaxOnlyAdjuster());
+  adjuster = tooling::combineAdjusters(
+      adjuster, tooling::getInsertArgumentAdjuster(this->includePaths, tooling::ArgumentInsertPosition::END));
+
+  // Only index the TUs that are needed to reach every project header
+  if (this->cfg->minimalTUs) {
+    hdoc::utils::TraceScope trace("Select covering TUs");
+    allFilesInCmpdb = hdoc::indexer::selectCoveringTUs(this->cmpdb, allFilesInCmpdb, adjuster, this->cfg, this->pool);
+    totalNumFiles   = std::to_string(allFilesInCmpdb.size());
   }
 
-  for (const std::string& file : allFilesInCmpdb) {
+  // Start the most expensive TUs first so that no thread is left parsing a huge TU on its own at the end of the run
+  hdoc::indexer::TUScheduler     scheduler(this->cfg->cacheDir);
+  const std::vector<std::string> schedule = scheduler.schedule(allFilesInCmpdb);
+
+  // When caching, the shards of TUs are merged in compile database order rather than in the order they're scheduled
+  OrderedShards           orderedShards(allFilesInCmpdb.size());
+  llvm::StringMap<size_t> positions;
+  for (size_t i = 0; i < allFilesInCmpdb.size(); i++) {
+    positions.try_emplace(allFilesInCmpdb[i], i);
+  }
+
+  // PCHs are loaded by many threads at once, so all of the tools share the same PCHContainerOperations
+  const auto                                 pchOps = std::make_shared<clang::PCHContainerOperations>();
+  std::unique_ptr<hdoc::indexer::SharedPCHs> pchs;
+  if (this->cfg->sharedPCH) {
+    hdoc::utils::TraceScope trace("Build shared PCHs");
+    pchs = std::make_unique<hdoc::indexer::SharedPCHs>(
+        this->cmpdb, allFilesInCmpdb, adjuster, pchOps, this->pool, this->cfg->skipFunctionBodies);
+  }
+
+  // Estimated after the PCHs are built, so that the memory they use is already resident
+  budget.estimate(schedule);
+
+  for (const std::string& file : schedule) {
     this->pool.async(
-        [&](const std::string path) {
+        [&](const std::string path, const size_t position) {
+          hdoc::utils::TraceScope trace("Index TU", path);
+
+          // When caching, each TU is indexed into its own shard so that the shard holds everything the TU
+          // contributes to the Index, regardless of which TU happened to index a symbol first.
+          hdoc::types::Index&      threadIndex = threadIndexes.get();
+          hdoc::types::Index       shard;
+          std::vector<std::string> dependencies;
+          uint64_t                 fingerprint = 0;
+          if (cache.enabled()) {
+            fingerprint = cache.fingerprint(this->cmpdb.getCompileCommands(path), this->includePaths);
+            if (cache.load(path, fingerprint, shard)) {
+              spdlog::info("[{}/{}] loaded {} from cache", incrementCounter(), totalNumFiles, path);
+              hdoc::utils::Metrics::global().numTUsFromCache++;
+              orderedShards.add(position, std::move(shard), spillIfNeeded);
+              return;
+            }
+          }
+
+          // Wait for enough memory to be free before the TU is started, rather than afterwards when it's too late
+          const uint64_t reserved = budget.admit(path);
           spdlog::info("[{}/{}] processing {}", incrementCounter(), totalNumFiles, path);
+          const auto start = std::chrono::steady_clock::now();
+
+          // Both attempts at parsing the TU claim files as the same TU, so the retry still owns what the first
+          // attempt claimed
+          hdoc::types::Index&   target   = cache.enabled() ? shard : threadIndex;
+          const uint32_t        claimant = claimsPtr != nullptr ? claims.newClaimant() : 0;
+          hdoc::indexer::TUCost cost;
 
-          // Each thread gets an independent copy of a VFS to allow different concurrent working directories
-          llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS = llvm::vfs::createPhysicalFileSystem().release();
-          clang::tooling::ClangTool Tool(this->cmpdb, {path}, std::make_shared<clang::PCHContainerOperations>(), FS);
-
-          // Append argument adjusters so that system includes and others are picked up on
-          // TODO: determine if the -fsyntax-only flag actually does anything
-          Tool.appendArgumentsAdjuster(clang::tooling::getClangStripOutputAdjuster());
-          Tool.appendArgumentsAdjuster(clang::tooling::getClangStripDependencyFileAdjuster());
-          Tool.appendArgumentsAdjuster(clang::tooling::getClangSyntaxOnlyAdjuster());
-          Tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
-              this->includePaths, clang::tooling::ArgumentInsertPosition::END));
-
-          // Ignore all diagnostics that clang might throw. Clang often has weird diagnostic settings that don't
-          // match what's in compile_commands.json, resulting in spurious errors. Instead of trying to change clang's
-          // behavior, we'll ignore all diagnostics and assume that the user supplied a project that builds on their
-          // machine.
-          clang::IgnoringDiagConsumer ignore;
-          Tool.setDiagnosticConsumer(&ignore);
-
-          // Run the tool and print an error message if something goes wrong
-          if (Tool.run(action.get())) {
+          // ClangTool changes the working directory of the VFS to the directory of the compile command
+          const std::vector<tooling::CompileCommand> commands = this->cmpdb.getCompileCommands(path);
+          ThreadFileManagers::Files&                 files =
+              threadFiles.get(commands.empty() ? std::string() : commands.front().Directory);
+
+          auto runTool = [&](const hdoc::indexer::SharedPCH* pch, hdoc::types::Index& into) {
+            hdoc::utils::TraceScope trace(pch != nullptr ? "Parse TU with shared PCH" : "Parse TU", path);
+
+            hdoc::indexer::IndexActionFactory factory(&into,
+                                                      this->cfg,
+                                                      claimsPtr,
+                                                      symbolClaimsPtr,
+                                                      cache.enabled() ? &dependencies : nullptr,
+                                                      symbolIDs,
+                                                      collectCosts ? &cost : nullptr,
+                                                      /*timeHeaders=*/reportCosts,
+                                                      claimant);
+
+            clang::tooling::ClangTool Tool(this->cmpdb, {path}, pchOps, files.FS, files.fileManager);
+            Tool.appendArgumentsAdjuster(adjuster);
+            if (pch != nullptr) {
+              Tool.appendArgumentsAdjuster(tooling::getInsertArgumentAdjuster(
+                  {"-include-pch", pch->path}, tooling::ArgumentInsertPosition::END));
+            }
+
+            // Ignore all diagnostics that clang might throw. Clang often has weird diagnostic settings that don't
+            // match what's in compile_commands.json, resulting in spurious errors. Instead of trying to change
+            // clang's behavior, we'll ignore all diagnostics and assume that the user supplied a project that builds
+            // on their machine.
+            clang::IgnoringDiagConsumer ignore;
+            Tool.setDiagnosticConsumer(&ignore);
+            return Tool.run(&factory) == 0;
+          };
+
+          // Run the tool and print an error message if something goes wrong.
+          // If the TU can't be parsed with its shared PCH (for example, because the PCH is incompatible with a
+          // flag that was missed while grouping TUs), it's parsed again from scratch. The attempt with the PCH is
+          // indexed on the side so that nothing from a failed attempt ends up in the Index.
+          const hdoc::indexer::SharedPCH* pch     = pchs ? pchs->get(path) : nullptr;
+          bool                            success = false;
+          if (pch != nullptr) {
+            hdoc::types::Index attempt;
+            success = runTool(pch, attempt);
+            if (success) {
+              target.merge(attempt);
+            } else {
+              spdlog::warn("Failed to parse {} with a shared PCH, retrying without it.", path);
+              releaseSymbolClaims(symbolClaimsPtr, attempt);
+              pch  = nullptr;
+              cost = hdoc::indexer::TUCost();
+              dependencies.clear();
+            }
+          }
+          if (pch == nullptr) {
+            success = runTool(nullptr, target);
+          }
+
+          const auto elapsed = std::chrono::steady_clock::now() - start;
+          scheduler.record(path, elapsed);
+          budget.release(path, reserved, cost.memory);
+          if (reportCosts) {
+            cost.path      = path;
+            cost.failed    = !success;
+            cost.totalTime = std::chrono::duration<double, std::milli>(elapsed).count();
+            costReport.add(std::move(cost));
+          }
+
+          auto& metrics = hdoc::utils::Metrics::global();
+          (success ? metrics.numTUsParsed : metrics.numTUsFailed)++;
+          if (!success) {
             spdlog::error(
                 "Clang failed to parse source file: {}. Information from this file may be missing from hdoc's output",
                 path);
+          } else if (cache.enabled()) {
+            // Files that were read while building the PCH aren't visible in the TU's SourceManager
+            if (pch != nullptr) {
+              pchs->removeTemporaryFiles(dependencies);
+              dependencies.insert(dependencies.end(), pch->dependencies.begin(), pch->dependencies.end());
+            }
+            // Only cache TUs that were parsed successfully, so that failures are retried on the next run
+            cache.store(path, fingerprint, dependencies, shard);
+          }
+
+          if (cache.enabled()) {
+            orderedShards.add(position, std::move(shard), spillIfNeeded);
+          } else {
+            spillIfNeeded(threadIndex);
           }
         },
-        file);
+        file,
+        positions.lookup(file));
   }
   // Make sure all tasks have finished before resetting the working directory
   this->pool.wait();
+  scheduler.finish(allFilesInCmpdb, schedule, this->pool.getThreadCount());
+  budget.finish(allFilesInCmpdb);
+  if (reportCosts) {
+    costReport.print(this->cfg->costReportSize);
+    if (!costReport.write(this->cfg->costReportPath, this->cfg->costReportSize)) {
+      spdlog::error("Failed to write the cost report to {}", this->cfg->costReportPath.string());
+    }
+  }
+
+  // Combine the Indexes of every thread now that nothing else is writing to them
+  hdoc::utils::TraceScope                                           trace("Merge indexes");
+  const auto                                                        start   = std::chrono::steady_clock::now();
+  std::vector<hdoc::types::Index*>                                  indexes = threadIndexes.all();
+  std::vector<hdoc::types::Database<hdoc::types::FunctionSymbol>*>  functions;
+  std::vector<hdoc::types::Database<hdoc::types::RecordSymbol>*>    records;
+  std::vector<hdoc::types::Database<hdoc::types::EnumSymbol>*>      enums;
+  std::vector<hdoc::types::Database<hdoc::types::NamespaceSymbol>*> namespaces;
+  if (cache.enabled()) {
+    indexes = {&orderedShards.merged};
+  }
+  for (hdoc::types::Index* threadIndex : indexes) {
+    functions.emplace_back(&threadIndex->functions);
+    records.emplace_back(&threadIndex->records);
+    enums.emplace_back(&threadIndex->enums);
+    namespaces.emplace_back(&threadIndex->namespaces);
+    index.numIDLookups += threadIndex->numIDLookups;
+    index.numIDCacheHits += threadIndex->numIDCacheHits;
+  }
+  mergeDatabases(index.functions, functions, this->pool);
+  mergeDatabases(index.records, records, this->pool);
+  mergeDatabases(index.enums, enums, this->pool);
+  mergeDatabases(index.namespaces, namespaces, this->pool);
+  spdlog::info("{} TUs reused the cached files and directories of an earlier TU, {} FileManagers were created.",
+               threadFiles.numReused.load(),
+               threadFiles.numCreated.load());
+  spdlog::info("File system cache: {} of {} statuses, {} of {} files, {} of {} directories were cached, {} MB read.",
+               fsCache->numStatusHits.load(),
+               fsCache->numStatusHits.load() + fsCache->numStatusMisses.load(),
+               fsCache->numBufferHits.load(),
+               fsCache->numBufferHits.load() + fsCache->numBufferMisses.load(),
+               fsCache->numDirectoryHits.load(),
+               fsCache->numDirectoryHits.load() + fsCache->numDirectoryMisses.load(),
+               fsCache->bytesCached.load() / 1'000'000);
+  hdoc::utils::Metrics& metrics = hdoc::utils::Metrics::global();
+  metrics.recordCache("fileStatuses", fsCache->numStatusHits.load(), fsCache->numStatusMisses.load());
+  metrics.recordCache("fileContents", fsCache->numBufferHits.load(), fsCache->numBufferMisses.load());
+  metrics.recordCache("directories", fsCache->numDirectoryHits.load(), fsCache->numDirectoryMisses.load());
+  spdlog::info("Merged the indexes of {} threads in {:.2f}s.",
+               indexes.size(),
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  if (spill != nullptr && spill->spilled()) {
+    spdlog::info("Spilled {} runs of symbols ({} MB) to disk while indexing.",
+                 spill->numRuns(),
+                 spill->numBytesSpilled.load() / 1'000'000);
+  }
+
+  if (claimsPtr != nullptr) {
+    spdlog::info("{} files claimed, {} duplicate visits to files claimed by another TU skipped.",
+                 claims.numClaims,
+                 claims.numConflicts);
+  }
 }
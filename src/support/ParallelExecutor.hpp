@@ -8,10 +8,17 @@
 #include "clang/Tooling/Execution.h"
 #include "llvm/Support/ThreadPool.h"
 
+#include "indexer/IndexCache.hpp"
+#include "indexer/SpilledIndex.hpp"
+#include "types/ClaimTable.hpp"
+#include "types/Config.hpp"
+#include "types/Index.hpp"
+#include "types/SymbolIDTable.hpp"
+
 namespace hdoc::indexer {
 /// @brief A cut-down reimplementation of clang's AllTUsToolExecutor.
-/// Removes everything we don't need, leaving a simple mechanism that executes
-/// a frontend action over all files in the compilation database.
+/// Removes everything we don't need, leaving a simple mechanism that indexes
+/// all files in the compilation database.
 class ParallelExecutor {
 public:
   /// Creates a parallel executor that will run over all files in the compilation database.
@@ -19,15 +26,25 @@ public:
   ParallelExecutor(const clang::tooling::CompilationDatabase& cmpdb,
                    const std::vector<std::string>&            includePaths,
                    llvm::ThreadPool&                          pool,
-                   const uint32_t                             debugLimitNumIndexedFiles)
-      : cmpdb(cmpdb), includePaths(includePaths), pool(pool), debugLimitNumIndexedFiles(debugLimitNumIndexedFiles) {}
+                   const hdoc::types::Config*                 cfg)
+      : cmpdb(cmpdb), includePaths(includePaths), pool(pool), cfg(cfg) {}
 
-  void execute(std::unique_ptr<clang::tooling::FrontendActionFactory> action);
+  /// @brief Index every file in the compilation database into index.
+  /// TUs whose shard in cache is up to date are loaded from the cache instead of being parsed.
+  /// Unless the cache is enabled, each symbol is only indexed by the first thread to claim it in symbolClaims.
+  /// If symbolIDs isn't null, the SymbolIDs of parsed symbols are checked for collisions.
+  /// If spill isn't null, the Index of a thread is spilled to disk after a TU once memory usage crosses its threshold,
+  /// and only the symbols that weren't spilled are merged into index.
+  void execute(hdoc::types::Index&          index,
+               hdoc::indexer::IndexCache&   cache,
+               hdoc::types::IndexClaims&    symbolClaims,
+               hdoc::types::SymbolIDTable*  symbolIDs,
+               hdoc::indexer::SpilledIndex* spill);
 
 private:
   const clang::tooling::CompilationDatabase& cmpdb;
   const std::vector<std::string>&            includePaths;
   llvm::ThreadPool&                          pool;
-  const uint32_t                             debugLimitNumIndexedFiles = 0;
+  const hdoc::types::Config*                 cfg;
 };
 } // namespace hdoc::indexer
@@ -0,0 +1,104 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/PathMatcher.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <queue>
+
+hdoc::utils::PathMatcher::PathMatcher(std::vector<std::string> patterns) : patternList(std::move(patterns)) {
+  std::vector<llvm::StringRef> substrings;
+  for (const auto& pattern : this->patternList) {
+    if (pattern.find_first_of("*?[") != std::string::npos) {
+      if (auto glob = llvm::GlobPattern::create(pattern)) {
+        this->globs.emplace_back(std::move(*glob));
+        continue;
+      } else {
+        spdlog::warn("Ignore path '{}' isn't a valid glob ({}), matching it as a substring instead.",
+                     pattern,
+                     llvm::toString(glob.takeError()));
+      }
+    }
+    substrings.emplace_back(pattern);
+  }
+  if (substrings.empty()) {
+    return;
+  }
+
+  // Only bytes that appear in a pattern need their own input class, which keeps the transition table small
+  for (const auto& substr : substrings) {
+    for (const unsigned char c : substr) {
+      if (this->byteClasses[c] == 0) {
+        this->byteClasses[c] = this->numClasses++;
+      }
+    }
+  }
+
+  // Build a trie of the patterns, where state 0 is the root. The root is never the target of a trie edge, so a
+  // transition to state 0 means that there is no edge yet.
+  this->transitions.assign(this->numClasses, 0);
+  this->accepting.assign(1, false);
+  for (const auto& substr : substrings) {
+    uint32_t state = 0;
+    for (const unsigned char c : substr) {
+      const size_t edge = state * this->numClasses + this->byteClasses[c];
+      if (this->transitions[edge] == 0) {
+        this->transitions[edge] = this->accepting.size();
+        this->accepting.emplace_back(false);
+        this->transitions.resize(this->transitions.size() + this->numClasses, 0);
+      }
+      state = this->transitions[edge];
+    }
+    this->accepting[state] = true;
+  }
+
+  // Compute the failure link of every state in breadth-first order, i.e. the state for the longest proper suffix of
+  // its string that is also in the trie, and replace each missing edge by the edge of the failure state.
+  // A state accepts if its failure state does, since a pattern that is a suffix of the input was found.
+  std::vector<uint32_t> failure(this->accepting.size(), 0);
+  std::queue<uint32_t>  queue;
+  for (uint32_t cls = 0; cls < this->numClasses; cls++) {
+    if (const uint32_t child = this->transitions[cls]; child != 0) {
+      queue.push(child);
+    }
+  }
+  while (!queue.empty()) {
+    const uint32_t state = queue.front();
+    queue.pop();
+    this->accepting[state] = this->accepting[state] || this->accepting[failure[state]];
+    for (uint32_t cls = 0; cls < this->numClasses; cls++) {
+      const size_t   edge         = state * this->numClasses + cls;
+      const uint32_t failureChild = this->transitions[failure[state] * this->numClasses + cls];
+      if (const uint32_t child = this->transitions[edge]; child != 0) {
+        failure[child] = failureChild;
+        queue.push(child);
+      } else {
+        this->transitions[edge] = failureChild;
+      }
+    }
+  }
+}
+
+bool hdoc::utils::PathMatcher::matches(const llvm::StringRef path) const {
+  if (!this->transitions.empty()) {
+    // The root only accepts if one of the patterns is empty, which matches everything like std::string::find() does
+    uint32_t state = 0;
+    if (this->accepting[state]) {
+      return true;
+    }
+    for (const unsigned char c : path) {
+      state = this->transitions[state * this->numClasses + this->byteClasses[c]];
+      if (this->accepting[state]) {
+        return true;
+      }
+    }
+  }
+
+  for (const auto& glob : this->globs) {
+    if (glob.match(path)) {
+      return true;
+    }
+  }
+  return false;
+}
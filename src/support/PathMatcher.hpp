@@ -0,0 +1,51 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/GlobPattern.h"
+
+namespace hdoc::utils {
+/// @brief Checks paths against a list of patterns, such as the ignore paths from .hdoc.toml.
+///
+/// Plain patterns match if they're a substring of the path. They're compiled into a single Aho-Corasick automaton,
+/// so a path is checked against all of them in one pass over its characters, no matter how many patterns there are.
+/// Patterns that contain a wildcard (`*`, `?`, or `[`) are globs that must match the entire path.
+/// A PathMatcher is immutable once it's constructed, so it can be shared by any number of threads.
+class PathMatcher {
+public:
+  PathMatcher() = default;
+  PathMatcher(std::vector<std::string> patterns);
+  PathMatcher(std::initializer_list<std::string> patterns) : PathMatcher(std::vector<std::string>(patterns)) {}
+
+  /// @brief Returns true if any of the patterns matches the path
+  bool matches(llvm::StringRef path) const;
+
+  /// @brief Returns true if there are no patterns, in which case nothing matches
+  bool empty() const {
+    return this->patternList.empty();
+  }
+
+  /// @brief The patterns, in the order they were given
+  const std::vector<std::string>& patterns() const {
+    return this->patternList;
+  }
+
+private:
+  std::vector<std::string>       patternList;
+  std::vector<llvm::GlobPattern> globs;
+
+  // The automaton is a DFA where every state has a transition for every input class, so that matching never
+  // has to follow failure links. Bytes that don't appear in any pattern all share class 0.
+  uint16_t              byteClasses[256] = {}; ///< Maps each byte to its input class
+  uint32_t              numClasses       = 1;  ///< Number of input classes
+  std::vector<uint32_t> transitions;           ///< Next state for each (state, class), indexed by state * numClasses
+  std::vector<uint8_t>  accepting;             ///< Does reaching a state mean that a pattern was found?
+};
+} // namespace hdoc::utils
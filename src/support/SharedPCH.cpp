@@ -0,0 +1,267 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/SharedPCH.hpp"
+#include "indexer/IndexAction.hpp"
+
+#include "spdlog/spdlog.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+/// PCHs are only built for groups of at least this many TUs, otherwise precompiling doesn't save any work
+constexpr size_t minTUsPerPCH = 2;
+
+namespace {
+/// @brief Builds a PCH at a given path and collects the files that it depends on
+class BuildPCHAction : public clang::GeneratePCHAction {
+public:
+  BuildPCHAction(const std::string& outputFile, std::vector<std::string>& dependencies, const bool skipFunctionBodies)
+      : outputFile(outputFile), dependencies(dependencies), skipFunctionBodies(skipFunctionBodies) {}
+
+protected:
+  bool BeginInvocation(clang::CompilerInstance& CI) override {
+    CI.getFrontendOpts().OutputFile         = this->outputFile;
+    CI.getFrontendOpts().SkipFunctionBodies = this->skipFunctionBodies;
+    return clang::GeneratePCHAction::BeginInvocation(CI);
+  }
+
+  void EndSourceFileAction() override {
+    hdoc::indexer::collectDependencies(this->getCompilerInstance().getSourceManager(), this->dependencies);
+    clang::GeneratePCHAction::EndSourceFileAction();
+  }
+
+private:
+  std::string               outputFile;
+  std::vector<std::string>& dependencies;
+  bool                      skipFunctionBodies;
+};
+
+/// A group of TUs that share the same flags, along with the #include prefix they have in common
+struct PCHGroup {
+  clang::tooling::CompileCommand cmd;      ///< Adjusted compile command of the first TU in the group
+  std::vector<std::string>       files;    ///< TUs in the group
+  std::vector<std::string>       includes; ///< #include directives common to all TUs in the group
+};
+} // namespace
+
+/// @brief Get the #include directives at the start of a file, stopping at the first line that isn't an #include
+/// Quoted includes are rewritten to use absolute paths when they're found relative to the file, so that the
+/// directives mean the same thing regardless of which file they appear in.
+static std::vector<std::string> getLeadingIncludes(const std::string& file) {
+  std::vector<std::string> includes;
+  auto                     buf = llvm::MemoryBuffer::getFile(file);
+  if (!buf) {
+    return includes;
+  }
+
+  llvm::SmallVector<llvm::StringRef> lines;
+  buf.get()->getBuffer().split(lines, '\n');
+
+  bool inBlockComment = false;
+  for (llvm::StringRef line : lines) {
+    line = line.trim();
+
+    // Skip over blank lines and comments, which are commonly used for license headers
+    if (inBlockComment) {
+      inBlockComment = !line.contains("*/");
+      continue;
+    }
+    if (line.empty() || line.startswith("//")) {
+      continue;
+    }
+    if (line.startswith("/*")) {
+      inBlockComment = !line.contains("*/");
+      continue;
+    }
+
+    if (!line.consume_front("#")) {
+      break;
+    }
+    line = line.ltrim();
+    if (line.startswith("pragma") && line.drop_front(6).trim() == "once") {
+      continue;
+    }
+    if (!line.consume_front("include")) {
+      break;
+    }
+    line = line.ltrim();
+
+    // Only the header name is kept so that trailing comments don't affect the comparison between TUs
+    if (line.startswith("<")) {
+      includes.emplace_back("#include " + line.take_until([](char c) { return c == '>'; }).str() + ">");
+    } else if (line.startswith("\"")) {
+      const llvm::StringRef  header = line.drop_front().take_until([](char c) { return c == '"'; });
+      llvm::SmallString<256> path(llvm::sys::path::parent_path(file));
+      llvm::sys::path::append(path, header);
+      llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+      if (llvm::sys::fs::exists(path)) {
+        includes.emplace_back("#include \"" + path.str().str() + "\"");
+      } else {
+        includes.emplace_back("#include \"" + header.str() + "\"");
+      }
+    } else {
+      // Computed includes can't be compared textually
+      break;
+    }
+  }
+  return includes;
+}
+
+/// @brief Get a key that is identical for TUs which are compiled with the same flags in the same directory
+static std::string getGroupKey(const clang::tooling::CompileCommand& cmd) {
+  std::string key = cmd.Directory;
+  for (const auto& arg : cmd.CommandLine) {
+    if (arg != cmd.Filename) {
+      key += '\0' + arg;
+    }
+  }
+  return key;
+}
+
+hdoc::indexer::SharedPCHs::SharedPCHs(const clang::tooling::CompilationDatabase&            cmpdb,
+                                      const std::vector<std::string>&                       files,
+                                      const clang::tooling::ArgumentsAdjuster&              adjuster,
+                                      const std::shared_ptr<clang::PCHContainerOperations>& pchOps,
+                                      llvm::ThreadPool&                                     pool,
+                                      const bool                                            skipFunctionBodies) {
+  llvm::SmallString<128> prefix;
+  llvm::SmallString<128> tmpDir;
+  llvm::sys::path::system_temp_directory(/*erasedOnReboot=*/true, prefix);
+  llvm::sys::path::append(prefix, "hdoc-pch");
+  if (const auto ec = llvm::sys::fs::createUniqueDirectory(prefix, tmpDir)) {
+    spdlog::warn("Unable to create a directory for shared PCHs ({}). Proceeding without them.", ec.message());
+    return;
+  }
+  // Dependencies are collected with their real paths, so the directory's real path is needed to filter them
+  llvm::SmallString<128> realDir;
+  if (llvm::sys::fs::real_path(tmpDir, realDir)) {
+    realDir = tmpDir;
+  }
+  this->dir = realDir.str().str();
+
+  // Group TUs with identical flags. A std::map is used so that the order of the groups is deterministic.
+  std::map<std::string, PCHGroup> groups;
+  for (const auto& file : files) {
+    const auto cmds = cmpdb.getCompileCommands(file);
+    // Files that are compiled multiple times with different flags are left alone
+    if (cmds.size() != 1) {
+      continue;
+    }
+    clang::tooling::CompileCommand cmd = cmds.front();
+    cmd.CommandLine                    = adjuster(cmd.CommandLine, cmd.Filename);
+
+    PCHGroup& group = groups[getGroupKey(cmd)];
+    if (group.files.empty()) {
+      group.cmd = cmd;
+    }
+    group.files.emplace_back(file);
+  }
+
+  // Find the include prefix common to every TU in each group
+  std::vector<PCHGroup*> candidates;
+  for (auto& [key, group] : groups) {
+    if (group.files.size() < minTUsPerPCH) {
+      continue;
+    }
+    group.includes = getLeadingIncludes(group.files.front());
+    for (const auto& file : group.files) {
+      const std::vector<std::string> includes = getLeadingIncludes(file);
+      const auto mismatch =
+          std::mismatch(group.includes.begin(), group.includes.end(), includes.begin(), includes.end());
+      group.includes.erase(mismatch.first, group.includes.end());
+      if (group.includes.empty()) {
+        break;
+      }
+    }
+    if (!group.includes.empty()) {
+      candidates.emplace_back(&group);
+    }
+  }
+
+  // Build the PCHs in parallel
+  std::mutex mutex;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    pool.async(
+        [&](const size_t i) {
+          const PCHGroup& group  = *candidates[i];
+          const auto      header = this->dir / ("prelude-" + std::to_string(i) + ".hpp");
+          auto            pch    = std::make_unique<SharedPCH>();
+          pch->path              = (this->dir / ("prelude-" + std::to_string(i) + ".pch")).string();
+
+          std::ofstream(header) << llvm::join(group.includes, "\n") << "\n";
+
+          // Precompile the synthetic header with exactly the same flags as the TUs in the group
+          std::vector<std::string> commandLine;
+          for (const auto& arg : group.cmd.CommandLine) {
+            if (arg != group.cmd.Filename) {
+              commandLine.emplace_back(arg);
+            }
+          }
+          commandLine.emplace_back("-x");
+          commandLine.emplace_back(llvm::sys::path::extension(group.cmd.Filename) == ".c" ? "c-header" : "c++-header");
+          commandLine.emplace_back(header.string());
+
+          llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS = llvm::vfs::createPhysicalFileSystem().release();
+          FS->setCurrentWorkingDirectory(group.cmd.Directory);
+          llvm::IntrusiveRefCntPtr<clang::FileManager> files(new clang::FileManager(clang::FileSystemOptions(), FS));
+
+          // Diagnostics are counted but not printed. A PCH with errors can't be loaded, so it isn't used.
+          clang::DiagnosticConsumer      diags;
+          clang::tooling::ToolInvocation invocation(
+              commandLine,
+              std::make_unique<BuildPCHAction>(pch->path, pch->dependencies, skipFunctionBodies),
+              files.get(),
+              pchOps);
+          invocation.setDiagnosticConsumer(&diags);
+          if (!invocation.run() || diags.getNumErrors() > 0) {
+            spdlog::warn("Unable to build shared PCH for {} TUs, they will be parsed without it.", group.files.size());
+            return;
+          }
+          // The synthetic header only repeats #includes of the TUs, whose headers are already dependencies
+          this->removeTemporaryFiles(pch->dependencies);
+
+          spdlog::info("Built shared PCH with {} #includes for {} TUs", group.includes.size(), group.files.size());
+          std::lock_guard<std::mutex> lock(mutex);
+          for (const auto& file : group.files) {
+            this->pchForFile.emplace(file, pch.get());
+          }
+          this->pchs.emplace_back(std::move(pch));
+        },
+        i);
+  }
+  pool.wait();
+}
+
+hdoc::indexer::SharedPCHs::~SharedPCHs() {
+  if (!this->dir.empty()) {
+    std::error_code ec;
+    std::filesystem::remove_all(this->dir, ec);
+  }
+}
+
+const hdoc::indexer::SharedPCH* hdoc::indexer::SharedPCHs::get(const std::string& file) const {
+  if (const auto it = this->pchForFile.find(file); it != this->pchForFile.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+void hdoc::indexer::SharedPCHs::removeTemporaryFiles(std::vector<std::string>& dependencies) const {
+  if (this->dir.empty()) {
+    return;
+  }
+  const std::string prefix = (this->dir / "").string();
+  const auto isTemporary = [&prefix](const std::string& path) { return llvm::StringRef(path).startswith(prefix); };
+  dependencies.erase(std::remove_if(dependencies.begin(), dependencies.end(), isTemporary), dependencies.end());
+}
@@ -0,0 +1,57 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "clang/Serialization/PCHContainerOperations.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/ThreadPool.h"
+
+namespace hdoc::indexer {
+/// @brief A precompiled header shared by a group of translation units
+struct SharedPCH {
+  std::string              path;         ///< Path to the precompiled header
+  std::vector<std::string> dependencies; ///< Absolute paths of the headers that were read to build the PCH
+};
+
+/// @brief Precompiled headers for the #includes that groups of translation units have in common.
+///
+/// TUs are grouped by their (adjusted) compile commands, since a PCH can only be used with the flags it was built
+/// with. The longest prefix of #include directives that is common to every TU in a group is written to a synthetic
+/// header, which is precompiled once and then loaded by each TU with -include-pch instead of parsing the
+/// included files again.
+class SharedPCHs {
+public:
+  /// Builds PCHs for all of the given files, in parallel on pool.
+  /// adjuster must be the same arguments adjuster that is used when indexing each TU.
+  /// If skipFunctionBodies is true, the bodies of functions in the shared headers aren't parsed.
+  SharedPCHs(const clang::tooling::CompilationDatabase&            cmpdb,
+             const std::vector<std::string>&                       files,
+             const clang::tooling::ArgumentsAdjuster&              adjuster,
+             const std::shared_ptr<clang::PCHContainerOperations>& pchOps,
+             llvm::ThreadPool&                                     pool,
+             const bool                                            skipFunctionBodies);
+
+  /// Removes all of the PCHs and synthetic headers from disk.
+  ~SharedPCHs();
+
+  /// @brief Get the PCH to use for a TU, or nullptr if the TU doesn't have one
+  const SharedPCH* get(const std::string& file) const;
+
+  /// @brief Remove the synthetic headers and PCHs from a list of files that a TU depends on.
+  /// They're deleted at the end of each run, so a cached TU that depends on them would never be reused.
+  void removeTemporaryFiles(std::vector<std::string>& dependencies) const;
+
+private:
+  std::filesystem::path                             dir;        ///< Temporary directory where PCHs are stored
+  std::vector<std::unique_ptr<SharedPCH>>           pchs;       ///< PCHs that were successfully built
+  std::unordered_map<std::string, const SharedPCH*> pchForFile; ///< Maps each TU to its PCH
+};
+} // namespace hdoc::indexer
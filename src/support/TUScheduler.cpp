@@ -0,0 +1,168 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/TUScheduler.hpp"
+
+#include "spdlog/spdlog.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+hdoc::indexer::TUScheduler::TUScheduler(const std::filesystem::path& dir)
+    : start(std::chrono::steady_clock::now()), lastStart(start) {
+  if (dir.empty()) {
+    return;
+  }
+  this->path = dir / "tu-timings";
+
+  // Each line of the file is the parse time of a TU in microseconds, followed by a tab and the path of the TU
+  auto buf = llvm::MemoryBuffer::getFile(this->path.string());
+  if (!buf) {
+    return;
+  }
+  llvm::SmallVector<llvm::StringRef> lines;
+  buf.get()->getBuffer().split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (const llvm::StringRef line : lines) {
+    const auto [micros, file] = line.split('\t');
+    uint64_t time             = 0;
+    if (file.empty() || micros.getAsInteger(10, time)) {
+      continue;
+    }
+    this->previousTimes.emplace(file.str(), time);
+  }
+}
+
+std::vector<std::string> hdoc::indexer::TUScheduler::schedule(const std::vector<std::string>& files) {
+  std::vector<uint64_t> sizes(files.size(), 0);
+  uint64_t              timedMicros = 0;
+  uint64_t              timedBytes  = 0;
+  for (size_t i = 0; i < files.size(); i++) {
+    llvm::sys::fs::file_size(files[i], sizes[i]);
+    if (const auto it = this->previousTimes.find(files[i]); it != this->previousTimes.end()) {
+      timedMicros += it->second;
+      timedBytes += sizes[i];
+    }
+  }
+
+  // TUs that weren't parsed on the previous run are estimated from the size of their main file, scaled by how long
+  // it took to parse each byte of the TUs that were, so that both kinds of estimates can be compared
+  const double microsPerByte = timedBytes > 0 ? static_cast<double>(timedMicros) / timedBytes : 1.0;
+  uint32_t     numEstimated  = 0;
+
+  std::vector<std::pair<double, const std::string*>> costs;
+  costs.reserve(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    if (const auto it = this->previousTimes.find(files[i]); it != this->previousTimes.end()) {
+      costs.emplace_back(static_cast<double>(it->second), &files[i]);
+    } else {
+      costs.emplace_back(microsPerByte * sizes[i], &files[i]);
+      numEstimated++;
+    }
+  }
+  // A stable sort keeps TUs with the same cost in compile database order, so the schedule is deterministic
+  std::stable_sort(
+      costs.begin(), costs.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+  spdlog::info("Scheduling TUs longest-first: {} costs from the previous run's parse times, {} from file sizes.",
+               files.size() - numEstimated,
+               numEstimated);
+
+  std::vector<std::string> order;
+  order.reserve(files.size());
+  for (const auto& [cost, file] : costs) {
+    order.emplace_back(*file);
+  }
+  return order;
+}
+
+void hdoc::indexer::TUScheduler::record(const std::string& file, const std::chrono::steady_clock::duration elapsed) {
+  const auto                  now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->times[file] = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  this->lastStart   = std::max(this->lastStart, now - elapsed);
+}
+
+uint64_t hdoc::indexer::TUScheduler::simulate(const std::vector<std::string>& order, const uint32_t numThreads) const {
+  // Each TU is given to whichever thread becomes free first, like the ThreadPool does
+  std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> threads;
+  for (uint32_t i = 0; i < std::max(numThreads, 1U); i++) {
+    threads.push(0);
+  }
+
+  uint64_t end = 0;
+  for (const auto& file : order) {
+    const auto it = this->times.find(file);
+    if (it == this->times.end()) {
+      continue;
+    }
+    const uint64_t finish = threads.top() + it->second;
+    threads.pop();
+    threads.push(finish);
+    end = std::max(end, finish);
+  }
+  return end;
+}
+
+void hdoc::indexer::TUScheduler::finish(const std::vector<std::string>& files,
+                                        const std::vector<std::string>& order,
+                                        const uint32_t                  numThreads) {
+  const auto end = std::chrono::steady_clock::now();
+  if (this->times.empty()) {
+    return;
+  }
+
+  const double wallTime = std::chrono::duration<double>(end - this->start).count();
+  const double tailTime = std::chrono::duration<double>(end - this->lastStart).count();
+  const double naiveEnd = this->simulate(files, numThreads) / 1e6;
+  const double schedEnd = this->simulate(order, numThreads) / 1e6;
+  spdlog::info("Parsed {} TUs in {:.1f}s, the last TU was started {:.1f}s before the end.",
+               this->times.size(),
+               wallTime,
+               tailTime);
+  spdlog::info("Estimated parse time with {} threads: {:.1f}s in compile database order, {:.1f}s longest-first "
+               "({:.1f}s saved).",
+               numThreads,
+               naiveEnd,
+               schedEnd,
+               naiveEnd - schedEnd);
+
+  if (this->path.empty()) {
+    return;
+  }
+
+  // Keep the times of TUs that weren't parsed during this run (i.e. were loaded from the index cache), but forget
+  // about TUs that are no longer in the compilation database
+  std::string out;
+  for (const auto& file : files) {
+    auto it = this->times.find(file);
+    if (it == this->times.end()) {
+      it = this->previousTimes.find(file);
+      if (it == this->previousTimes.end()) {
+        continue;
+      }
+    }
+    out += std::to_string(it->second) + '\t' + file + '\n';
+  }
+
+  // Write to a temporary file and move it into place so that an interrupted run never leaves a partial file behind
+  int                    fd;
+  llvm::SmallString<256> tmpPath;
+  if (const auto ec = llvm::sys::fs::createUniqueFile(this->path.string() + "-%%%%%%%%.tmp", fd, tmpPath)) {
+    spdlog::warn("Unable to save TU parse times ({}).", ec.message());
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << out;
+  }
+  if (const auto ec = llvm::sys::fs::rename(tmpPath, this->path.string())) {
+    spdlog::warn("Unable to save TU parse times ({}).", ec.message());
+    llvm::sys::fs::remove(tmpPath);
+  }
+}
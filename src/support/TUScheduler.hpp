@@ -0,0 +1,47 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hdoc::indexer {
+/// @brief Decides the order in which TUs are indexed so that the most expensive TUs are started first.
+///
+/// When the largest TUs are started last, the other threads run out of work and sit idle while they finish.
+/// Starting the most expensive TUs first (longest processing time first scheduling) keeps every thread busy
+/// until close to the end of the run. The cost of each TU is estimated from how long it took to parse on the
+/// previous run, or from the size of its main file if it hasn't been parsed before.
+class TUScheduler {
+public:
+  /// Loads the parse times that were recorded during the previous run from dir, if dir isn't empty.
+  TUScheduler(const std::filesystem::path& dir);
+
+  /// @brief Get files sorted from most to least expensive
+  std::vector<std::string> schedule(const std::vector<std::string>& files);
+
+  /// @brief Record how long a TU took to be parsed and indexed. Safe to call from multiple threads.
+  void record(const std::string& file, const std::chrono::steady_clock::duration elapsed);
+
+  /// @brief Save the recorded parse times for the next run, and log how long the run took compared to how long
+  /// it would have taken if the TUs were indexed in the order given by files.
+  void finish(const std::vector<std::string>& files, const std::vector<std::string>& order, const uint32_t numThreads);
+
+private:
+  /// @brief Simulate running TUs in the given order on numThreads threads using the times recorded during this run.
+  /// Returns the time taken until the last TU is finished, in microseconds.
+  uint64_t simulate(const std::vector<std::string>& order, const uint32_t numThreads) const;
+
+  std::filesystem::path                     path;          ///< Where parse times are persisted (empty == off)
+  std::unordered_map<std::string, uint64_t> previousTimes; ///< Parse times from the previous run, in microseconds
+  std::unordered_map<std::string, uint64_t> times;         ///< Parse times recorded during this run, in microseconds
+  std::chrono::steady_clock::time_point     start;         ///< When this run started
+  std::chrono::steady_clock::time_point     lastStart;     ///< When the last TU to be parsed was started
+  std::mutex                                mutex;         ///< Guards times and lastStart
+};
+} // namespace hdoc::indexer
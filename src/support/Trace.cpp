@@ -0,0 +1,93 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "support/Trace.hpp"
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <utility>
+
+hdoc::utils::TraceRecorder::Lane& hdoc::utils::TraceRecorder::lane() {
+  // Lanes are never destroyed, so a thread can keep a pointer to its lane for as long as it lives
+  thread_local Lane* threadLane = nullptr;
+  if (threadLane == nullptr) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->lanes.emplace_back(std::make_unique<Lane>());
+    threadLane         = this->lanes.back().get();
+    threadLane->tid    = this->lanes.size();
+    threadLane->isMain = std::this_thread::get_id() == this->mainThread;
+  }
+  return *threadLane;
+}
+
+void hdoc::utils::TraceRecorder::record(const llvm::StringRef   name,
+                                        std::string             detail,
+                                        const Clock::time_point start,
+                                        const Clock::time_point end) {
+  Lane&                       lane = this->lane();
+  std::lock_guard<std::mutex> lock(lane.mutex);
+  lane.events.push_back({name.str(), std::move(detail), start, end});
+}
+
+size_t hdoc::utils::TraceRecorder::size() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  size_t                      size = 0;
+  for (const auto& lane : this->lanes) {
+    std::lock_guard<std::mutex> laneLock(lane->mutex);
+    size += lane->events.size();
+  }
+  return size;
+}
+
+bool hdoc::utils::TraceRecorder::write(const std::filesystem::path& path) {
+  std::error_code      ec;
+  llvm::raw_fd_ostream out(path.string(), ec);
+  if (ec) {
+    return false;
+  }
+
+  const auto microseconds = [&](const Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t - this->epoch).count();
+  };
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  llvm::json::OStream         json(out);
+  json.object([&] {
+    json.attributeArray("traceEvents", [&] {
+      for (const auto& lane : this->lanes) {
+        std::lock_guard<std::mutex> laneLock(lane->mutex);
+        // Name the lane so that the thread which started the run is easy to tell apart from the workers
+        json.object([&] {
+          json.attribute("ph", "M");
+          json.attribute("name", "thread_name");
+          json.attribute("pid", 1);
+          json.attribute("tid", lane->tid);
+          json.attributeObject("args", [&] {
+            json.attribute("name", lane->isMain ? std::string("main") : "thread " + std::to_string(lane->tid));
+          });
+        });
+        for (const auto& event : lane->events) {
+          json.object([&] {
+            json.attribute("ph", "X");
+            json.attribute("name", event.name);
+            json.attribute("pid", 1);
+            json.attribute("tid", lane->tid);
+            json.attribute("ts", microseconds(event.start));
+            json.attribute("dur", microseconds(event.end) - microseconds(event.start));
+            if (!event.detail.empty()) {
+              json.attributeObject("args", [&] { json.attribute("detail", event.detail); });
+            }
+          });
+        }
+      }
+    });
+    json.attribute("displayTimeUnit", "ms");
+  });
+  out.flush();
+
+  // raw_fd_ostream aborts on destruction if an error wasn't cleared
+  const bool success = !out.has_error();
+  out.clear_error();
+  return success;
+}
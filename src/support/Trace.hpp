@@ -0,0 +1,106 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace hdoc::utils {
+/// @brief Records how long each stage of an hdoc run takes, and writes it as a Chrome trace.
+///
+/// The trace uses the trace event format read by chrome://tracing and https://ui.perfetto.dev, where each thread
+/// that recorded an event gets its own lane. Recording is off until enable() is called, and a disabled recorder
+/// costs one atomic load per TraceScope.
+class TraceRecorder {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// @brief The recorder used by every TraceScope
+  static TraceRecorder& global() {
+    static TraceRecorder recorder;
+    return recorder;
+  }
+
+  /// @brief Start recording events, with the calling thread shown as the main thread
+  void enable() {
+    this->mainThread = std::this_thread::get_id();
+    this->enabled.store(true);
+  }
+
+  /// @brief Check if events are being recorded
+  bool isEnabled() const {
+    return this->enabled.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Record an event that took place on the calling thread
+  void record(const llvm::StringRef name, std::string detail, Clock::time_point start, Clock::time_point end);
+
+  /// @brief Write every recorded event to path, returning false if the file couldn't be written.
+  /// Events that are recorded while the trace is being written might be left out.
+  bool write(const std::filesystem::path& path);
+
+  /// @brief Number of events recorded so far
+  size_t size();
+
+private:
+  struct Event {
+    std::string       name;   ///< What happened, i.e. "Parse TU"
+    std::string       detail; ///< What it happened to, i.e. the path of the TU
+    Clock::time_point start;
+    Clock::time_point end;
+  };
+
+  /// Each thread records events into its own lane so that threads don't contend with each other
+  struct Lane {
+    std::mutex         mutex; ///< Only contended while the trace is being written
+    std::vector<Event> events;
+    uint32_t           tid    = 0;
+    bool               isMain = false;
+  };
+
+  /// @brief Get the lane of the calling thread, creating it on the first call from that thread
+  Lane& lane();
+
+  std::atomic<bool>                  enabled = false;
+  const Clock::time_point            epoch   = Clock::now(); ///< All timestamps are relative to this
+  std::thread::id                    mainThread;             ///< Thread that called enable()
+  std::mutex                         mutex;                  ///< Protects lanes
+  std::vector<std::unique_ptr<Lane>> lanes;
+};
+
+/// @brief Records an event spanning the lifetime of this object to the global TraceRecorder, if it's enabled.
+/// The detail is only copied when recording, but building it still has a cost, so it should be cheap to compute.
+class TraceScope {
+public:
+  TraceScope(const llvm::StringRef name, const llvm::StringRef detail = "")
+      : active(TraceRecorder::global().isEnabled()) {
+    if (this->active) {
+      this->name   = name;
+      this->detail = detail.str();
+      this->start  = TraceRecorder::Clock::now();
+    }
+  }
+  ~TraceScope() {
+    if (this->active) {
+      TraceRecorder::global().record(this->name, std::move(this->detail), this->start, TraceRecorder::Clock::now());
+    }
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  bool                             active;
+  llvm::StringRef                  name;   ///< Must outlive the scope, which is always the case for literals
+  std::string                      detail; ///< Copied, since it's usually built just for the scope
+  TraceRecorder::Clock::time_point start;
+};
+} // namespace hdoc::utils
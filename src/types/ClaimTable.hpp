@@ -0,0 +1,66 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+#include "types/Symbols.hpp"
+
+namespace hdoc::types {
+/// @brief Process-wide set of SymbolIDs that have been claimed by a thread for indexing.
+///
+/// The same symbol is often reached by many TUs, for example a function that is declared in a header and defined
+/// in a source file. The first thread to claim a SymbolID indexes the symbol and every other thread skips it
+/// before doing any work. The set is split into shards, each with its own lock, so that threads claiming
+/// different symbols rarely contend with each other.
+class ClaimTable {
+public:
+  /// @brief Claim a SymbolID, returning true if it wasn't claimed before and false if it already was
+  bool tryClaim(const hdoc::types::SymbolID& id) {
+    Shard&                      shard = this->shards[id.raw() % numShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const bool                  won = shard.ids.insert(id).second;
+    if (won) {
+      this->numWon++;
+    } else {
+      this->numLost++;
+    }
+    return won;
+  }
+
+  /// @brief Give up the claim on a SymbolID, so that the next thread to claim it wins.
+  /// Used when the symbols that a thread indexed are discarded, for example when a TU has to be parsed again.
+  void release(const hdoc::types::SymbolID& id) {
+    Shard&                      shard = this->shards[id.raw() % numShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.ids.erase(id) > 0) {
+      this->numWon--;
+    }
+  }
+
+  std::atomic<uint32_t> numWon  = 0; ///< Number of SymbolIDs claimed
+  std::atomic<uint32_t> numLost = 0; ///< Number of times a thread tried to claim a SymbolID that was already claimed
+
+private:
+  static constexpr size_t numShards = 64;
+
+  /// Each shard is aligned to a cache line so that threads locking neighbouring shards don't share a line
+  struct alignas(64) Shard {
+    std::mutex                                mutex;
+    std::unordered_set<hdoc::types::SymbolID> ids;
+  };
+  std::array<Shard, numShards> shards;
+};
+
+/// @brief ClaimTables for each type of symbol in the Index
+struct IndexClaims {
+  ClaimTable functions;
+  ClaimTable records;
+  ClaimTable enums;
+  ClaimTable namespaces;
+};
+} // namespace hdoc::types
@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include "support/PathMatcher.hpp"
+
 namespace hdoc::types {
 
 /// @brief Indicates the type of hdoc binary.
@@ -17,6 +19,12 @@ enum class BinaryType {
   Server, ///< For internal hdoc usage.
 };
 
+/// @brief Indicates how symbols are extracted from the AST of each translation unit.
+enum class IndexingEngine {
+  Matchers, ///< Clang ASTMatchers, with one matcher per type of symbol
+  Visitor,  ///< A single RecursiveASTVisitor pass that prunes subtrees which can't contain indexable symbols
+};
+
 /// @brief Stores configuration data that hdoc uses for indexing and serialization
 struct Config {
   bool                     initialized       = false; ///< Is this object initialized?
@@ -33,13 +41,29 @@ struct Config {
   std::string              gitRepoURL;                   ///< URL prefix of a GitHub or GitLab repo for source links
   std::string              gitDefaultBranch;             ///< Default branch of the git repo
   std::vector<std::string> includePaths;                 ///< Include paths passed on to Clang
-  std::vector<std::string> ignorePaths;                  ///< Paths from which matches should be ignored
+  hdoc::utils::PathMatcher ignorePaths;                  ///< Paths from which matches should be ignored
   bool                     ignorePrivateMembers = false; ///< Should private members of records be ignored?
   std::filesystem::path    homepage;                     ///< Path to "homepage" markdown file
   std::vector<std::filesystem::path> mdPaths;            ///< Paths to markdown pages
 
-  uint32_t debugLimitNumIndexedFiles;    ///< Limit the number of files to index (0 == index all files)
-  bool     debugDumpJSONPayload = false; ///< Dump JSON payload to current working directory
+  std::filesystem::path cacheDir;                                      ///< Where TU index shards are cached
+  bool                  sharedPCH          = false;                    ///< Precompile #includes shared by TUs
+  IndexingEngine        engine             = IndexingEngine::Matchers; ///< How symbols are extracted from the AST
+  bool                  skipFunctionBodies = false;                    ///< Don't parse the bodies of functions
+  bool                  headersOnly        = false;                    ///< Index headers instead of source files
+  uint32_t              headersPerTU       = 16;                       ///< Max headers included by each header TU
+  bool                  minimalTUs         = false;                    ///< Only index TUs needed to cover all headers
+  bool                  checkSymbolIDs     = false;                    ///< Report SymbolIDs shared by multiple USRs
+  uint64_t              memoryBudget       = 0;                        ///< Memory limit for parsing TUs (0 == none)
+  uint64_t              spillThreshold     = 0;                        ///< Memory above which symbols go to disk
+  std::filesystem::path spillDir;                                      ///< Where spilled symbols go (empty == tmp)
+
+  uint32_t              debugLimitNumIndexedFiles;    ///< Limit the number of files to index (0 == index all files)
+  bool                  debugDumpJSONPayload = false; ///< Dump JSON payload to current working directory
+  std::filesystem::path tracePath;                    ///< Where a Chrome trace of the run is written (empty == off)
+  std::filesystem::path metricsPath;                  ///< Where a JSON report of metrics is written (empty == off)
+  std::filesystem::path costReportPath;               ///< Where the slowest TUs and headers are written (empty == off)
+  uint32_t              costReportSize       = 10;    ///< Number of TUs and headers in the cost report
 
   /// @brief Returns a string with the form "PROJECT_NAME PROJECT_VERSION documentation"
   /// if this->projectVersion has a value, otherwise returns "PROJECT_NAME documentation".
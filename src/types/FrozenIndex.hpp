@@ -0,0 +1,231 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "serde/BinarySerde.hpp"
+#include "types/Index.hpp"
+#include "types/Symbols.hpp"
+
+namespace hdoc::types {
+/// @brief Immutable, read-only copy of a Database that is built once indexing and post-processing are done.
+///
+/// Symbols are ordered by name, which is the order in which they're serialized, and are found by SymbolID through
+/// an open-addressing hash table. Nothing is mutated after construction, so any number of threads can look up
+/// symbols at the same time.
+///
+/// Symbols are either stored contiguously in memory, or encoded in a file written by a SpilledIndex, in which case
+/// only the table and the offset of each symbol are kept in memory and symbols are decoded when they're looked up.
+/// Either way, symbols are returned as a Ref. Refs to symbols in memory don't own them, so they must not outlive
+/// the FrozenDatabase, while Refs to symbols read from the file own the decoded symbol.
+template <typename T> class FrozenDatabase {
+public:
+  using Ref = std::shared_ptr<const T>;
+
+  FrozenDatabase() = default;
+  explicit FrozenDatabase(Database<T> db) : numMatches(db.numMatches) {
+    std::vector<std::pair<hdoc::types::SymbolID, T>> entries(std::make_move_iterator(db.entries.begin()),
+                                                             std::make_move_iterator(db.entries.end()));
+    db.entries.clear();
+
+    // Ties are broken by SymbolID so that the order doesn't depend on the order of the entries in db
+    std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.second.name != rhs.second.name ? lhs.second.name < rhs.second.name : lhs.first.raw() < rhs.first.raw();
+    });
+
+    this->resize(entries.size());
+    this->symbols.reserve(entries.size());
+    for (auto& [id, symbol] : entries) {
+      this->insert(id, this->symbols.size());
+      this->symbols.emplace_back(std::move(symbol));
+    }
+  }
+
+  /// @brief Read symbols from data, which holds symbols encoded by hdoc::serde::BinaryWriter.
+  /// entries are the SymbolID of each symbol and the offset at which it's encoded in data, sorted by name.
+  FrozenDatabase(std::shared_ptr<llvm::MemoryBuffer>                           data,
+                 const std::vector<std::pair<hdoc::types::SymbolID, uint64_t>>& entries,
+                 const uint32_t                                                 numMatches)
+      : numMatches(numMatches), data(std::move(data)) {
+    this->resize(entries.size());
+    this->offsets.reserve(entries.size());
+    for (const auto& [id, offset] : entries) {
+      this->insert(id, this->offsets.size());
+      this->offsets.emplace_back(offset);
+    }
+  }
+
+  /// @brief Get the symbol with the given SymbolID, or nullptr if it isn't in the Database
+  Ref find(const hdoc::types::SymbolID& id) const {
+    const uint32_t pos = this->position(id);
+    return pos == emptySlot ? nullptr : this->get(pos);
+  }
+
+  /// @brief Check if the Database contains a symbol, without reading it
+  bool contains(const hdoc::types::SymbolID& id) const {
+    return this->position(id) != emptySlot;
+  }
+
+  /// @brief Get the symbol with the given SymbolID, throwing std::out_of_range if it isn't in the Database
+  Ref at(const hdoc::types::SymbolID& id) const {
+    if (Ref symbol = this->find(id)) {
+      return symbol;
+    }
+    throw std::out_of_range("SymbolID " + id.str() + " isn't in the database");
+  }
+
+  /// @brief Get the symbols for the given SymbolIDs, sorted by name. SymbolIDs that aren't in the Database are skipped.
+  std::vector<Ref> sorted(const std::vector<hdoc::types::SymbolID>& IDs) const {
+    std::vector<uint32_t> positions;
+    positions.reserve(IDs.size());
+    for (const auto& id : IDs) {
+      if (const uint32_t pos = this->position(id); pos != emptySlot) {
+        positions.emplace_back(pos);
+      }
+    }
+    // Symbols are stored in sorted order, so sorting by position sorts by name
+    std::sort(positions.begin(), positions.end());
+
+    std::vector<Ref> result;
+    result.reserve(positions.size());
+    for (const uint32_t pos : positions) {
+      result.emplace_back(this->get(pos));
+    }
+    return result;
+  }
+
+  /// @brief Iterates over symbols in the same order as sorted(), i.e. alphabetically by name.
+  /// A symbol that was read from a file only lives until the iterator is incremented, so it has to be copied to be
+  /// used after that.
+  class const_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const T*;
+    using reference         = const T&;
+
+    const_iterator(const FrozenDatabase* db, const uint32_t pos) : db(db), pos(pos) {}
+
+    reference operator*() const {
+      if (this->current == nullptr) {
+        this->current = this->db->get(this->pos);
+      }
+      return *this->current;
+    }
+    pointer operator->() const {
+      return &**this;
+    }
+    const_iterator& operator++() {
+      this->pos++;
+      this->current.reset();
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const {
+      return this->pos == other.pos;
+    }
+
+  private:
+    const FrozenDatabase* db;
+    uint32_t              pos;
+    mutable Ref           current; ///< The symbol at pos, read when it's first dereferenced
+  };
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const {
+    return const_iterator(this, this->size());
+  }
+  uint32_t size() const {
+    return this->data ? this->offsets.size() : this->symbols.size();
+  }
+  bool empty() const {
+    return this->size() == 0;
+  }
+
+  uint32_t numMatches = 0; ///< Number of matches of the Database this was built from
+
+private:
+  static constexpr uint32_t emptySlot = UINT32_MAX;
+
+  /// Keeping the SymbolID next to the position means that a probe only touches a single cache line
+  struct Slot {
+    uint64_t id;  ///< Raw value of the SymbolID of the symbol
+    uint32_t pos; ///< Position of the symbol in name order, or emptySlot
+  };
+
+  /// @brief Size the table for numSymbols symbols, keeping it at most half full so that probe sequences stay short
+  void resize(const size_t numSymbols) {
+    const size_t numSlots = std::bit_ceil(std::max<size_t>(2 * numSymbols, 16));
+    this->mask            = numSlots - 1;
+    this->slots.assign(numSlots, Slot{0, emptySlot});
+  }
+
+  /// @brief Add the symbol at pos to the table
+  void insert(const hdoc::types::SymbolID& id, const size_t pos) {
+    size_t i = id.raw() & this->mask;
+    while (this->slots[i].pos != emptySlot) {
+      i = (i + 1) & this->mask;
+    }
+    this->slots[i] = {id.raw(), static_cast<uint32_t>(pos)};
+  }
+
+  /// @brief Get the position of the symbol with the given SymbolID, or emptySlot if it isn't in the Database
+  uint32_t position(const hdoc::types::SymbolID& id) const {
+    if (this->slots.empty()) {
+      return emptySlot;
+    }
+    // SymbolIDs are hashes, so their low bits are already uniformly distributed
+    for (size_t i = id.raw() & this->mask; this->slots[i].pos != emptySlot; i = (i + 1) & this->mask) {
+      if (this->slots[i].id == id.raw()) {
+        return this->slots[i].pos;
+      }
+    }
+    return emptySlot;
+  }
+
+  /// @brief Get the symbol at pos, decoding it if it's in a file
+  Ref get(const uint32_t pos) const {
+    if (!this->data) {
+      // Aliases the symbol without owning it
+      return Ref(Ref(), &this->symbols[pos]);
+    }
+    auto                      symbol = std::make_shared<T>();
+    hdoc::serde::BinaryReader reader(this->data->getBuffer().drop_front(this->offsets[pos]));
+    reader.read(*symbol);
+    return symbol;
+  }
+
+  std::vector<T>    symbols; ///< All symbols, sorted by name, unless they're in data
+  std::vector<Slot> slots;   ///< Open-addressing table from SymbolID to position, with linear probing
+  size_t            mask = 0;
+
+  std::shared_ptr<llvm::MemoryBuffer> data;    ///< Encoded symbols, if they're read from a file
+  std::vector<uint64_t>               offsets; ///< Offset of each symbol in data, sorted by name
+};
+
+/// @brief Read-only version of hdoc's Index, which is what is used to write the documentation
+struct FrozenIndex {
+  FrozenIndex() = default;
+  /// @brief Freeze an Index, which should be moved in to avoid copying all of its symbols
+  explicit FrozenIndex(Index index)
+      : functions(std::move(index.functions)), records(std::move(index.records)), enums(std::move(index.enums)),
+        namespaces(std::move(index.namespaces)) {}
+
+  FrozenDatabase<hdoc::types::FunctionSymbol>  functions;
+  FrozenDatabase<hdoc::types::RecordSymbol>    records;
+  FrozenDatabase<hdoc::types::EnumSymbol>      enums;
+  FrozenDatabase<hdoc::types::NamespaceSymbol> namespaces;
+};
+} // namespace hdoc::types
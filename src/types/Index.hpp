@@ -3,45 +3,57 @@
 
 #pragma once
 
-#include <atomic>
-#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "types/ClaimTable.hpp"
 #include "types/Symbols.hpp"
 
 namespace hdoc::types {
 /// @brief Stores values for a given type of Symbol
+/// A Database isn't thread-safe. During indexing each thread writes to its own Index, and the Indexes of all of
+/// the threads are merged once every TU has been indexed.
 template <typename T> struct Database {
-  std::atomic<uint32_t>                        numMatches = 0; ///< Number of matches
+  uint32_t                                     numMatches = 0; ///< Number of matches
   std::unordered_map<hdoc::types::SymbolID, T> entries;        ///< Hashmap that stores the entries
 
   /// @brief Reserve a space for the given SymbolID, to be updated later
   T& reserve(const hdoc::types::SymbolID& id) {
-    this->mutex.lock();
-    this->entries.insert(std::make_pair(id, T()));
-    this->mutex.unlock();
-    return this->entries[id];
+    return this->entries.try_emplace(id).first->second;
+  }
+
+  /// @brief Reserve a space for the given SymbolID unless the symbol has already been indexed
+  /// Returns false if the symbol is already in this Database, or if claims isn't null and another thread already
+  /// claimed the symbol, in which case the caller should skip the symbol.
+  bool tryReserve(const hdoc::types::SymbolID& id, hdoc::types::ClaimTable* claims) {
+    if (this->contains(id) || (claims != nullptr && !claims->tryClaim(id))) {
+      return false;
+    }
+    this->entries.try_emplace(id);
+    return true;
   }
 
   /// @brief Update the entry for a given SymbolID
   void update(const hdoc::types::SymbolID& id, const T& symbol) {
-    this->mutex.lock();
     this->entries[id] = symbol;
-    this->mutex.unlock();
   }
 
   /// @brief Check if the Database contains a key
   bool contains(const hdoc::types::SymbolID& id) const {
-    this->mutex.lock();
-    bool res = !(this->entries.find(id) == this->entries.end());
-    this->mutex.unlock();
-    return res;
+    return this->entries.find(id) != this->entries.end();
   }
 
-  /// Locks the database during operations that may cause mutations
-  mutable std::mutex mutex;
+  /// @brief Move all entries of another Database into this one
+  /// Entries that already exist in this Database are kept, matching the behaviour of the matchers
+  /// where the first TU to index a symbol wins.
+  void merge(Database<T>& other) {
+    for (auto& [k, v] : other.entries) {
+      this->entries.try_emplace(k, std::move(v));
+    }
+    this->numMatches += other.numMatches;
+    other.entries.clear();
+  }
 };
 
 /// @brief hdoc's index, aggregating information for all of the symbols in a codebase
@@ -50,5 +62,18 @@ struct Index {
   Database<hdoc::types::RecordSymbol>    records;
   Database<hdoc::types::EnumSymbol>      enums;
   Database<hdoc::types::NamespaceSymbol> namespaces;
+
+  uint64_t numIDLookups   = 0; ///< Number of times a SymbolID was needed while indexing
+  uint64_t numIDCacheHits = 0; ///< Number of those SymbolIDs that had already been built earlier in the same TU
+
+  /// @brief Move all symbols of another Index into this one, keeping existing entries
+  void merge(Index& other) {
+    this->functions.merge(other.functions);
+    this->records.merge(other.records);
+    this->enums.merge(other.enums);
+    this->namespaces.merge(other.namespaces);
+    this->numIDLookups += other.numIDLookups;
+    this->numIDCacheHits += other.numIDCacheHits;
+  }
 };
 } // namespace hdoc::types
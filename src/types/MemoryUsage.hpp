@@ -0,0 +1,139 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types/Index.hpp"
+#include "types/Symbols.hpp"
+
+namespace hdoc::types {
+/// @brief Heap memory used by a Database, in bytes, split by the kind of allocation that holds it
+struct MemoryUsage {
+  uint64_t strings = 0; ///< Characters of strings that don't fit in the string itself
+  uint64_t vectors = 0; ///< Backing arrays of vectors, including unused capacity
+  uint64_t maps    = 0; ///< Buckets and nodes of hash maps, including the symbols stored in the nodes
+
+  uint64_t total() const {
+    return this->strings + this->vectors + this->maps;
+  }
+
+  MemoryUsage& operator+=(const MemoryUsage& rhs) {
+    this->strings += rhs.strings;
+    this->vectors += rhs.vectors;
+    this->maps += rhs.maps;
+    return *this;
+  }
+};
+
+namespace detail {
+inline void addHeapBytes(MemoryUsage& usage, const std::string& s) {
+  // Short strings are stored inside the string object, in which case nothing was allocated
+  const char* begin = reinterpret_cast<const char*>(&s);
+  if (s.data() < begin || s.data() >= begin + sizeof(s)) {
+    usage.strings += s.capacity() + 1;
+  }
+}
+
+// Interned strings are owned by the StringPool, which reports its memory separately
+inline void addHeapBytes(MemoryUsage&, const InternedString&) {}
+inline void addHeapBytes(MemoryUsage&, const SymbolID&) {}
+
+inline void addHeapBytes(MemoryUsage& usage, const TypeRef& ref) {
+  addHeapBytes(usage, ref.name);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const TemplateParam& p) {
+  addHeapBytes(usage, p.name);
+  addHeapBytes(usage, p.type);
+  addHeapBytes(usage, p.docComment);
+  addHeapBytes(usage, p.defaultValue);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const MemberVariable& v) {
+  addHeapBytes(usage, v.name);
+  addHeapBytes(usage, v.type);
+  addHeapBytes(usage, v.defaultValue);
+  addHeapBytes(usage, v.docComment);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const RecordSymbol::BaseRecord& b) {
+  addHeapBytes(usage, b.name);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const FunctionParam& p) {
+  addHeapBytes(usage, p.name);
+  addHeapBytes(usage, p.type);
+  addHeapBytes(usage, p.docComment);
+  addHeapBytes(usage, p.defaultValue);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const EnumMember& m) {
+  addHeapBytes(usage, m.name);
+  addHeapBytes(usage, m.docComment);
+}
+
+template <typename T> void addHeapBytes(MemoryUsage& usage, const std::vector<T>& vec) {
+  usage.vectors += vec.capacity() * sizeof(T);
+  for (const auto& elem : vec) {
+    addHeapBytes(usage, elem);
+  }
+}
+
+inline void addSymbolHeapBytes(MemoryUsage& usage, const Symbol& s) {
+  addHeapBytes(usage, s.name);
+  addHeapBytes(usage, s.briefComment);
+  addHeapBytes(usage, s.docComment);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const FunctionSymbol& f) {
+  addSymbolHeapBytes(usage, f);
+  addHeapBytes(usage, f.proto);
+  addHeapBytes(usage, f.returnType);
+  addHeapBytes(usage, f.returnTypeDocComment);
+  addHeapBytes(usage, f.params);
+  addHeapBytes(usage, f.templateParams);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const RecordSymbol& c) {
+  addSymbolHeapBytes(usage, c);
+  addHeapBytes(usage, c.type);
+  addHeapBytes(usage, c.proto);
+  addHeapBytes(usage, c.vars);
+  addHeapBytes(usage, c.methodIDs);
+  addHeapBytes(usage, c.baseRecords);
+  addHeapBytes(usage, c.templateParams);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const EnumSymbol& e) {
+  addSymbolHeapBytes(usage, e);
+  addHeapBytes(usage, e.type);
+  addHeapBytes(usage, e.members);
+}
+
+inline void addHeapBytes(MemoryUsage& usage, const NamespaceSymbol& ns) {
+  addSymbolHeapBytes(usage, ns);
+  addHeapBytes(usage, ns.records);
+  addHeapBytes(usage, ns.namespaces);
+  addHeapBytes(usage, ns.enums);
+}
+} // namespace detail
+
+/// @brief Count the heap memory used by a Database by walking every symbol in it.
+/// The size of a hash map node is estimated from the node layout of libstdc++ and libc++, which store a pointer to
+/// the next node and the cached hash next to the entry.
+template <typename T> MemoryUsage memoryUsage(const Database<T>& db) {
+  using Entry = typename decltype(db.entries)::value_type;
+
+  MemoryUsage usage;
+  usage.maps = db.entries.bucket_count() * sizeof(void*) +
+               db.entries.size() * (sizeof(void*) + sizeof(size_t) + sizeof(Entry));
+  for (const auto& [id, symbol] : db.entries) {
+    detail::addHeapBytes(usage, symbol);
+  }
+  return usage;
+}
+} // namespace hdoc::types
@@ -0,0 +1,136 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/xxhash.h"
+
+namespace hdoc::types {
+/// @brief Process-wide pool of immutable strings, where each distinct string is only stored once.
+///
+/// Strings such as file paths and the names of common types are repeated in hundreds of thousands of symbols.
+/// Interning them means that each symbol only holds a reference to the single copy in the pool. The copies live
+/// in bump-allocated arenas that are never freed, so references to them stay valid until the process exits.
+/// The pool is split into shards, each with its own lock, so that threads interning different strings rarely
+/// contend with each other.
+class StringPool {
+public:
+  /// @brief The pool that every InternedString is stored in
+  static StringPool& global() {
+    static StringPool pool;
+    return pool;
+  }
+
+  /// @brief Get the pooled copy of a string, adding it to the pool if it isn't already there
+  llvm::StringRef intern(const llvm::StringRef str) {
+    this->numInterned++;
+    this->bytesInterned += str.size();
+    if (str.size() > ssoCapacity()) {
+      this->bytesOnHeap += str.size() + 1;
+    }
+    Shard&                      shard = this->shards[llvm::xxHash64(str) % numShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto [it, inserted] = shard.strings.insert(str);
+    if (inserted) {
+      this->numUnique++;
+      this->bytesUnique += str.size();
+    }
+    return it->getKey();
+  }
+
+  /// @brief Approximate number of bytes saved by interning, compared to storing every string in a std::string.
+  /// Negative if the pool takes more memory than the std::strings would have, i.e. when few strings are repeated.
+  int64_t bytesSaved() const {
+    // Every reference used to be a std::string with its own heap copy of long strings, and is now a StringRef to the
+    // pooled copy, which also takes an entry and a bucket in its shard
+    constexpr uint64_t bytesPerEntry = sizeof(Entry) + 1 + sizeof(Entry*) + sizeof(uint32_t);
+    const uint64_t     before        = this->numInterned * sizeof(std::string) + this->bytesOnHeap;
+    const uint64_t     after =
+        this->numInterned * sizeof(llvm::StringRef) + this->bytesUnique + this->numUnique * bytesPerEntry;
+    return static_cast<int64_t>(before) - static_cast<int64_t>(after);
+  }
+
+  std::atomic<uint64_t> numInterned   = 0; ///< Number of strings that were interned
+  std::atomic<uint64_t> numUnique     = 0; ///< Number of distinct strings in the pool
+  std::atomic<uint64_t> bytesInterned = 0; ///< Total size of all interned strings
+  std::atomic<uint64_t> bytesUnique   = 0; ///< Total size of the distinct strings in the pool
+  std::atomic<uint64_t> bytesOnHeap   = 0; ///< Heap memory the interned strings would take in std::strings
+
+private:
+  static constexpr size_t numShards = 64;
+
+  using Entry = llvm::StringMapEntry<llvm::NoneType>;
+
+  /// @brief Length of the longest string that std::string stores inline instead of on the heap
+  static size_t ssoCapacity() {
+    static const size_t capacity = std::string().capacity();
+    return capacity;
+  }
+
+  /// Entries of a StringSet are allocated in its allocator along with their keys, and never move once inserted
+  struct alignas(64) Shard {
+    std::mutex                              mutex;
+    llvm::StringSet<llvm::BumpPtrAllocator> strings;
+  };
+  std::array<Shard, numShards> shards;
+};
+
+/// @brief An immutable string that is stored in the global StringPool.
+/// Copying an InternedString only copies a reference, and two InternedStrings are equal if they refer to the
+/// same pooled string. It converts implicitly to std::string_view, and str() returns a std::string copy.
+class InternedString {
+public:
+  InternedString() = default;
+  InternedString(const llvm::StringRef str) {
+    if (!str.empty()) {
+      this->ref = StringPool::global().intern(str);
+    }
+  }
+  InternedString(const std::string& str) : InternedString(llvm::StringRef(str)) {}
+  InternedString(const std::string_view str) : InternedString(llvm::StringRef(str.data(), str.size())) {}
+  InternedString(const char* str) : InternedString(llvm::StringRef(str)) {}
+
+  operator std::string_view() const {
+    return std::string_view(this->ref.data(), this->ref.size());
+  }
+  std::string str() const {
+    return this->ref.str();
+  }
+  const char* data() const {
+    return this->ref.empty() ? "" : this->ref.data();
+  }
+  size_t size() const {
+    return this->ref.size();
+  }
+  bool empty() const {
+    return this->ref.empty();
+  }
+
+  /// Pooled strings are unique, so comparing their addresses is enough
+  bool operator==(const InternedString& rhs) const {
+    return this->ref.data() == rhs.ref.data();
+  }
+  bool operator==(const std::string& rhs) const {
+    return std::string_view(*this) == rhs;
+  }
+  bool operator==(const std::string_view rhs) const {
+    return std::string_view(*this) == rhs;
+  }
+  bool operator==(const char* rhs) const {
+    return std::string_view(*this) == rhs;
+  }
+
+private:
+  llvm::StringRef ref; ///< Reference to the pooled copy of the string, empty strings aren't pooled
+};
+
+} // namespace hdoc::types
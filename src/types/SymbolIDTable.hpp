@@ -0,0 +1,60 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "types/Symbols.hpp"
+
+namespace hdoc::types {
+/// @brief Process-wide map from every SymbolID to the USR it was built from, used to detect hash collisions.
+///
+/// SymbolIDs are 64-bit hashes of USRs, so two different symbols can end up with the same SymbolID, in which case
+/// whichever is indexed first silently wins. Keeping the USR of every SymbolID makes these collisions visible,
+/// at the cost of storing every USR. The map is split into shards in the same way as ClaimTable.
+class SymbolIDTable {
+public:
+  /// @brief Record the USR that a SymbolID was built from.
+  /// Returns false if the SymbolID was already built from a different USR, which is copied to otherUSR.
+  bool check(const hdoc::types::SymbolID& id, llvm::StringRef usr, std::string& otherUSR) {
+    Shard&                      shard = this->shards[id.raw() % numShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto                  it    = shard.usrs.find(id);
+    if (it == shard.usrs.end()) {
+      shard.usrs.emplace(id, usr.str());
+      return true;
+    }
+    if (it->second == usr) {
+      return true;
+    }
+    otherUSR = it->second;
+    this->numCollisions++;
+    return false;
+  }
+
+  /// @brief Number of SymbolIDs in the table, which must not be called while other threads are checking SymbolIDs
+  size_t size() const {
+    size_t size = 0;
+    for (const auto& shard : this->shards) {
+      size += shard.usrs.size();
+    }
+    return size;
+  }
+
+  std::atomic<uint32_t> numCollisions = 0; ///< Number of times a SymbolID was built from a second USR
+
+private:
+  static constexpr size_t numShards = 64;
+
+  struct alignas(64) Shard {
+    std::mutex                                             mutex;
+    std::unordered_map<hdoc::types::SymbolID, std::string> usrs;
+  };
+  std::array<Shard, numShards> shards;
+};
+} // namespace hdoc::types
@@ -3,11 +3,14 @@
 
 #pragma once
 
+#include "types/StringPool.hpp"
+
 #include "clang/AST/Type.h"
 #include "clang/Basic/Specifiers.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/xxhash.h"
 
 #include <string>
 #include <vector>
@@ -17,17 +20,40 @@ namespace hdoc::types {
 struct SymbolID {
   SymbolID() = default;
 
-  /// @brief Constructs a SymbolID from a USR value by SHA1 hashing it
+  /// @brief Constructs a SymbolID from a USR value by hashing it with the hash function selected at build time
   SymbolID(llvm::StringRef USR) {
-    const auto& hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(USR));
-    this->hashValue |= static_cast<uint64_t>(hash[0]) << 56;
-    this->hashValue |= static_cast<uint64_t>(hash[1]) << 48;
-    this->hashValue |= static_cast<uint64_t>(hash[2]) << 40;
-    this->hashValue |= static_cast<uint64_t>(hash[3]) << 32;
-    this->hashValue |= static_cast<uint64_t>(hash[4]) << 24;
-    this->hashValue |= static_cast<uint64_t>(hash[5]) << 16;
-    this->hashValue |= static_cast<uint64_t>(hash[6]) << 8;
-    this->hashValue |= static_cast<uint64_t>(hash[7]);
+#ifdef HDOC_SYMBOL_ID_XXHASH
+    this->hashValue = hashXXH64(USR);
+#else
+    this->hashValue = hashSHA1(USR);
+#endif
+  }
+
+  /// @brief Name of the hash function that is used to build SymbolIDs from USRs
+#ifdef HDOC_SYMBOL_ID_XXHASH
+  static constexpr const char* hashName = "xxhash64";
+#else
+  static constexpr const char* hashName = "sha1";
+#endif
+
+  /// @brief Hash a USR with SHA1, keeping the first 64 bits of the digest
+  static uint64_t hashSHA1(llvm::StringRef USR) {
+    const auto& hash  = llvm::SHA1::hash(llvm::arrayRefFromStringRef(USR));
+    uint64_t    value = 0;
+    value |= static_cast<uint64_t>(hash[0]) << 56;
+    value |= static_cast<uint64_t>(hash[1]) << 48;
+    value |= static_cast<uint64_t>(hash[2]) << 40;
+    value |= static_cast<uint64_t>(hash[3]) << 32;
+    value |= static_cast<uint64_t>(hash[4]) << 24;
+    value |= static_cast<uint64_t>(hash[5]) << 16;
+    value |= static_cast<uint64_t>(hash[6]) << 8;
+    value |= static_cast<uint64_t>(hash[7]);
+    return value;
+  }
+
+  /// @brief Hash a USR with xxHash64, which is much faster than SHA1 but isn't a cryptographic hash
+  static uint64_t hashXXH64(llvm::StringRef USR) {
+    return llvm::xxHash64(USR);
   }
 
   SymbolID(const uint64_t hashValue) {
@@ -61,7 +87,7 @@ struct Symbol {
   std::string           briefComment;      ///< Text following @brief or \brief command
   std::string           docComment;        ///< All other Doxygen text attached to this symbol's documentation
   hdoc::types::SymbolID ID;                ///< Unique identifier for this Symbol
-  std::string           file;              ///< File where this Symbol is declared, relative to source root
+  InternedString        file;              ///< File where this Symbol is declared, relative to source root
   std::uint64_t         line;              ///< Line number in the file
   hdoc::types::SymbolID parentNamespaceID; ///< ID of the parent namespace (or record)
 
@@ -77,7 +103,7 @@ struct Symbol {
 /// Used to represent cross-links to function parameters, return types, or record member variables.
 struct TypeRef {
   hdoc::types::SymbolID id;   ///< Possible SymbolID of this type.
-  std::string           name; ///< Name of the type
+  InternedString        name; ///< Name of the type, interned since the same types are referenced everywhere
 };
 
 /// @brief Represents a function parameter
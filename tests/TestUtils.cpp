@@ -3,27 +3,52 @@
 
 #include "tests/TestUtils.hpp"
 
-#include "clang/ASTMatchers/ASTMatchFinder.h"
-#include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
 
-#include "indexer/Matchers.hpp"
+#include "indexer/IndexAction.hpp"
+#include "serde/BinarySerde.hpp"
 #include "types/Symbols.hpp"
 
+#include <fstream>
+
+/// Check that two databases contain exactly the same symbols, by comparing their serialized forms
+template <typename T>
+static void checkSameSymbols(const hdoc::types::Database<T>& db, const hdoc::types::Database<T>& other) {
+  CHECK(db.entries.size() == other.entries.size());
+  for (const auto& [k, v] : db.entries) {
+    const auto it = other.entries.find(k);
+    REQUIRE(it != other.entries.end());
+
+    std::string               expected;
+    std::string               actual;
+    hdoc::serde::BinaryWriter expectedWriter(expected);
+    hdoc::serde::BinaryWriter actualWriter(actual);
+    expectedWriter.write(v);
+    actualWriter.write(it->second);
+    CHECK(expected == actual);
+  }
+}
+
 void runOverCode(const std::string_view code, hdoc::types::Index& index, const hdoc::types::Config cfg) {
-  clang::ast_matchers::MatchFinder          Finder;
-  hdoc::indexer::matchers::FunctionMatcher  FunctionFinder(&index, &cfg);
-  hdoc::indexer::matchers::RecordMatcher    RecordFinder(&index, &cfg);
-  hdoc::indexer::matchers::EnumMatcher      EnumFinder(&index, &cfg);
-  hdoc::indexer::matchers::NamespaceMatcher NamespaceFinder(&index, &cfg);
-
-  Finder.addMatcher(FunctionFinder.getMatcher(), &FunctionFinder);
-  Finder.addMatcher(RecordFinder.getMatcher(), &RecordFinder);
-  Finder.addMatcher(EnumFinder.getMatcher(), &EnumFinder);
-  Finder.addMatcher(NamespaceFinder.getMatcher(), &NamespaceFinder);
-
-  std::unique_ptr<clang::tooling::FrontendActionFactory> Factory(clang::tooling::newFrontendActionFactory(&Finder));
-  clang::tooling::runToolOnCode(Factory->create(), code);
+  clang::tooling::runToolOnCode(std::make_unique<hdoc::indexer::IndexAction>(&index, &cfg), code);
+
+  // Both indexing engines must produce the same Index, so every test also runs the other engine and compares
+  hdoc::types::Config otherCfg = cfg;
+  otherCfg.engine              = cfg.engine == hdoc::types::IndexingEngine::Matchers
+                                     ? hdoc::types::IndexingEngine::Visitor
+                                     : hdoc::types::IndexingEngine::Matchers;
+  hdoc::types::Index otherIndex;
+  clang::tooling::runToolOnCode(std::make_unique<hdoc::indexer::IndexAction>(&otherIndex, &otherCfg), code);
+
+  checkSameIndex(index, otherIndex);
+}
+
+void checkSameIndex(const hdoc::types::Index& index, const hdoc::types::Index& other) {
+  checkSameSymbols(index.functions, other.functions);
+  checkSameSymbols(index.records, other.records);
+  checkSameSymbols(index.enums, other.enums);
+  checkSameSymbols(index.namespaces, other.namespaces);
 }
 
 void checkIndexSizes(const hdoc::types::Index& index,
@@ -36,3 +61,23 @@ void checkIndexSizes(const hdoc::types::Index& index,
   CHECK(index.enums.entries.size() == enumsSize);
   CHECK(index.namespaces.entries.size() == namespacesSize);
 }
+
+TempProject::TempProject(const std::vector<std::pair<std::string, std::string>>& files) {
+  llvm::SmallString<128> tmpDir;
+  REQUIRE(!llvm::sys::fs::createUniqueDirectory("hdoc-test", tmpDir));
+  this->dir = std::filesystem::canonical(tmpDir.str().str());
+  for (const auto& [relPath, contents] : files) {
+    this->write(relPath, contents);
+  }
+}
+
+TempProject::~TempProject() {
+  std::error_code ec;
+  std::filesystem::remove_all(this->dir, ec);
+}
+
+void TempProject::write(const std::filesystem::path& relPath, const std::string& contents) const {
+  const std::filesystem::path path = this->path(relPath);
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path) << contents;
+}
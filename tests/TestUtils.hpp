@@ -7,13 +7,22 @@
 #include "types/Config.hpp"
 #include "types/Index.hpp"
 
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 void runOverCode(const std::string_view    code,
                  hdoc::types::Index&       index,
                  const hdoc::types::Config cfg = hdoc::types::Config());
 
+/// Check that two Indexes contain exactly the same symbols
+void checkSameIndex(const hdoc::types::Index& index, const hdoc::types::Index& other);
+
 void checkIndexSizes(const hdoc::types::Index& index,
                      const uint32_t            recordsSize,
                      const uint32_t            functionsSize,
@@ -31,3 +40,31 @@ template <typename T> std::optional<const T> findByName(const hdoc::types::Datab
   }
   return std::nullopt;
 }
+
+/// A temporary directory of files for tests that need a project on disk.
+/// The directory is removed when the TempProject goes out of scope, so it isn't leaked when an assertion fails.
+class TempProject {
+public:
+  /// Create the directory with the given files, as paths relative to the directory and their contents
+  explicit TempProject(const std::vector<std::pair<std::string, std::string>>& files = {});
+  ~TempProject();
+
+  TempProject(const TempProject&)            = delete;
+  TempProject& operator=(const TempProject&) = delete;
+
+  /// Write a file, given as a path relative to the directory, creating its parent directories
+  void write(const std::filesystem::path& relPath, const std::string& contents) const;
+
+  /// Get the absolute path of a file, given as a path relative to the directory
+  std::filesystem::path path(const std::filesystem::path& relPath) const {
+    return this->dir / relPath;
+  }
+
+  /// Get a compilation database that compiles every file in the directory with the given flags
+  std::unique_ptr<clang::tooling::FixedCompilationDatabase>
+  cmpdb(const std::vector<std::string>& flags = {"-std=c++20"}) const {
+    return std::make_unique<clang::tooling::FixedCompilationDatabase>(this->dir.string(), flags);
+  }
+
+  std::filesystem::path dir; ///< Absolute path of the directory, with symlinks resolved
+};
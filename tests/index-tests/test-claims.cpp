@@ -0,0 +1,189 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "tests/TestUtils.hpp"
+
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "indexer/IndexAction.hpp"
+#include "indexer/TUContext.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Index the given TUs of the project, in order, optionally with file claims enabled
+static void runOverTUs(hdoc::types::Index&             index,
+                       const TempProject&              project,
+                       const std::vector<std::string>& tus,
+                       hdoc::indexer::FileClaims*      claims) {
+  std::vector<std::string> paths;
+  for (const auto& tu : tus) {
+    paths.emplace_back(project.path(tu).string());
+  }
+
+  const hdoc::types::Config         cfg;
+  const auto                        cmpdb = project.cmpdb();
+  clang::tooling::ClangTool         tool(*cmpdb, paths);
+  hdoc::indexer::IndexActionFactory factory(&index, &cfg, claims);
+  CHECK(tool.run(&factory) == 0);
+}
+
+/// Two TUs that include the same header
+static std::vector<std::pair<std::string, std::string>> tusSharingHeader() {
+  return {
+      {"shared.hpp", R"(
+        #pragma once
+        namespace ns {
+          struct Shared {
+            void method();
+          };
+        }
+      )"},
+      {"a.cpp", R"(
+        #include "shared.hpp"
+        void a();
+      )"},
+      {"b.cpp", R"(
+        #include "shared.hpp"
+        struct B {};
+      )"},
+  };
+}
+
+TEST_CASE("Header included by multiple TUs is only indexed by the TU that claims it") {
+  const TempProject         project(tusSharingHeader());
+  hdoc::types::Index        index;
+  hdoc::indexer::FileClaims claims;
+  runOverTUs(index, project, {"a.cpp", "b.cpp"}, &claims);
+  checkIndexSizes(index, 2, 2, 0, 1);
+
+  // a.cpp, b.cpp, and shared.hpp are claimed, and b.cpp skips shared.hpp because a.cpp claimed it first
+  CHECK(claims.numClaims == 3);
+  CHECK(claims.numConflicts == 1);
+  CHECK(findByName(index.records, "Shared").has_value());
+  CHECK(findByName(index.records, "B").has_value());
+  CHECK(findByName(index.functions, "method").has_value());
+  CHECK(findByName(index.functions, "a").has_value());
+  CHECK(findByName(index.namespaces, "ns").has_value());
+}
+
+TEST_CASE("File claims don't change the contents of the index") {
+  const TempProject         project(tusSharingHeader());
+  hdoc::types::Index        claimedIndex;
+  hdoc::indexer::FileClaims claims;
+  runOverTUs(claimedIndex, project, {"a.cpp", "b.cpp"}, &claims);
+
+  hdoc::types::Index index;
+  runOverTUs(index, project, {"a.cpp", "b.cpp"}, nullptr);
+
+  checkSameIndex(index, claimedIndex);
+  CHECK(claimedIndex.functions.numMatches < index.functions.numMatches);
+}
+
+TEST_CASE("Out-of-line definitions aren't indexed in place of declarations in headers claimed by another TU") {
+  const TempProject project({
+      {"foo.hpp", R"(
+        #pragma once
+        void foo(int x = 3);
+        struct Base {
+          virtual void method();
+        };
+      )"},
+      {"foo.cpp", R"(
+        #include "foo.hpp"
+        void foo(int x) {}
+        void Base::method() {}
+      )"},
+      {"main.cpp", R"(
+        #include "foo.hpp"
+      )"},
+  });
+
+  hdoc::types::Index index;
+  runOverTUs(index, project, {"main.cpp", "foo.cpp"}, nullptr);
+
+  // main.cpp claims the header but is slow, so foo.cpp is done indexing before main.cpp gets to the header
+  hdoc::types::Index        claimedIndex;
+  hdoc::indexer::FileClaims claims;
+  llvm::sys::fs::UniqueID   header;
+  REQUIRE(!llvm::sys::fs::getUniqueID(project.path("foo.hpp").string(), header));
+  REQUIRE(claims.tryClaim(header, claims.newClaimant()));
+  runOverTUs(claimedIndex, project, {"foo.cpp"}, &claims);
+  runOverTUs(claimedIndex, project, {"main.cpp"}, nullptr);
+
+  checkSameIndex(index, claimedIndex);
+  const auto foo = findByName(claimedIndex.functions, "foo");
+  REQUIRE(foo.has_value());
+  REQUIRE(foo->params.size() == 1);
+  CHECK(foo->params[0].defaultValue == "3");
+  const auto method = findByName(claimedIndex.functions, "method");
+  REQUIRE(method.has_value());
+  CHECK(method->isVirtual);
+}
+
+TEST_CASE("Types forward declared in a header claimed by a TU that can't see their definition are indexed") {
+  const TempProject project({
+      {"fwd.h", R"(
+        #pragma once
+        struct S;
+        template <typename T> struct Box;
+        void useS(S* s);
+      )"},
+      {"s.hpp", R"(
+        #pragma once
+        #include "fwd.h"
+        struct S {
+          int x;
+        };
+        template <typename T> struct Box {
+          T value;
+        };
+      )"},
+      {"a.cpp", R"(
+        #include "fwd.h"
+      )"},
+      {"b.cpp", R"(
+        #include "s.hpp"
+      )"},
+  });
+
+  hdoc::types::Index index;
+  runOverTUs(index, project, {"a.cpp", "b.cpp"}, nullptr);
+
+  // a.cpp claims fwd.h, but only b.cpp sees the definitions of the types declared in it
+  hdoc::types::Index        claimedIndex;
+  hdoc::indexer::FileClaims claims;
+  runOverTUs(claimedIndex, project, {"a.cpp", "b.cpp"}, &claims);
+
+  checkSameIndex(index, claimedIndex);
+  CHECK(findByName(claimedIndex.records, "S").has_value());
+  CHECK(findByName(claimedIndex.records, "Box").has_value());
+  CHECK(findByName(claimedIndex.functions, "useS").has_value());
+}
+
+TEST_CASE("A symbol is only reserved by the first Index to claim it") {
+  hdoc::types::ClaimTable                        claims;
+  hdoc::types::Database<hdoc::types::EnumSymbol> a;
+  hdoc::types::Database<hdoc::types::EnumSymbol> b;
+  const hdoc::types::SymbolID                    id("c:@E@Color");
+
+  CHECK(a.tryReserve(id, &claims) == true);
+  CHECK(b.tryReserve(id, &claims) == false);
+  // A second attempt by the same Index is caught before the ClaimTable is consulted
+  CHECK(a.tryReserve(id, &claims) == false);
+  CHECK(a.contains(id));
+  CHECK(!b.contains(id));
+  CHECK(claims.numWon == 1);
+  CHECK(claims.numLost == 1);
+
+  // Once released, the next Index to claim the symbol wins
+  claims.release(id);
+  CHECK(claims.numWon == 0);
+  CHECK(b.tryReserve(id, &claims) == true);
+
+  // Without a ClaimTable, symbols are only deduplicated within each Index
+  hdoc::types::Database<hdoc::types::EnumSymbol> c;
+  CHECK(c.tryReserve(id, nullptr) == true);
+}
@@ -0,0 +1,34 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "tests/TestUtils.hpp"
+
+#include "clang/Tooling/ArgumentsAdjusters.h"
+
+#include "support/CoveringTUs.hpp"
+
+#include <string>
+#include <vector>
+
+TEST_CASE("Only the TUs needed to include every project header are selected") {
+  const TempProject project({
+      {"x.hpp", "#pragma once\nstruct X {};\n"},
+      {"y.hpp", "#pragma once\nstruct Y {};\n"},
+      {"a.cpp", "#include \"x.hpp\"\n"},
+      {"b.cpp", "#include \"x.hpp\"\n#include \"y.hpp\"\n"},
+      {"c.cpp", "#include \"y.hpp\"\n"},
+  });
+
+  hdoc::types::Config cfg;
+  cfg.rootDir = project.dir;
+
+  const std::vector<std::string> files = {
+      project.path("a.cpp").string(), project.path("b.cpp").string(), project.path("c.cpp").string()};
+  const auto       cmpdb = project.cmpdb();
+  llvm::ThreadPool pool(llvm::hardware_concurrency(2));
+
+  // b.cpp includes both headers, so it's the only TU that's needed
+  const std::vector<std::string> selected =
+      hdoc::indexer::selectCoveringTUs(*cmpdb, files, clang::tooling::getClangSyntaxOnlyAdjuster(), &cfg, pool);
+  CHECK(selected == std::vector<std::string>{files[1]});
+}
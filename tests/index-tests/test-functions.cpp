@@ -3,6 +3,10 @@
 
 #include "tests/TestUtils.hpp"
 
+#include "clang/Tooling/Tooling.h"
+
+#include "indexer/IndexAction.hpp"
+
 TEST_CASE("Function with struct as a parameter") {
   const std::string code = R"(
     struct Foo;
@@ -758,6 +762,44 @@ TEST_CASE("Const member function with trailing return type, noexcept, and const
   CHECK(f.templateParams.size() == 0);
 }
 
+TEST_CASE("Skipping function bodies keeps declarations, default arguments, and deduced return types") {
+  const std::string code = R"(
+    template <typename T> struct Broken { static_assert(sizeof(T) == 0, "foo's body was parsed"); };
+
+    void foo(int a = 0, int b = 100) {
+      Broken<double> unused{};
+    }
+    constexpr int square(int n) { return n * n; }
+    auto twice(int n) { return 2 * n; }
+  )";
+
+  hdoc::types::Config cfg;
+  cfg.skipFunctionBodies = true;
+
+  // Instantiating Broken is an error, so the TU only parses cleanly if the body of foo is skipped
+  hdoc::types::Index parsed;
+  CHECK(clang::tooling::runToolOnCode(std::make_unique<hdoc::indexer::IndexAction>(&parsed, &cfg), code));
+
+  hdoc::types::Index index;
+  runOverCode(code, index, cfg);
+  checkIndexSizes(index, 1, 3, 0, 0);
+
+  for (const auto& [id, s] : index.functions.entries) {
+    if (s.name == "foo") {
+      CHECK(s.proto == "void foo(int a = 0, int b = 100)");
+      CHECK(s.params.size() == 2);
+      CHECK(s.params[0].defaultValue == "0");
+      CHECK(s.params[1].defaultValue == "100");
+    } else if (s.name == "square") {
+      CHECK(s.isConstexpr == true);
+      CHECK(s.returnType.name == "int");
+    } else {
+      CHECK(s.name == "twice");
+      CHECK(s.returnType.name == "int");
+    }
+  }
+}
+
 // TODO: fix this once we're on LLVM/Clang 12
 // on clang 9 the function is marked constexpr and not consteval
 // TEST_CASE("Consteval function") {
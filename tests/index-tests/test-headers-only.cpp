@@ -0,0 +1,88 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "tests/TestUtils.hpp"
+
+#include "clang/Tooling/Tooling.h"
+
+#include "indexer/IndexAction.hpp"
+#include "support/HeaderCompilationDatabase.hpp"
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Create a small project with two public headers, an ignored header, and a source file
+static std::vector<std::pair<std::string, std::string>> projectFiles() {
+  return {
+      {"include/a.hpp", R"(
+        #pragma once
+        struct A {
+          void method();
+        };
+      )"},
+      {"include/b.hpp", R"(
+        #pragma once
+        #include "a.hpp"
+        struct B : A {};
+      )"},
+      {"include/detail/impl.hpp", R"(
+        #pragma once
+        struct Impl {};
+      )"},
+      {"src/a.cpp", R"(
+        #include "a.hpp"
+        void A::method() {}
+        void onlyInSource() {}
+      )"},
+  };
+}
+
+TEST_CASE("Headers only mode indexes headers instead of source files") {
+  const TempProject project(projectFiles());
+
+  hdoc::types::Config cfg;
+  cfg.rootDir             = project.dir;
+  cfg.compileCommandsJSON = project.path("build/compile_commands.json");
+  cfg.ignorePaths         = {"detail/"};
+  cfg.headersOnly         = true;
+
+  const std::string                        includeFlag = "-I" + project.path("include").string();
+  hdoc::indexer::HeaderCompilationDatabase headerdb(project.cmpdb({"-std=c++20", includeFlag}), &cfg);
+
+  // Both public headers are in the same directory, so they're included by the same TU
+  const std::vector<std::string> files = headerdb.getAllFiles();
+  REQUIRE(files.size() == 1);
+
+  hdoc::types::Index                index;
+  clang::tooling::ClangTool         tool(headerdb, files);
+  hdoc::indexer::IndexActionFactory factory(&index, &cfg);
+  CHECK(tool.run(&factory) == 0);
+
+  checkIndexSizes(index, 2, 1, 0, 0);
+  CHECK(findByName(index.records, "A").has_value());
+  CHECK(findByName(index.records, "B").has_value());
+  CHECK(findByName(index.functions, "method").has_value());
+}
+
+TEST_CASE("Headers only mode splits directories into multiple TUs") {
+  const TempProject project(projectFiles());
+
+  hdoc::types::Config cfg;
+  cfg.rootDir             = project.dir;
+  cfg.compileCommandsJSON = project.path("build/compile_commands.json");
+  cfg.headersOnly         = true;
+  cfg.headersPerTU        = 1;
+
+  hdoc::indexer::HeaderCompilationDatabase headerdb(project.cmpdb({}), &cfg);
+
+  // a.hpp, b.hpp, and detail/impl.hpp each get their own TU
+  CHECK(headerdb.getAllFiles().size() == 3);
+  for (const auto& file : headerdb.getAllFiles()) {
+    const auto cmds = headerdb.getCompileCommands(file);
+    REQUIRE(cmds.size() == 1);
+    CHECK(cmds.front().Filename == file);
+    CHECK(std::filesystem::exists(file));
+  }
+}
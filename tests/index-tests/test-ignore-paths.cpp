@@ -0,0 +1,74 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "tests/TestUtils.hpp"
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "indexer/IndexAction.hpp"
+
+#include <filesystem>
+#include <string>
+
+/// Index a project whose source file includes a public header, an ignored header, and a header outside of rootDir
+static void runOverProject(hdoc::types::Index& index, const hdoc::types::IndexingEngine engine) {
+  const TempProject project({
+      {"project/include/api.hpp", R"(
+        #pragma once
+        struct Api {
+          void method();
+        };
+        void apiFunction();
+      )"},
+      {"project/include/detail/impl.hpp", R"(
+        #pragma once
+        struct Impl {};
+        void implFunction();
+      )"},
+      {"outside.hpp", R"(
+        #pragma once
+        struct Outside {};
+      )"},
+      {"project/main.cpp", R"(
+        #include "api.hpp"
+        #include "detail/impl.hpp"
+        #include "../outside.hpp"
+        void Api::method() {}
+      )"},
+  });
+  const std::filesystem::path rootDir = project.path("project");
+
+  hdoc::types::Config cfg;
+  cfg.rootDir     = rootDir;
+  cfg.ignorePaths = {"detail/"};
+  cfg.engine      = engine;
+
+  const std::string                        includeFlag = "-I" + (rootDir / "include").string();
+  clang::tooling::FixedCompilationDatabase cmpdb(rootDir.string(), {"-std=c++20", includeFlag});
+  clang::tooling::ClangTool                tool(cmpdb, {(rootDir / "main.cpp").string()});
+  hdoc::indexer::IndexActionFactory        factory(&index, &cfg);
+  CHECK(tool.run(&factory) == 0);
+}
+
+TEST_CASE("Decls in ignored paths and outside of rootDir aren't indexed") {
+  for (const auto engine : {hdoc::types::IndexingEngine::Matchers, hdoc::types::IndexingEngine::Visitor}) {
+    hdoc::types::Index index;
+    runOverProject(index, engine);
+    checkIndexSizes(index, 1, 2, 0, 0);
+
+    const auto api = findByName(index.records, "Api");
+    REQUIRE(api.has_value());
+    CHECK(api->file == "include/api.hpp");
+
+    // Every symbol in a file shares the cached path of that file
+    const auto apiFunction = findByName(index.functions, "apiFunction");
+    REQUIRE(apiFunction.has_value());
+    CHECK(apiFunction->file == "include/api.hpp");
+    CHECK(findByName(index.functions, "method").has_value());
+
+    CHECK(!findByName(index.records, "Impl").has_value());
+    CHECK(!findByName(index.functions, "implFunction").has_value());
+    CHECK(!findByName(index.records, "Outside").has_value());
+  }
+}
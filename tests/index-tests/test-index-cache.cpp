@@ -0,0 +1,181 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "tests/TestUtils.hpp"
+
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "indexer/IndexCache.hpp"
+#include "support/ParallelExecutor.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// A project in a temporary directory, with a compile_commands.json that compiles every .cpp file in it
+struct Project {
+  explicit Project(const std::vector<std::pair<std::string, std::string>>& files) : tmp(files) {
+    std::string cmds;
+    for (const auto& [name, contents] : files) {
+      if (std::filesystem::path(name).extension() == ".cpp") {
+        const std::string path = this->tmp.path(name).string();
+        cmds += std::string(cmds.empty() ? "" : ",") + R"({"directory": ")" + this->tmp.dir.string() +
+                R"(", "file": ")" + path + R"(", "arguments": ["clang++", "-std=c++20", "-c", ")" + path + R"("]})";
+      }
+    }
+    this->tmp.write("compile_commands.json", "[" + cmds + "]");
+
+    this->cfg.rootDir                   = this->tmp.dir;
+    this->cfg.compileCommandsJSON       = this->tmp.path("compile_commands.json");
+    this->cfg.cacheDir                  = this->tmp.path(".hdoc-cache");
+    this->cfg.debugLimitNumIndexedFiles = 0;
+  }
+
+  void write(const std::string& name, const std::string& contents) const {
+    this->tmp.write(name, contents);
+  }
+
+  /// Index the project the way hdoc does, returning the number of TUs that were loaded from the cache.
+  /// Clearing cfg.cacheDir disables the cache, and files are claimed by the TUs that index them instead.
+  uint32_t index(hdoc::types::Index& index) const {
+    std::string err;
+    const auto  cmpdb = clang::tooling::JSONCompilationDatabase::loadFromFile(
+        this->cfg.compileCommandsJSON.string(), err, clang::tooling::JSONCommandLineSyntax::AutoDetect);
+    REQUIRE(cmpdb != nullptr);
+
+    const std::vector<std::string>  includePaths;
+    llvm::ThreadPool                pool(llvm::hardware_concurrency(2));
+    hdoc::types::IndexClaims        claims;
+    hdoc::indexer::IndexCache       cache(&this->cfg);
+    hdoc::indexer::ParallelExecutor tool(*cmpdb, includePaths, pool, &this->cfg);
+    REQUIRE(cache.enabled() == !this->cfg.cacheDir.empty());
+    tool.execute(index, cache, claims, nullptr, nullptr);
+    return cache.numHits;
+  }
+
+  TempProject         tmp;
+  hdoc::types::Config cfg;
+};
+
+TEST_CASE("TUs that were parsed with a shared PCH are loaded from the cache on the next run") {
+  Project project({
+      {"shared.hpp", "#pragma once\nnamespace ns { struct Shared { void method(); }; }\n"},
+      {"a.cpp", "#include \"shared.hpp\"\nvoid a();\n"},
+      {"b.cpp", "#include \"shared.hpp\"\nstruct B {};\n"},
+  });
+  project.cfg.sharedPCH = true;
+
+  hdoc::types::Index cold;
+  CHECK(project.index(cold) == 0);
+  checkIndexSizes(cold, 2, 2, 0, 1);
+
+  // The synthetic header that was precompiled is deleted at the end of each run, so TUs mustn't depend on it
+  hdoc::types::Index warm;
+  CHECK(project.index(warm) == 2);
+  checkSameIndex(cold, warm);
+}
+
+/// A project with one TU that includes a header and one that doesn't
+static std::vector<std::pair<std::string, std::string>> twoTUs() {
+  return {
+      {"shared.hpp", "#pragma once\nstruct Shared {\n  int x;\n};\n"},
+      {"a.cpp", "#include \"shared.hpp\"\nvoid a(Shared s);\n"},
+      {"b.cpp", "namespace ns {\nenum class B { One, Two };\n}\n"},
+  };
+}
+
+TEST_CASE("A warm run loads every TU from the cache and produces the same index as a cold run") {
+  Project project(twoTUs());
+
+  hdoc::types::Index cold;
+  CHECK(project.index(cold) == 0);
+  checkIndexSizes(cold, 1, 1, 1, 1);
+
+  hdoc::types::Index warm;
+  CHECK(project.index(warm) == 2);
+  checkSameIndex(cold, warm);
+  CHECK(warm.functions.numMatches == cold.functions.numMatches);
+}
+
+TEST_CASE("A warm run produces the same index as a run without the cache, in which TUs claim the files they index") {
+  Project project({
+      {"api.hpp", "#pragma once\nint compute(int x = 3);\nstruct Widget {\n  virtual void draw();\n};\n"},
+      {"api.cpp", "#include \"api.hpp\"\nint compute(int x) { return x; }\nvoid Widget::draw() {}\n"},
+      {"main.cpp", "#include \"api.hpp\"\nvoid run() { compute(); }\n"},
+  });
+
+  hdoc::types::Index cold;
+  CHECK(project.index(cold) == 0);
+  hdoc::types::Index warm;
+  CHECK(project.index(warm) == 2);
+
+  project.cfg.cacheDir.clear();
+  hdoc::types::Index uncached;
+  CHECK(project.index(uncached) == 0);
+  checkIndexSizes(uncached, 1, 3, 0, 0);
+  checkSameIndex(uncached, warm);
+
+  const auto compute = findByName(warm.functions, "compute");
+  REQUIRE(compute.has_value());
+  REQUIRE(compute->params.size() == 1);
+  CHECK(compute->params[0].defaultValue == "3");
+}
+
+TEST_CASE("Editing an included header invalidates the shards of the TUs that include it") {
+  Project            project(twoTUs());
+  hdoc::types::Index cold;
+  project.index(cold);
+
+  project.write("shared.hpp", "#pragma once\nstruct Shared {\n  int x;\n};\nstruct Added {};\n");
+  hdoc::types::Index warm;
+  CHECK(project.index(warm) == 1);
+  checkIndexSizes(warm, 2, 1, 1, 1);
+  CHECK(findByName(warm.records, "Added").has_value());
+
+  // The shard of a.cpp was regenerated, so the next run is served entirely from the cache
+  hdoc::types::Index next;
+  CHECK(project.index(next) == 2);
+  checkSameIndex(warm, next);
+}
+
+TEST_CASE("Corrupt or truncated shards are regenerated") {
+  Project            project(twoTUs());
+  hdoc::types::Index cold;
+  project.index(cold);
+
+  // Truncate one shard in the middle of its symbols and replace the other with garbage
+  std::vector<std::filesystem::path> shards;
+  for (const auto& entry : std::filesystem::directory_iterator(project.cfg.cacheDir / "shards")) {
+    shards.emplace_back(entry.path());
+  }
+  REQUIRE(shards.size() == 2);
+  std::filesystem::resize_file(shards[0], std::filesystem::file_size(shards[0]) - 8);
+  std::ofstream(shards[1], std::ios::trunc) << "HDOCSHRD garbage";
+
+  hdoc::types::Index warm;
+  CHECK(project.index(warm) == 0);
+  checkSameIndex(cold, warm);
+
+  hdoc::types::Index next;
+  CHECK(project.index(next) == 2);
+  checkSameIndex(cold, next);
+}
+
+TEST_CASE("Changing a config value that affects indexing invalidates every shard") {
+  Project            project(twoTUs());
+  hdoc::types::Index cold;
+  project.index(cold);
+
+  project.cfg.ignorePrivateMembers = true;
+  hdoc::types::Index noPrivateMembers;
+  CHECK(project.index(noPrivateMembers) == 0);
+
+  project.cfg.ignorePaths = hdoc::utils::PathMatcher({"shared.hpp"});
+  hdoc::types::Index ignoredPaths;
+  CHECK(project.index(ignoredPaths) == 0);
+  CHECK(!findByName(ignoredPaths.records, "Shared").has_value());
+}
@@ -255,3 +255,30 @@ TEST_CASE("Checking that private members aren't indexed when they're not wanted"
   CHECK(s.baseRecords.size() == 0);
   CHECK(s.templateParams.size() == 0);
 }
+
+TEST_CASE("SymbolIDs of methods and parents are reused within a TU") {
+  const std::string_view code = R"(
+    namespace ns {
+      struct Foo {
+        void m1();
+        void m2();
+      };
+    }
+  )";
+
+  hdoc::types::Index index;
+  runOverCode(code, index);
+  checkIndexSizes(index, 1, 2, 0, 1);
+
+  // Each method's SymbolID is built once for the record's methodIDs and reused when the method itself is indexed,
+  // and the record's SymbolID is reused as the parent of both methods
+  CHECK(index.numIDCacheHits > 0);
+  CHECK(index.numIDCacheHits < index.numIDLookups);
+
+  const hdoc::types::RecordSymbol s = index.records.entries.begin()->second;
+  REQUIRE(s.methodIDs.size() == 2);
+  for (const auto& id : s.methodIDs) {
+    REQUIRE(index.functions.contains(id));
+    CHECK(index.functions.entries.at(id).parentNamespaceID == s.ID);
+  }
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env bash
+
+# This script compares how long hdoc takes to index each repository in the corpus,
+# and how much memory it uses, with and without the `skip_function_bodies` option.
+# Run clone-corpus-repos.sh and build hdoc before running this script.
+
+set -eu
+
+HDOC=../../../../build/hdoc
+
+# Run hdoc in the current directory and print "<wall clock seconds> <peak RSS in KiB>"
+measure() {
+    if ! /usr/bin/time -f "%e %M" -o time.txt "$HDOC" > /dev/null 2>&1; then
+        rm -f time.txt
+        echo "hdoc failed in $PWD" >&2
+        return 1
+    fi
+    cat time.txt
+    rm -f time.txt
+}
+
+# Enable skip_function_bodies in .hdoc.toml, based on the original in .hdoc.toml.orig.
+# The option is added to the existing [indexing] table if there is one, since TOML doesn't allow a table to be
+# defined twice.
+enable_skip_function_bodies() {
+    awk '
+        /^[[:space:]]*skip_function_bodies[[:space:]]*=/ { next }
+        { print }
+        /^[[:space:]]*\[indexing\][[:space:]]*(#.*)?$/ { print "skip_function_bodies = true"; found = 1 }
+        END { if (!found) { print ""; print "[indexing]"; print "skip_function_bodies = true" } }
+    ' .hdoc.toml.orig > .hdoc.toml
+}
+
+# Put back the original .hdoc.toml of the project being measured, including when hdoc fails and `set -e` exits
+CURRENT_PROJECT=""
+restore_config() {
+    if [ -n "$CURRENT_PROJECT" ] && [ -f "$CURRENT_PROJECT/.hdoc.toml.orig" ]; then
+        mv "$CURRENT_PROJECT/.hdoc.toml.orig" "$CURRENT_PROJECT/.hdoc.toml"
+    fi
+    CURRENT_PROJECT=""
+}
+trap restore_config EXIT
+
+pushd corpus > /dev/null
+
+printf "%-12s %12s %12s %14s %14s\n" "project" "full (s)" "skip (s)" "full RSS (MiB)" "skip RSS (MiB)"
+PROJECT_DIRS=$(ls)
+for DIR in $PROJECT_DIRS; do
+    pushd "$DIR" > /dev/null
+    cp .hdoc.toml .hdoc.toml.orig
+    CURRENT_PROJECT="$PWD"
+
+    # Assigned separately so that a failure of measure stops the script
+    FULL=$(measure)
+    read -r FULL_TIME FULL_RSS <<< "$FULL"
+
+    enable_skip_function_bodies
+    SKIP=$(measure)
+    read -r SKIP_TIME SKIP_RSS <<< "$SKIP"
+
+    restore_config
+    printf "%-12s %12s %12s %14s %14s\n" "$DIR" "$FULL_TIME" "$SKIP_TIME" "$((FULL_RSS / 1024))" "$((SKIP_RSS / 1024))"
+    popd > /dev/null
+done
+popd > /dev/null
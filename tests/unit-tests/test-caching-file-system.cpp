@@ -0,0 +1,80 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/CachingFileSystem.hpp"
+#include "tests/TestUtils.hpp"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <set>
+#include <string>
+
+namespace {
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> makeFS(std::shared_ptr<hdoc::indexer::FileSystemCache> cache,
+                                                       const std::string&                              cwd) {
+  llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS(
+      new hdoc::indexer::CachingFileSystem(std::move(cache), llvm::vfs::createPhysicalFileSystem().release()));
+  REQUIRE(!FS->setCurrentWorkingDirectory(cwd));
+  return FS;
+}
+} // namespace
+
+TEST_CASE("Statuses and files are shared between file systems with different working directories") {
+  const TempProject tree({{"include/a.hpp", "int a();\n"}});
+  const auto        cache       = std::make_shared<hdoc::indexer::FileSystemCache>();
+  auto              fromRoot    = makeFS(cache, tree.dir.string());
+  auto              fromInclude = makeFS(cache, tree.path("include").string());
+
+  // The status carries the path it was requested with, even when it was cached under another path
+  auto status = fromRoot->status("include/a.hpp");
+  REQUIRE(status);
+  CHECK(status->getName() == "include/a.hpp");
+  status = fromInclude->status("a.hpp");
+  REQUIRE(status);
+  CHECK(status->getName() == "a.hpp");
+  CHECK(cache->numStatusMisses == 1);
+  CHECK(cache->numStatusHits == 1);
+
+  // Paths that don't exist are cached too
+  CHECK(!fromRoot->status("missing.hpp"));
+  CHECK(!fromRoot->status("missing.hpp"));
+  CHECK(cache->numStatusMisses == 2);
+
+  auto first = fromRoot->getBufferForFile("include/a.hpp");
+  REQUIRE(first);
+  auto second = fromInclude->getBufferForFile("a.hpp");
+  REQUIRE(second);
+  CHECK((*second)->getBuffer() == "int a();\n");
+  CHECK((*first)->getBufferStart() == (*second)->getBufferStart());
+  CHECK(cache->numBufferMisses == 1);
+  CHECK(cache->numBufferHits == 1);
+  CHECK(cache->bytesCached == 9);
+
+  // Directories can't be opened as files
+  CHECK(!fromRoot->openFileForRead("include"));
+}
+
+TEST_CASE("Directory listings are cached and carry the path they were requested with") {
+  const TempProject tree({{"include/a.hpp", "int a();\n"}});
+  const auto        cache = std::make_shared<hdoc::indexer::FileSystemCache>();
+  auto              FS    = makeFS(cache, tree.dir.string());
+
+  for (int i = 0; i < 2; i++) {
+    std::error_code       ec;
+    std::set<std::string> entries;
+    for (auto it = FS->dir_begin(".", ec), end = llvm::vfs::directory_iterator(); it != end && !ec; it.increment(ec)) {
+      entries.insert(it->path().str());
+      CHECK(it->type() == llvm::sys::fs::file_type::directory_file);
+    }
+    CHECK(!ec);
+    CHECK(entries == std::set<std::string>{llvm::sys::path::convert_to_slash("./include")});
+  }
+  CHECK(cache->numDirectoryMisses == 1);
+  CHECK(cache->numDirectoryHits == 1);
+
+  std::error_code ec;
+  FS->dir_begin("missing", ec);
+  CHECK(ec);
+}
@@ -0,0 +1,80 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/CostReport.hpp"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <filesystem>
+#include <string>
+
+static hdoc::indexer::TUCost makeTU(const std::string& path, const double time) {
+  hdoc::indexer::TUCost cost;
+  cost.path      = path;
+  cost.totalTime = time;
+  return cost;
+}
+
+TEST_CASE("The slowest TUs and most expensive headers are reported first") {
+  hdoc::indexer::TUCost a = makeTU("a.cpp", 10);
+  a.headers["common.hpp"] = 4;
+  a.headers["a.hpp"]      = 5;
+
+  hdoc::indexer::TUCost b = makeTU("b.cpp", 30);
+  b.headers["common.hpp"] = 3;
+
+  hdoc::indexer::CostReport report;
+  report.add(a);
+  report.add(b);
+  report.add(makeTU("c.cpp", 20));
+
+  const auto tus = report.slowestTUs(2);
+  REQUIRE(tus.size() == 2);
+  CHECK(tus[0].path == "b.cpp");
+  CHECK(tus[1].path == "c.cpp");
+  CHECK(report.slowestTUs(10).size() == 3);
+
+  // common.hpp is cheaper than a.hpp in every TU, but is more expensive in total
+  const auto headers = report.costliestHeaders(10);
+  REQUIRE(headers.size() == 2);
+  CHECK(headers[0].path == "common.hpp");
+  CHECK(headers[0].totalTime == 7);
+  CHECK(headers[0].numTUs == 2);
+  CHECK(headers[1].path == "a.hpp");
+  CHECK(headers[1].numTUs == 1);
+}
+
+TEST_CASE("The cost report is written as JSON") {
+  hdoc::indexer::TUCost tu = makeTU("a.cpp", 10);
+  tu.failed                = true;
+  tu.numFunctions          = 5;
+  tu.headers["a.hpp"]      = 2;
+
+  hdoc::indexer::CostReport report;
+  report.add(tu);
+
+  llvm::SmallString<128> tmpFile;
+  REQUIRE(!llvm::sys::fs::createTemporaryFile("hdoc-test-cost-report", "json", tmpFile));
+  REQUIRE(report.write(tmpFile.str().str(), 10));
+
+  auto buffer = llvm::MemoryBuffer::getFile(tmpFile);
+  REQUIRE(buffer);
+  auto parsed = llvm::json::parse((*buffer)->getBuffer());
+  REQUIRE(bool(parsed));
+
+  const llvm::json::Array& tus = *parsed->getAsObject()->getArray("slowestTUs");
+  REQUIRE(tus.size() == 1);
+  CHECK(*tus[0].getAsObject()->getString("path") == "a.cpp");
+  CHECK(*tus[0].getAsObject()->getBoolean("failed") == true);
+  CHECK(*tus[0].getAsObject()->getObject("matches")->getInteger("functions") == 5);
+
+  const llvm::json::Array& headers = *parsed->getAsObject()->getArray("costliestHeaders");
+  REQUIRE(headers.size() == 1);
+  CHECK(*headers[0].getAsObject()->getString("path") == "a.hpp");
+  CHECK(*headers[0].getAsObject()->getInteger("numTUs") == 1);
+
+  std::filesystem::remove(tmpFile.str().str());
+}
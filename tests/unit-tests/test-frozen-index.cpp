@@ -0,0 +1,110 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "serde/BinarySerde.hpp"
+#include "types/FrozenIndex.hpp"
+
+#include <string>
+#include <vector>
+
+static hdoc::types::RecordSymbol makeRecord(const uint64_t id, const std::string& name) {
+  hdoc::types::RecordSymbol s;
+  s.ID   = hdoc::types::SymbolID(id);
+  s.name = name;
+  return s;
+}
+
+TEST_CASE("Frozen database is sorted by name and finds every symbol") {
+  hdoc::types::Database<hdoc::types::RecordSymbol> db;
+  db.numMatches = 7;
+  // IDs that are equal modulo the table size collide in the open-addressing table
+  const std::vector<std::pair<uint64_t, std::string>> symbols = {
+      {1, "Zebra"}, {17, "Apple"}, {33, "Mango"}, {2, "Banana"}, {1024, "Apple"}, {0xFFFFFFFFFFFFFFFF, "Cherry"}};
+  for (const auto& [id, name] : symbols) {
+    db.update(hdoc::types::SymbolID(id), makeRecord(id, name));
+  }
+
+  const hdoc::types::FrozenDatabase<hdoc::types::RecordSymbol> frozen(db);
+  CHECK(frozen.numMatches == 7);
+  REQUIRE(frozen.size() == symbols.size());
+
+  std::vector<std::string> names;
+  for (const auto& s : frozen) {
+    names.emplace_back(s.name);
+  }
+  const std::vector<std::string> expected = {"Apple", "Apple", "Banana", "Cherry", "Mango", "Zebra"};
+  CHECK(names == expected);
+  CHECK(frozen.begin()->ID.raw() == 17);
+
+  for (const auto& [id, name] : symbols) {
+    REQUIRE(frozen.contains(hdoc::types::SymbolID(id)));
+    CHECK(frozen.at(hdoc::types::SymbolID(id))->name == name);
+  }
+  CHECK(frozen.find(hdoc::types::SymbolID(uint64_t(49))) == nullptr);
+  CHECK(frozen.contains(hdoc::types::SymbolID(uint64_t(3))) == false);
+}
+
+TEST_CASE("Frozen database returns subsets of symbols sorted by name") {
+  hdoc::types::Database<hdoc::types::RecordSymbol> db;
+  for (uint64_t id = 1; id <= 100; id++) {
+    db.update(hdoc::types::SymbolID(id), makeRecord(id, "Record" + std::to_string(1000 - id)));
+  }
+  const hdoc::types::FrozenDatabase<hdoc::types::RecordSymbol> frozen(std::move(db));
+
+  // SymbolIDs that aren't in the database are skipped
+  const auto sorted = frozen.sorted({hdoc::types::SymbolID(uint64_t(5)),
+                                     hdoc::types::SymbolID(uint64_t(500)),
+                                     hdoc::types::SymbolID(uint64_t(90)),
+                                     hdoc::types::SymbolID(uint64_t(42))});
+  REQUIRE(sorted.size() == 3);
+  CHECK(sorted[0]->name == "Record910");
+  CHECK(sorted[1]->name == "Record958");
+  CHECK(sorted[2]->name == "Record995");
+}
+
+TEST_CASE("Frozen database reads symbols from an encoded buffer") {
+  // Symbols are encoded in ID order, while their offsets are given in name order
+  const std::vector<std::string>                           names = {"Cherry", "Apple", "Banana"};
+  std::string                                              data;
+  hdoc::serde::BinaryWriter                                writer(data);
+  std::vector<std::pair<hdoc::types::SymbolID, uint64_t>> offsets(names.size());
+  for (uint64_t id = 1; id <= names.size(); id++) {
+    offsets[(id + 1) % 3] = {hdoc::types::SymbolID(id), data.size()};
+    writer.write(makeRecord(id, names[id - 1]));
+  }
+
+  const hdoc::types::FrozenDatabase<hdoc::types::RecordSymbol> frozen(
+      std::shared_ptr<llvm::MemoryBuffer>(llvm::MemoryBuffer::getMemBufferCopy(data)), offsets, 3);
+  CHECK(frozen.numMatches == 3);
+  REQUIRE(frozen.size() == 3);
+
+  std::vector<std::string> iterated;
+  for (const auto& s : frozen) {
+    iterated.emplace_back(s.name);
+  }
+  const std::vector<std::string> expected = {"Apple", "Banana", "Cherry"};
+  CHECK(iterated == expected);
+
+  CHECK(frozen.at(hdoc::types::SymbolID(uint64_t(1)))->name == "Cherry");
+  CHECK(frozen.contains(hdoc::types::SymbolID(uint64_t(2))));
+  CHECK(frozen.find(hdoc::types::SymbolID(uint64_t(4))) == nullptr);
+  CHECK_THROWS_AS(frozen.at(hdoc::types::SymbolID(uint64_t(4))), std::out_of_range);
+
+  // Symbols read from the buffer are owned by the caller
+  const auto sorted = frozen.sorted({hdoc::types::SymbolID(uint64_t(1)), hdoc::types::SymbolID(uint64_t(3))});
+  REQUIRE(sorted.size() == 2);
+  CHECK(sorted[0]->name == "Banana");
+  CHECK(sorted[1]->name == "Cherry");
+}
+
+TEST_CASE("Empty frozen database finds nothing") {
+  const hdoc::types::FrozenDatabase<hdoc::types::RecordSymbol> empty;
+  CHECK(empty.empty());
+  CHECK(empty.find(hdoc::types::SymbolID(uint64_t(1))) == nullptr);
+  CHECK(empty.sorted({hdoc::types::SymbolID(uint64_t(1))}).empty());
+
+  const hdoc::types::FrozenIndex index{hdoc::types::Index()};
+  CHECK(index.records.empty());
+  CHECK(index.functions.contains(hdoc::types::SymbolID(uint64_t(1))) == false);
+}
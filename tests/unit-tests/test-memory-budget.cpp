@@ -0,0 +1,82 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/MemoryBudget.hpp"
+#include "tests/TestUtils.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+
+/// Create source files of different sizes, returning the paths of the small one and the large one
+static std::pair<std::string, std::string> createSources(const TempProject& project) {
+  project.write("small.cpp", std::string(100, 'x'));
+  project.write("large.cpp", std::string(300, 'x'));
+  return {project.path("small.cpp").string(), project.path("large.cpp").string()};
+}
+
+TEST_CASE("TUs are admitted immediately without a budget") {
+  hdoc::indexer::MemoryBudget budget(0, "", 4);
+  CHECK(!budget.enabled());
+  CHECK(budget.admit("a.cpp") == 0);
+  CHECK(budget.admit("b.cpp") == 0);
+}
+
+TEST_CASE("TUs wait until their estimated memory fits in the budget") {
+  hdoc::indexer::MemoryBudget budget(1000, "", 2);
+  budget.residentMemory = [] { return uint64_t(0); };
+  budget.estimate({"a.cpp", "b.cpp", "c.cpp"});
+
+  // Nothing is known about the TUs, so each one is expected to use an equal share of the budget
+  const uint64_t a = budget.admit("a.cpp");
+  const uint64_t b = budget.admit("b.cpp");
+  CHECK(a == 500);
+  CHECK(b == 500);
+
+  std::atomic<bool> admitted = false;
+  std::thread       waiter([&] {
+    budget.release("c.cpp", budget.admit("c.cpp"), 0);
+    admitted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  CHECK(!admitted);
+
+  budget.release("a.cpp", a, 0);
+  waiter.join();
+  CHECK(admitted);
+  budget.release("b.cpp", b, 0);
+}
+
+TEST_CASE("A TU is admitted when nothing else is running, even if it exceeds the budget") {
+  hdoc::indexer::MemoryBudget budget(1000, "", 1);
+  budget.residentMemory = [] { return uint64_t(5000); };
+  budget.estimate({"a.cpp"});
+  const uint64_t reserved = budget.admit("a.cpp");
+  CHECK(reserved == 1000);
+  budget.release("a.cpp", reserved, 0);
+}
+
+TEST_CASE("Estimates are learned from the memory used by TUs, and persisted for the next run") {
+  const TempProject project;
+  const auto [small, large] = createSources(project);
+  {
+    hdoc::indexer::MemoryBudget budget(1'000'000, project.dir, 4);
+    budget.residentMemory = [] { return uint64_t(0); };
+    budget.estimate({small, large});
+
+    // The large file is estimated from how much memory each byte of the small file took
+    budget.release(small, budget.admit(small), 2000);
+    const uint64_t reserved = budget.admit(large);
+    CHECK(reserved == 6000);
+    budget.release(large, reserved, 9000);
+    budget.finish({small, large});
+  }
+
+  hdoc::indexer::MemoryBudget budget(1'000'000, project.dir, 4);
+  budget.residentMemory = [] { return uint64_t(0); };
+  budget.estimate({small, large});
+  CHECK(budget.admit(small) == 2000);
+  CHECK(budget.admit(large) == 9000);
+}
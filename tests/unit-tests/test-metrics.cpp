@@ -0,0 +1,81 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/Metrics.hpp"
+#include "types/MemoryUsage.hpp"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+TEST_CASE("Memory usage counts the heap allocations of every symbol") {
+  hdoc::types::Database<hdoc::types::EnumSymbol> db;
+  const hdoc::types::MemoryUsage                 empty = hdoc::types::memoryUsage(db);
+  CHECK(empty.strings == 0);
+  CHECK(empty.vectors == 0);
+
+  hdoc::types::EnumSymbol& e = db.reserve(hdoc::types::SymbolID(1));
+  e.name                     = "E";                    // Short enough to be stored inside the string
+  e.docComment               = std::string(1000, 'x'); // Allocated on the heap
+  e.members.resize(4);
+  e.members.shrink_to_fit();
+  e.members[0].docComment = std::string(500, 'y');
+
+  const hdoc::types::MemoryUsage usage = hdoc::types::memoryUsage(db);
+  CHECK(usage.strings >= 1500);
+  CHECK(usage.strings < 1600);
+  CHECK(usage.vectors == 4 * sizeof(hdoc::types::EnumMember));
+  CHECK(usage.maps >= sizeof(hdoc::types::EnumSymbol));
+  CHECK(usage.total() == usage.strings + usage.vectors + usage.maps);
+}
+
+TEST_CASE("Metrics are written as JSON with a record of each phase") {
+  hdoc::utils::Metrics metrics;
+  metrics.startPhase("ignored");
+  metrics.enable();
+  metrics.startPhase("first");
+  metrics.startPhase("second");
+  metrics.numTUsParsed = 3;
+  metrics.numTUsFailed = 1;
+  metrics.recordPage(100);
+  metrics.recordPage(50);
+  hdoc::types::MemoryUsage usage;
+  usage.strings = 10;
+  usage.vectors = 20;
+  usage.maps    = 30;
+  metrics.recordDatabase("functions", usage);
+  metrics.recordSpilledDatabase("records", 4096);
+
+  llvm::SmallString<128> tmpFile;
+  REQUIRE(!llvm::sys::fs::createTemporaryFile("hdoc-test-metrics", "json", tmpFile));
+  REQUIRE(metrics.write(tmpFile.str().str()));
+
+  auto buffer = llvm::MemoryBuffer::getFile(tmpFile);
+  REQUIRE(buffer);
+  auto parsed = llvm::json::parse((*buffer)->getBuffer());
+  REQUIRE(bool(parsed));
+  const llvm::json::Object& report = *parsed->getAsObject();
+
+  // Phases started before metrics were enabled aren't recorded
+  const llvm::json::Array& phases = *report.getArray("phases");
+  REQUIRE(phases.size() == 2);
+  CHECK(*phases[0].getAsObject()->getString("name") == "first");
+  CHECK(*phases[1].getAsObject()->getString("name") == "second");
+  CHECK(*phases[1].getAsObject()->getNumber("wallTimeMs") >= 0);
+  CHECK(*phases[1].getAsObject()->getInteger("peakRSSBytes") > 0);
+
+  CHECK(*report.getObject("tus")->getInteger("parsed") == 3);
+  CHECK(*report.getObject("tus")->getInteger("failed") == 1);
+  CHECK(*report.getObject("output")->getInteger("htmlPages") == 2);
+  CHECK(*report.getObject("output")->getInteger("htmlBytes") == 150);
+  CHECK(*report.getObject("databases")->getObject("functions")->getInteger("totalBytes") == 60);
+  CHECK(*report.getObject("databases")->getObject("records")->getBoolean("spilled") == true);
+  CHECK(*report.getObject("databases")->getObject("records")->getInteger("diskBytes") == 4096);
+
+  std::filesystem::remove(tmpFile.str().str());
+}
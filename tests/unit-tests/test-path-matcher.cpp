@@ -0,0 +1,61 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/PathMatcher.hpp"
+
+#include <string>
+#include <vector>
+
+TEST_CASE("Path matcher without patterns matches nothing") {
+  const hdoc::utils::PathMatcher matcher;
+  CHECK(matcher.empty());
+  CHECK(matcher.matches("src/main.cpp") == false);
+  CHECK(matcher.matches("") == false);
+}
+
+TEST_CASE("Path matcher finds substrings like std::string::find") {
+  const std::vector<std::string> patterns = {"tests/", "third_party", "_autogenerated", "he", "she", "hers"};
+  const hdoc::utils::PathMatcher matcher(patterns);
+  CHECK(matcher.patterns() == patterns);
+
+  const std::vector<std::string> paths = {"src/tests/foo.cpp",
+                                          "tests",
+                                          "include/third_party/lib.hpp",
+                                          "src/interface_autogenerated.cpp",
+                                          "src/interface_autogen.cpp",
+                                          "ushers.hpp",
+                                          "xhx/sxe/h",
+                                          "she",
+                                          "",
+                                          "src/main.cpp"};
+  for (const auto& path : paths) {
+    bool expected = false;
+    for (const auto& pattern : patterns) {
+      expected = expected || path.find(pattern) != std::string::npos;
+    }
+    CHECK_MESSAGE(matcher.matches(path) == expected, path);
+  }
+}
+
+TEST_CASE("Path matcher with an empty pattern matches everything") {
+  const hdoc::utils::PathMatcher matcher{"", "detail/"};
+  CHECK(matcher.matches("src/main.cpp"));
+  CHECK(matcher.matches(""));
+}
+
+TEST_CASE("Path matcher globs must match the entire path") {
+  const hdoc::utils::PathMatcher matcher{"third_party/*/generated/*", "*.pb.h", "detail/"};
+  CHECK(matcher.matches("third_party/lib/generated/api.hpp"));
+  CHECK(matcher.matches("src/proto/message.pb.h"));
+  CHECK(matcher.matches("include/detail/impl.hpp"));
+  CHECK(matcher.matches("src/third_party/lib/generated/api.hpp") == false);
+  CHECK(matcher.matches("third_party/lib/api.hpp") == false);
+  CHECK(matcher.matches("src/proto/message.pb.cc") == false);
+}
+
+TEST_CASE("Path matcher treats invalid globs as substrings") {
+  const hdoc::utils::PathMatcher matcher{"[z-a"};
+  CHECK(matcher.matches("src/[z-a/main.cpp"));
+  CHECK(matcher.matches("src/main.cpp") == false);
+}
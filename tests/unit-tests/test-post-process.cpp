@@ -0,0 +1,131 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "indexer/PostProcess.hpp"
+
+#include "llvm/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+/// Build an Index with a tree of numNamespaces namespaces, each with a few records and one enum
+static hdoc::types::Index buildIndex(const uint64_t numNamespaces) {
+  hdoc::types::Index index;
+  uint64_t           nextID = numNamespaces + 1;
+  for (uint64_t i = 1; i <= numNamespaces; i++) {
+    auto& ns             = index.namespaces.reserve(hdoc::types::SymbolID(i));
+    ns.ID                = hdoc::types::SymbolID(i);
+    ns.parentNamespaceID = hdoc::types::SymbolID(i / 2);
+    for (uint64_t j = 0; j < 4; j++) {
+      auto& r             = index.records.reserve(hdoc::types::SymbolID(nextID));
+      r.ID                = hdoc::types::SymbolID(nextID++);
+      r.parentNamespaceID = ns.ID;
+    }
+    auto& e             = index.enums.reserve(hdoc::types::SymbolID(nextID));
+    e.ID                = hdoc::types::SymbolID(nextID++);
+    e.parentNamespaceID = ns.ID;
+  }
+  return index;
+}
+
+/// Post-process an Index with numNamespaces namespaces, returning the stats and how long it took in milliseconds
+static std::pair<hdoc::indexer::PostProcessStats, double> postProcessNamespaces(const uint64_t    numNamespaces,
+                                                                                llvm::ThreadPool& pool) {
+  hdoc::types::Index index = buildIndex(numNamespaces);
+  const auto         start = std::chrono::steady_clock::now();
+  const auto         stats = hdoc::indexer::postProcess(index, pool);
+  return {stats, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+}
+
+TEST_CASE("Namespaces are resolved to their direct children") {
+  llvm::ThreadPool   pool;
+  hdoc::types::Index index = buildIndex(7);
+
+  // A record whose parent isn't a namespace, such as a nested record, isn't added to any namespace
+  auto& nested             = index.records.reserve(hdoc::types::SymbolID(uint64_t(1000)));
+  nested.ID                = hdoc::types::SymbolID(uint64_t(1000));
+  nested.parentNamespaceID = hdoc::types::SymbolID(uint64_t(8));
+  hdoc::indexer::postProcess(index, pool);
+
+  uint64_t numRecords = 0;
+  for (const auto& [id, ns] : index.namespaces.entries) {
+    CHECK(ns.records.size() == 4);
+    CHECK(ns.enums.size() == 1);
+    for (const auto& child : ns.records) {
+      CHECK(index.records.entries.at(child).parentNamespaceID == id);
+    }
+    numRecords += ns.records.size();
+  }
+  CHECK(numRecords == 28);
+
+  // Namespace i is the parent of namespaces 2i and 2i + 1
+  auto childNamespaces = index.namespaces.entries.at(hdoc::types::SymbolID(uint64_t(1))).namespaces;
+  std::sort(childNamespaces.begin(), childNamespaces.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.raw() < rhs.raw();
+  });
+  const std::vector<hdoc::types::SymbolID> expected = {hdoc::types::SymbolID(uint64_t(2)),
+                                                       hdoc::types::SymbolID(uint64_t(3))};
+  CHECK(childNamespaces == expected);
+  CHECK(index.namespaces.entries.at(hdoc::types::SymbolID(uint64_t(7))).namespaces.empty());
+}
+
+TEST_CASE("Post-processing scales linearly with the number of namespaces") {
+  llvm::ThreadPool pool;
+  const auto [small, smallTime] = postProcessNamespaces(8000, pool);
+  const auto [large, largeTime] = postProcessNamespaces(32000, pool);
+  MESSAGE("Post-processed 8000 namespaces in ", smallTime, " ms and 32000 namespaces in ", largeTime, " ms");
+
+  // Every namespace has 4 records and an enum, and each symbol is visited once and looks up its parent namespace
+  // once, however many symbols there are. Timings are too noisy to check in a test.
+  CHECK(small.numVisited == 8000 * 6);
+  CHECK(small.numLookups == 8000 * 6);
+  CHECK(large.numVisited == 32000 * 6);
+  CHECK(large.numLookups == 32000 * 6);
+}
+
+TEST_CASE("Post-processing prunes orphaned methods and dangling TypeRefs") {
+  llvm::ThreadPool            pool;
+  hdoc::types::Index          index;
+  const hdoc::types::SymbolID recordID(uint64_t(1));
+  const hdoc::types::SymbolID baseID(uint64_t(2));
+  const hdoc::types::SymbolID missingID(uint64_t(3));
+
+  auto& record = index.records.reserve(recordID);
+  record.ID    = recordID;
+  record.proto = "struct Derived";
+  record.baseRecords.push_back({baseID, clang::AS_public, "Base"});
+  record.baseRecords.push_back({missingID, clang::AS_private, "std::string"});
+  record.vars.push_back({});
+  record.vars[0].type = {missingID, "std::string"};
+  auto& base          = index.records.reserve(baseID);
+  base.ID             = baseID;
+  base.proto          = "struct Base";
+
+  auto& method             = index.functions.reserve(hdoc::types::SymbolID(uint64_t(10)));
+  method.isRecordMember    = true;
+  method.parentNamespaceID = recordID;
+  method.returnType        = {baseID, "Base"};
+  method.params.push_back({});
+  method.params[0].type = {missingID, "std::string"};
+
+  auto& orphan             = index.functions.reserve(hdoc::types::SymbolID(uint64_t(11)));
+  orphan.isRecordMember    = true;
+  orphan.parentNamespaceID = missingID;
+
+  const auto stats = hdoc::indexer::postProcess(index, pool);
+  CHECK(stats.numPrunedMethods == 1);
+  CHECK(index.functions.entries.size() == 1);
+  CHECK(index.functions.contains(hdoc::types::SymbolID(uint64_t(11))) == false);
+
+  const auto& f = index.functions.entries.at(hdoc::types::SymbolID(uint64_t(10)));
+  CHECK(f.returnType.id == baseID);
+  CHECK(f.params[0].type.id.raw() == 0);
+  CHECK(f.params[0].type.name == "std::string");
+
+  const auto& r = index.records.entries.at(recordID);
+  CHECK(r.vars[0].type.id.raw() == 0);
+  CHECK(r.proto == "struct Derived : public Base, private std::string");
+  CHECK(index.records.entries.at(baseID).proto == "struct Base");
+}
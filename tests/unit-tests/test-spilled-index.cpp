@@ -0,0 +1,174 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "indexer/SpilledIndex.hpp"
+
+#include "llvm/Support/ThreadPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static hdoc::types::RecordSymbol& addRecord(hdoc::types::Index& index, const uint64_t id, const std::string& name) {
+  auto& r = index.records.reserve(hdoc::types::SymbolID(id));
+  r.ID    = hdoc::types::SymbolID(id);
+  r.name  = name;
+  r.proto = "struct " + name;
+  return r;
+}
+
+static void addNamespace(hdoc::types::Index&          index,
+                         const uint64_t               id,
+                         const std::string&           name,
+                         const hdoc::types::SymbolID& parent) {
+  auto& n             = index.namespaces.reserve(hdoc::types::SymbolID(id));
+  n.ID                = hdoc::types::SymbolID(id);
+  n.name              = name;
+  n.parentNamespaceID = parent;
+}
+
+/// Create a SpilledIndex that spills every Index it's asked about
+static std::unique_ptr<hdoc::indexer::SpilledIndex> makeSpilledIndex() {
+  auto spilled              = std::make_unique<hdoc::indexer::SpilledIndex>(1, "");
+  spilled->residentMemory   = [] { return uint64_t(2); };
+  spilled->minSymbolsPerRun = 1;
+  REQUIRE(spilled->enabled());
+  return spilled;
+}
+
+TEST_CASE("Nothing is spilled when spilling is disabled or memory is under the threshold") {
+  hdoc::types::Index index;
+  addRecord(index, 1, "Record");
+
+  hdoc::indexer::SpilledIndex disabled(0, "");
+  CHECK(!disabled.enabled());
+  CHECK(!disabled.shouldSpill(index));
+
+  hdoc::indexer::SpilledIndex spilled(1000, "");
+  spilled.residentMemory   = [] { return uint64_t(999); };
+  spilled.minSymbolsPerRun = 1;
+  CHECK(!spilled.shouldSpill(index));
+  spilled.residentMemory = [] { return uint64_t(1000); };
+  CHECK(spilled.shouldSpill(index));
+
+  // Small Indexes aren't worth spilling, whatever the memory usage
+  spilled.minSymbolsPerRun = 2;
+  CHECK(!spilled.shouldSpill(index));
+}
+
+TEST_CASE("Runs are merged with the symbols in memory, keeping the earliest copy of each symbol") {
+  llvm::ThreadPool pool;
+  auto             spilled = makeSpilledIndex();
+
+  hdoc::types::Index first;
+  first.records.numMatches = 2;
+  addRecord(first, 1, "First");
+  addRecord(first, 4, "Delta");
+  REQUIRE(spilled->shouldSpill(first));
+  REQUIRE(spilled->spill(first));
+  CHECK(first.records.entries.empty());
+  CHECK(first.records.numMatches == 2);
+
+  hdoc::types::Index second;
+  second.records.numMatches = 2;
+  addRecord(second, 1, "Second");
+  addRecord(second, 2, "Bravo");
+  REQUIRE(spilled->spill(second));
+  CHECK(spilled->numRuns() == 2);
+  CHECK(spilled->spilled());
+  CHECK(spilled->numBytesSpilled > 0);
+
+  // Symbols that are still in memory were indexed after every run
+  hdoc::types::Index index;
+  index.records.numMatches = 6;
+  addRecord(index, 1, "Third");
+  addRecord(index, 3, "Charlie");
+  spilled->postProcess(index, pool);
+  CHECK(index.records.entries.empty());
+
+  const hdoc::types::FrozenIndex frozen = spilled->freeze();
+  CHECK(frozen.records.numMatches == 6);
+  REQUIRE(frozen.records.size() == 4);
+  CHECK(frozen.records.at(hdoc::types::SymbolID(uint64_t(1)))->name == "First");
+
+  std::vector<std::string> names;
+  for (const auto& r : frozen.records) {
+    names.emplace_back(r.name);
+  }
+  const std::vector<std::string> expected = {"Bravo", "Charlie", "Delta", "First"};
+  CHECK(names == expected);
+}
+
+TEST_CASE("Spilled symbols are post-processed like symbols in memory") {
+  llvm::ThreadPool            pool;
+  auto                        spilled = makeSpilledIndex();
+  const hdoc::types::SymbolID namespaceID(uint64_t(100));
+  const hdoc::types::SymbolID innerID(uint64_t(101));
+  const hdoc::types::SymbolID recordID(uint64_t(1));
+  const hdoc::types::SymbolID baseID(uint64_t(2));
+  const hdoc::types::SymbolID missingID(uint64_t(3));
+
+  // The namespaces and the records are spilled in different runs from the symbols that refer to them
+  hdoc::types::Index namespaces;
+  addNamespace(namespaces, namespaceID.raw(), "ns", hdoc::types::SymbolID());
+  addNamespace(namespaces, innerID.raw(), "inner", namespaceID);
+  auto& e             = namespaces.enums.reserve(hdoc::types::SymbolID(uint64_t(20)));
+  e.ID                = hdoc::types::SymbolID(uint64_t(20));
+  e.name              = "Enum";
+  e.parentNamespaceID = innerID;
+  REQUIRE(spilled->spill(namespaces));
+
+  hdoc::types::Index records;
+  auto&              record = addRecord(records, recordID.raw(), "Derived");
+  record.parentNamespaceID  = namespaceID;
+  record.baseRecords.push_back({baseID, clang::AS_public, "Base"});
+  record.baseRecords.push_back({missingID, clang::AS_private, "std::string"});
+  record.vars.push_back({});
+  record.vars[0].type = {missingID, "std::string"};
+  addRecord(records, baseID.raw(), "Base");
+  REQUIRE(spilled->spill(records));
+
+  hdoc::types::Index functions;
+  auto&              method = functions.functions.reserve(hdoc::types::SymbolID(uint64_t(10)));
+  method.ID                 = hdoc::types::SymbolID(uint64_t(10));
+  method.isRecordMember     = true;
+  method.parentNamespaceID  = recordID;
+  method.returnType         = {baseID, "Base"};
+  method.params.push_back({});
+  method.params[0].type = {missingID, "std::string"};
+
+  auto& orphan             = functions.functions.reserve(hdoc::types::SymbolID(uint64_t(11)));
+  orphan.ID                = hdoc::types::SymbolID(uint64_t(11));
+  orphan.isRecordMember    = true;
+  orphan.parentNamespaceID = missingID;
+  REQUIRE(spilled->spill(functions));
+
+  hdoc::types::Index index;
+  const auto         stats = spilled->postProcess(index, pool);
+  CHECK(stats.numPrunedMethods == 1);
+  CHECK(spilled->functions.numBytes > 0);
+
+  const hdoc::types::FrozenIndex frozen = spilled->freeze();
+  REQUIRE(frozen.functions.size() == 1);
+  CHECK(!frozen.functions.contains(hdoc::types::SymbolID(uint64_t(11))));
+  const auto f = frozen.functions.at(hdoc::types::SymbolID(uint64_t(10)));
+  CHECK(f->returnType.id == baseID);
+  CHECK(f->params[0].type.id.raw() == 0);
+  CHECK(f->params[0].type.name == "std::string");
+
+  const auto r = frozen.records.at(recordID);
+  CHECK(r->vars[0].type.id.raw() == 0);
+  CHECK(r->proto == "struct Derived : public Base, private std::string");
+  CHECK(frozen.records.at(baseID)->proto == "struct Base");
+
+  // Children are added to their namespaces even though they were spilled in a different run
+  const auto root = frozen.namespaces.at(namespaceID);
+  REQUIRE(root->records.size() == 1);
+  CHECK(root->records[0] == recordID);
+  REQUIRE(root->namespaces.size() == 1);
+  CHECK(root->namespaces[0] == innerID);
+  const auto inner = frozen.namespaces.at(innerID);
+  REQUIRE(inner->enums.size() == 1);
+  CHECK(inner->enums[0].raw() == 20);
+}
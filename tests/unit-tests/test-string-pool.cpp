@@ -0,0 +1,82 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "types/StringPool.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Interned strings with the same contents share storage") {
+  const std::string                 path = "include/project/module.hpp";
+  const hdoc::types::InternedString a(path);
+  const hdoc::types::InternedString b("include/project/module.hpp");
+  const hdoc::types::InternedString c("include/project/other.hpp");
+
+  CHECK(a == b);
+  CHECK(a.data() == b.data());
+  CHECK(a.data() != path.data());
+  CHECK((a == c) == false);
+  CHECK(a == path);
+  CHECK(a == "include/project/module.hpp");
+  CHECK(a.str() == path);
+  CHECK(a.size() == path.size());
+}
+
+TEST_CASE("Empty interned strings aren't stored in the pool") {
+  const auto                        numUnique = hdoc::types::StringPool::global().numUnique.load();
+  const hdoc::types::InternedString empty;
+  const hdoc::types::InternedString alsoEmpty("");
+
+  CHECK(empty.empty());
+  CHECK(empty == alsoEmpty);
+  CHECK(empty == "");
+  CHECK(std::string(empty.data()) == "");
+  CHECK(hdoc::types::StringPool::global().numUnique == numUnique);
+}
+
+TEST_CASE("Strings interned concurrently from many threads are stored once") {
+  auto&      pool      = hdoc::types::StringPool::global();
+  const auto numUnique = pool.numUnique.load();
+
+  constexpr size_t                                      numThreads = 8;
+  constexpr size_t                                      numStrings = 1000;
+  std::vector<std::vector<hdoc::types::InternedString>> results(numThreads);
+  std::vector<std::thread>                              threads;
+  for (size_t t = 0; t < numThreads; t++) {
+    threads.emplace_back([&results, t]() {
+      for (size_t i = 0; i < numStrings; i++) {
+        results[t].emplace_back("std::vector<concurrent_type_" + std::to_string(i) + ">");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  CHECK(pool.numUnique - numUnique == numStrings);
+  for (size_t t = 1; t < numThreads; t++) {
+    for (size_t i = 0; i < numStrings; i++) {
+      CHECK(results[t][i].data() == results[0][i].data());
+    }
+  }
+  CHECK(pool.bytesSaved() > 0);
+}
+
+TEST_CASE("Bytes saved by interning account for references and for strings stored inline") {
+  hdoc::types::StringPool pool;
+
+  // A short string that isn't repeated was stored inline in its std::string, so interning it only costs memory
+  pool.intern("int");
+  CHECK(pool.bytesSaved() < 0);
+
+  // Each repeat of a long string saves its heap copy, but still needs a reference to the pooled copy
+  const std::string path(100, 'x');
+  pool.intern(path);
+  pool.intern(path);
+  const int64_t saved = pool.bytesSaved();
+  pool.intern(path);
+  const int64_t expected = sizeof(std::string) - sizeof(llvm::StringRef) + path.size() + 1;
+  CHECK(pool.bytesSaved() - saved == expected);
+}
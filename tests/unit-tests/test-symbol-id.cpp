@@ -0,0 +1,84 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "types/SymbolIDTable.hpp"
+#include "types/Symbols.hpp"
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/// Build a corpus of USRs that look like the ones clang generates for a large codebase
+static std::vector<std::string> buildUSRCorpus(const size_t size) {
+  std::vector<std::string> usrs;
+  usrs.reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    const std::string ns     = "c:@N@project@N@module" + std::to_string(i % 97);
+    const std::string record = ns + "@S@Record" + std::to_string(i / 16);
+    switch (i % 4) {
+    case 0:
+      usrs.emplace_back(record);
+      break;
+    case 1:
+      usrs.emplace_back(record + "@F@method" + std::to_string(i) + "#I#&1$@N@std@S@basic_string>#C");
+      break;
+    case 2:
+      usrs.emplace_back(ns + "@F@function" + std::to_string(i) + "#*1C#l#");
+      break;
+    default:
+      usrs.emplace_back(ns + "@E@Enum" + std::to_string(i));
+      break;
+    }
+  }
+  return usrs;
+}
+
+/// Hash every USR in the corpus, returning the number of distinct SymbolIDs and the time taken in milliseconds
+template <typename HashFn>
+static std::pair<size_t, double> hashCorpus(const std::vector<std::string>& usrs, HashFn fn) {
+  std::vector<uint64_t> ids;
+  ids.reserve(usrs.size());
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& usr : usrs) {
+    ids.emplace_back(fn(usr));
+  }
+  const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return {std::unordered_set<uint64_t>(ids.begin(), ids.end()).size(), elapsed};
+}
+
+TEST_CASE("SymbolID hash functions are stable") {
+  // Symbol URLs are built from SymbolIDs, so changing these values breaks links to existing documentation
+  CHECK(hdoc::types::SymbolID::hashSHA1("c:@F@main#") == 0x3017d418e3ee7259);
+  CHECK(hdoc::types::SymbolID::hashXXH64("c:@F@main#") == 0x8ee1ab9c21451584);
+}
+
+TEST_CASE("Benchmark SymbolID hash functions on a USR corpus") {
+  const std::vector<std::string> usrs = buildUSRCorpus(200000);
+
+  const auto [sha1Unique, sha1Time]   = hashCorpus(usrs, hdoc::types::SymbolID::hashSHA1);
+  const auto [xxh64Unique, xxh64Time] = hashCorpus(usrs, hdoc::types::SymbolID::hashXXH64);
+  MESSAGE("Hashed ", usrs.size(), " USRs: SHA1 took ", sha1Time, " ms, xxHash64 took ", xxh64Time, " ms");
+
+  // The corpus is far too small for a 64-bit hash to have any collisions by chance
+  CHECK(sha1Unique == usrs.size());
+  CHECK(xxh64Unique == usrs.size());
+}
+
+TEST_CASE("SymbolIDTable reports SymbolIDs built from different USRs") {
+  hdoc::types::SymbolIDTable table;
+  const hdoc::types::SymbolID id(uint64_t(42));
+  std::string                 otherUSR;
+
+  CHECK(table.check(id, "c:@S@A", otherUSR));
+  CHECK(table.check(id, "c:@S@A", otherUSR));
+  CHECK(table.check(hdoc::types::SymbolID(uint64_t(43)), "c:@S@B", otherUSR));
+  CHECK(otherUSR.empty());
+  CHECK(table.numCollisions == 0);
+
+  CHECK(table.check(id, "c:@S@C", otherUSR) == false);
+  CHECK(otherUSR == "c:@S@A");
+  CHECK(table.numCollisions == 1);
+  CHECK(table.size() == 2);
+}
@@ -0,0 +1,70 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/Trace.hpp"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+
+TEST_CASE("Trace scopes aren't recorded unless tracing is enabled") {
+  const size_t before = hdoc::utils::TraceRecorder::global().size();
+  { hdoc::utils::TraceScope trace("Disabled", "detail"); }
+  CHECK(hdoc::utils::TraceRecorder::global().size() == before);
+}
+
+TEST_CASE("Trace events from each thread are written to their own lane") {
+  hdoc::utils::TraceRecorder recorder;
+  recorder.enable();
+  const auto now = hdoc::utils::TraceRecorder::Clock::now();
+  recorder.record("Main event", "", now, now + std::chrono::milliseconds(2));
+  std::thread worker([&]() { recorder.record("Worker event", "a.cpp", now, now + std::chrono::milliseconds(1)); });
+  worker.join();
+  CHECK(recorder.size() == 2);
+
+  llvm::SmallString<128> tmpFile;
+  REQUIRE(!llvm::sys::fs::createTemporaryFile("hdoc-test-trace", "json", tmpFile));
+  REQUIRE(recorder.write(tmpFile.str().str()));
+
+  auto buffer = llvm::MemoryBuffer::getFile(tmpFile);
+  REQUIRE(buffer);
+  auto parsed = llvm::json::parse((*buffer)->getBuffer());
+  REQUIRE(bool(parsed));
+  const llvm::json::Array* events = parsed->getAsObject()->getArray("traceEvents");
+  REQUIRE(events != nullptr);
+
+  // One metadata event naming each lane, and one complete event per recorded event
+  std::set<int64_t>     tids;
+  std::set<std::string> laneNames;
+  uint32_t              numComplete = 0;
+  for (const auto& e : *events) {
+    const llvm::json::Object& event = *e.getAsObject();
+    tids.insert(*event.getInteger("tid"));
+    if (*event.getString("ph") == "M") {
+      laneNames.insert(event.getObject("args")->getString("name")->str());
+      continue;
+    }
+    numComplete += 1;
+    CHECK(*event.getString("ph") == "X");
+    if (*event.getString("name") == "Worker event") {
+      CHECK(*event.getInteger("dur") == 1000);
+      CHECK(*event.getObject("args")->getString("detail") == "a.cpp");
+    } else {
+      CHECK(*event.getString("name") == "Main event");
+      CHECK(*event.getInteger("dur") == 2000);
+      CHECK(event.getObject("args") == nullptr);
+    }
+  }
+  CHECK(numComplete == 2);
+  CHECK(tids.size() == 2);
+  CHECK(laneNames.count("main") == 1);
+  CHECK(laneNames.size() == 2);
+
+  std::filesystem::remove(tmpFile.str().str());
+}
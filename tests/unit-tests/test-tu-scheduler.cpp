@@ -0,0 +1,49 @@
+// Copyright 2019-2023 hdoc
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include "doctest.h"
+#include "support/TUScheduler.hpp"
+#include "tests/TestUtils.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// Create files of 10, 1000, and 100 bytes in project, returning their paths in that order
+static std::vector<std::string> createFiles(const TempProject& project) {
+  std::vector<std::string> files;
+  for (const size_t size : {10, 1000, 100}) {
+    const std::string name = "file-" + std::to_string(size) + ".cpp";
+    project.write(name, std::string(size, ' '));
+    files.emplace_back(project.path(name).string());
+  }
+  return files;
+}
+
+TEST_CASE("TUs without previous parse times are scheduled largest first") {
+  const TempProject              project;
+  const std::vector<std::string> files = createFiles(project);
+
+  hdoc::indexer::TUScheduler     scheduler("");
+  const std::vector<std::string> order = scheduler.schedule(files);
+  CHECK(order == std::vector<std::string>{files[1], files[2], files[0]});
+}
+
+TEST_CASE("TUs are scheduled using the parse times from the previous run") {
+  const TempProject              project;
+  const std::vector<std::string> files = createFiles(project);
+
+  // The smallest file is the slowest to parse
+  {
+    hdoc::indexer::TUScheduler scheduler(project.dir);
+    const auto                 order = scheduler.schedule(files);
+    scheduler.record(files[0], std::chrono::seconds(3));
+    scheduler.record(files[1], std::chrono::seconds(2));
+    scheduler.record(files[2], std::chrono::seconds(1));
+    scheduler.finish(files, order, 2);
+  }
+  REQUIRE(std::filesystem::exists(project.dir / "tu-timings"));
+
+  hdoc::indexer::TUScheduler scheduler(project.dir);
+  CHECK(scheduler.schedule(files) == files);
+}